@@ -17,7 +17,7 @@ endif()
 function(rift_target_enable_CPP20 target)
     set_target_properties (${target} PROPERTIES CXX_STANDARD 20)
     if(COMPILER_GCC)
-        set_target_properties(${target} PROPERTIES COMPILE_FLAGS "-fconcepts")
+        set_target_properties(${target} PROPERTIES COMPILE_FLAGS "-fconcepts -fcoroutines")
     endif()
 endfunction()
 
@@ -4,6 +4,8 @@
 #include "AssetInfo.h"
 #include "CoreObject.h"
 
+#include <future>
+
 
 namespace Rift
 {
@@ -23,12 +25,26 @@ namespace Rift
 		bool OnLoad(const AssetInfo& inInfo, Json& data);
 
 
+		/** Saves the asset into path. Waits until it is written */
 		bool SaveToPath(const Name& path);
 
+		/** Saves the asset into its path. Waits until it is written */
 		bool Save();
 
+		/**
+		 * Serializes the asset and queues it to be written in the background.
+		 * @return false once written if it failed
+		 */
+		std::shared_future<bool> SaveAsync();
+
 
 	protected:
+		/** Serializes the asset with its type, as it is saved */
+		void SerializeForSave(JsonArchive& ar);
+
+		/** Queues the asset to be saved into path, if it is a file inside an existing folder */
+		std::shared_future<bool> QueueSave(const Name& path);
+
 		/** Called after the asset was loaded or created */
 		virtual bool PostLoad()
 		{
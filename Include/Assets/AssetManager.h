@@ -5,6 +5,7 @@
 #include "AssetInfo.h"
 #include "Containers/Map.h"
 #include "CoreObject.h"
+#include "Files/DirectoryCrawler.h"
 #include "Files/FileSystem.h"
 
 
@@ -22,6 +23,8 @@ namespace Rift
 
 		TMap<AssetInfo, ObjectPtr<AssetData>> loadedAssets{};
 
+		DirectoryCrawler crawler;
+
 
 	public:
 		CORE_API Ptr<AssetData> Load(AssetInfo info);
@@ -29,6 +32,12 @@ namespace Rift
 
 		CORE_API Ptr<AssetData> LoadOrCreate(const AssetInfo& info, Refl::Class* assetType);
 
+		/**
+		 * Finds assets in a folder using all workers. Folders not modified since the last search
+		 * are not listed again
+		 */
+		CORE_API TArray<AssetInfo> FindAssets(const Path& folder, bool bRecursive = true);
+
 		CORE_API Ptr<AssetData> GetLoadedAsset(const AssetInfo& id) const
 		{
 			if (const auto* asset = loadedAssets.Find(id))
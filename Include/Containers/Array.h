@@ -249,6 +249,24 @@ namespace Rift
 			return false;
 		}
 
+		/**
+		 * Delete count items starting at index
+		 * @return true if removed
+		 */
+		bool RemoveAt(i32 index, i32 count, const bool shouldShrink = true)
+		{
+			if (count > 0 && IsValidIndex(index) && IsValidIndex(index + count - 1))
+			{
+				vector.erase(vector.begin() + index, vector.begin() + index + count);
+
+				if (shouldShrink)
+					Shrink();
+
+				return true;
+			}
+			return false;
+		}
+
 		/**
 		 * Delete item at index. Doesn't preserve order but its considerably faster
 		 * @return true if removed
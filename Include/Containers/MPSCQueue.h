@@ -0,0 +1,92 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Misc/Utility.h"
+
+#include <atomic>
+
+
+namespace Rift
+{
+	/**
+	 * Unbounded queue where any thread can push and a single thread consumes.
+	 * Pushing is lock-free. The consumer takes everything pushed so far at once, so items pushed
+	 * while it processes them wait for the next call.
+	 */
+	template <typename Type>
+	class TMPSCQueue
+	{
+		struct Node
+		{
+			Type value;
+			Node* next = nullptr;
+		};
+
+		// Last pushed node. Nodes link to the ones pushed before them
+		std::atomic<Node*> head{nullptr};
+
+
+	public:
+		TMPSCQueue() = default;
+		TMPSCQueue(const TMPSCQueue&) = delete;
+		TMPSCQueue& operator=(const TMPSCQueue&) = delete;
+		~TMPSCQueue()
+		{
+			Node* node = head.exchange(nullptr, std::memory_order_acquire);
+			while (node)
+			{
+				Node* const next = node->next;
+				delete node;
+				node = next;
+			}
+		}
+
+		void Push(Type&& value)
+		{
+			Node* const node = new Node{Move(value), head.load(std::memory_order_relaxed)};
+			while (!head.compare_exchange_weak(
+			    node->next, node, std::memory_order_release, std::memory_order_relaxed))
+			{}
+		}
+
+		/**
+		 * Moves all pushed items to the end of items, in the order they were pushed.
+		 * Only called from the consumer thread.
+		 * @return number of items taken
+		 */
+		i32 PopAll(TArray<Type>& items)
+		{
+			Node* node = head.exchange(nullptr, std::memory_order_acquire);
+			if (!node)
+			{
+				return 0;
+			}
+
+			// Nodes are linked newest first
+			const i32 first = items.Size();
+			i32 count       = 0;
+			for (Node* it = node; it; it = it->next)
+			{
+				++count;
+			}
+			items.Resize(first + count);
+			for (i32 i = first + count - 1; i >= first; --i)
+			{
+				items[i]         = Move(node->value);
+				Node* const next = node->next;
+				delete node;
+				node = next;
+			}
+			return count;
+		}
+
+		bool IsEmpty() const
+		{
+			return head.load(std::memory_order_relaxed) == nullptr;
+		}
+	};
+}    // namespace Rift
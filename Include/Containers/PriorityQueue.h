@@ -0,0 +1,340 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Math/Heap.h"
+#include "Misc/Utility.h"
+
+#include <cassert>
+
+
+namespace Rift
+{
+	/**
+	 * Priority queue backed by a TArray heap.
+	 * Top() is always the element for which Predicate(top, other) holds against all others.
+	 * With the default Less predicate, the smallest element is on top.
+	 *
+	 * @param Arity children per heap node. 2 is a binary heap. 4 gives a shallower heap whose
+	 * children share cache lines, usually faster for large queues with many pops.
+	 */
+	template <typename Type, typename Predicate = Less, u32 Arity = 2,
+	    typename Allocator = Memory::DefaultAllocator>
+	class TPriorityQueue
+	{
+	public:
+		using ItemType = Type;
+
+
+	private:
+		TArray<Type, Allocator> heap;
+		Predicate predicate{};
+
+
+	public:
+		TPriorityQueue() = default;
+		explicit TPriorityQueue(Predicate predicate) : predicate{Move(predicate)} {}
+
+		/** Builds the queue from existing items in O(n) */
+		explicit TPriorityQueue(TArray<Type, Allocator>&& items, Predicate predicate = {})
+		    : heap{Move(items)}
+		    , predicate{Move(predicate)}
+		{
+			Algorithms::Heapify<Arity>(heap.Data(), heap.Size(), this->predicate);
+		}
+
+		void Push(Type&& item)
+		{
+			const i32 index = heap.Add(Move(item));
+			Algorithms::HeapSiftUp<Arity>(heap.Data(), 0, index, predicate);
+		}
+
+		void Push(const Type& item)
+		{
+			const i32 index = heap.Add(item);
+			Algorithms::HeapSiftUp<Arity>(heap.Data(), 0, index, predicate);
+		}
+
+		/** Removes the top element and returns it. Queue can't be empty */
+		Type Pop()
+		{
+			assert(!IsEmpty() && "Can't pop from an empty priority queue");
+			Type top = Move(heap.First());
+			heap.RemoveAtSwap(0, false);
+			if (heap.Size() > 1)
+			{
+				Algorithms::HeapSiftDown<Arity>(heap.Data(), 0, heap.Size(), predicate);
+			}
+			return Move(top);
+		}
+
+		const Type& Top() const
+		{
+			assert(!IsEmpty() && "Can't get the top of an empty priority queue");
+			return heap.First();
+		}
+
+		void Reserve(i32 sizeNum)
+		{
+			heap.Reserve(sizeNum);
+		}
+
+		/** Empty the queue.
+		 * @param shouldShrink false will not free memory
+		 */
+		void Empty(const bool shouldShrink = true)
+		{
+			heap.Empty(shouldShrink);
+		}
+
+		i32 Size() const
+		{
+			return heap.Size();
+		}
+
+		bool IsEmpty() const
+		{
+			return heap.IsEmpty();
+		}
+
+		/** @return the underlying heap. Items are in heap order, not sorted */
+		const TArray<Type, Allocator>& GetHeap() const
+		{
+			return heap;
+		}
+	};
+
+
+	/**
+	 * Priority queue where each pushed item gets a handle that can be used to update its priority
+	 * (DecreaseKey/IncreaseKey/Update) or remove it in O(log n).
+	 * Handles are small integers and are reused after their item is removed or popped.
+	 */
+	template <typename Type, typename Predicate = Less, u32 Arity = 2,
+	    typename Allocator = Memory::DefaultAllocator>
+	class TIndexedPriorityQueue
+	{
+	public:
+		using ItemType = Type;
+		using Handle   = i32;
+
+		static constexpr Handle InvalidHandle = NO_INDEX;
+
+
+	private:
+		struct Node
+		{
+			Type value;
+			Handle handle;
+		};
+
+		TArray<Node, Allocator> heap;
+		// Position in the heap of each handle. NO_INDEX if the handle is not in use
+		TArray<i32, Allocator> heapIndices;
+		TArray<Handle, Allocator> freeHandles;
+		Predicate predicate{};
+
+
+	public:
+		TIndexedPriorityQueue() = default;
+		explicit TIndexedPriorityQueue(Predicate predicate) : predicate{Move(predicate)} {}
+
+		Handle Push(Type&& item)
+		{
+			const Handle handle = NewHandle();
+			const i32 index     = heap.Add({Move(item), handle});
+			heapIndices[handle] = index;
+			SiftUp(index);
+			return handle;
+		}
+
+		Handle Push(const Type& item)
+		{
+			return Push(Type{item});
+		}
+
+		/** Removes the top element and returns it. Queue can't be empty */
+		Type Pop()
+		{
+			assert(!IsEmpty() && "Can't pop from an empty priority queue");
+			Type top = Move(heap.First().value);
+			RemoveAtIndex(0);
+			return Move(top);
+		}
+
+		const Type& Top() const
+		{
+			assert(!IsEmpty() && "Can't get the top of an empty priority queue");
+			return heap.First().value;
+		}
+
+		Handle TopHandle() const
+		{
+			return IsEmpty() ? InvalidHandle : heap.First().handle;
+		}
+
+		bool Contains(Handle handle) const
+		{
+			return heapIndices.IsValidIndex(handle) && heapIndices[handle] != NO_INDEX;
+		}
+
+		const Type& Get(Handle handle) const
+		{
+			assert(Contains(handle) && "Handle is not in the queue");
+			return heap[heapIndices[handle]].value;
+		}
+
+		/**
+		 * Replaces the value of an item with one that has higher priority (closer to the top).
+		 * Cheaper than Update since it only sifts up.
+		 */
+		void DecreaseKey(Handle handle, Type value)
+		{
+			assert(Contains(handle) && "Handle is not in the queue");
+			const i32 index          = heapIndices[handle];
+			heap.Data()[index].value = Move(value);
+			SiftUp(index);
+		}
+
+		/** Replaces the value of an item with one that has lower priority (further from the top) */
+		void IncreaseKey(Handle handle, Type value)
+		{
+			assert(Contains(handle) && "Handle is not in the queue");
+			const i32 index          = heapIndices[handle];
+			heap.Data()[index].value = Move(value);
+			SiftDown(index);
+		}
+
+		/** Replaces the value of an item without knowing the direction of the change */
+		void Update(Handle handle, Type value)
+		{
+			assert(Contains(handle) && "Handle is not in the queue");
+			const i32 index          = heapIndices[handle];
+			heap.Data()[index].value = Move(value);
+			SiftDown(SiftUp(index));
+		}
+
+		/** @return true if the handle was in the queue and got removed */
+		bool Remove(Handle handle)
+		{
+			if (!Contains(handle))
+			{
+				return false;
+			}
+			RemoveAtIndex(heapIndices[handle]);
+			return true;
+		}
+
+		void Reserve(i32 sizeNum)
+		{
+			heap.Reserve(sizeNum);
+			heapIndices.Reserve(sizeNum);
+		}
+
+		/** Empty the queue. All handles become invalid.
+		 * @param shouldShrink false will not free memory
+		 */
+		void Empty(const bool shouldShrink = true)
+		{
+			heap.Empty(shouldShrink);
+			heapIndices.Empty(shouldShrink);
+			freeHandles.Empty(shouldShrink);
+		}
+
+		i32 Size() const
+		{
+			return heap.Size();
+		}
+
+		bool IsEmpty() const
+		{
+			return heap.IsEmpty();
+		}
+
+
+		/** INTERNAL */
+	private:
+		Handle NewHandle()
+		{
+			if (!freeHandles.IsEmpty())
+			{
+				const Handle handle = freeHandles.Last();
+				freeHandles.RemoveAt(freeHandles.Size() - 1, false);
+				return handle;
+			}
+			return heapIndices.Add(NO_INDEX);
+		}
+
+		void RemoveAtIndex(i32 index)
+		{
+			Node* const data           = heap.Data();
+			const Handle removedHandle = data[index].handle;
+			const i32 lastIndex        = heap.Size() - 1;
+
+			if (index != lastIndex)
+			{
+				Place(index, Move(data[lastIndex]));
+			}
+			heap.RemoveAt(lastIndex, false);
+			heapIndices[removedHandle] = NO_INDEX;
+			freeHandles.Add(removedHandle);
+
+			if (index < lastIndex)
+			{
+				SiftDown(SiftUp(index));
+			}
+		}
+
+		void Place(i32 index, Node&& node)
+		{
+			heapIndices[node.handle] = index;
+			heap.Data()[index]       = Move(node);
+		}
+
+		// Sifting moves a "hole" instead of swapping, halving the amount of writes
+		i32 SiftUp(i32 index)
+		{
+			Node* const data = heap.Data();
+			Node node        = Move(data[index]);
+			while (index > 0)
+			{
+				const i32 parentIndex = Algorithms::HeapGetParentIndex<Arity>(index);
+				if (!predicate(node.value, data[parentIndex].value))
+				{
+					break;
+				}
+				Place(index, Move(data[parentIndex]));
+				index = parentIndex;
+			}
+			Place(index, Move(node));
+			return index;
+		}
+
+		i32 SiftDown(i32 index)
+		{
+			Node* const data         = heap.Data();
+			const i32 count          = heap.Size();
+			const auto nodePredicate = [this](const Node& a, const Node& b) {
+				return predicate(a.value, b.value);
+			};
+
+			Node node = Move(data[index]);
+			while (!Algorithms::HeapIsLeaf<Arity>(index, count))
+			{
+				const i32 bestChildIndex =
+				    Algorithms::HeapGetBestChildIndex<Arity>(data, index, count, nodePredicate);
+				if (!predicate(data[bestChildIndex].value, node.value))
+				{
+					break;
+				}
+				Place(index, Move(data[bestChildIndex]));
+				index = bestChildIndex;
+			}
+			Place(index, Move(node));
+			return index;
+		}
+	};
+}    // namespace Rift
@@ -0,0 +1,273 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Containers/Span.h"
+#include "Misc/Utility.h"
+
+#include <cassert>
+
+
+namespace Rift
+{
+	/**
+	 * Key to a value inside a TSlotMap.
+	 * The generation invalidates keys of removed values even if their slot got reused.
+	 */
+	struct SlotMapKey
+	{
+		static constexpr u32 NoSlot = u32(-1);
+
+		u32 index      = NoSlot;
+		u32 generation = 0;
+
+
+		bool IsValid() const
+		{
+			return index != NoSlot;
+		}
+
+		u64 ToU64() const
+		{
+			return (u64(generation) << 32) | u64(index);
+		}
+
+		static SlotMapKey FromU64(u64 value)
+		{
+			return {u32(value), u32(value >> 32)};
+		}
+
+		bool operator==(const SlotMapKey& other) const
+		{
+			return index == other.index && generation == other.generation;
+		}
+	};
+
+
+	/**
+	 * Stores values packed contiguously and gives each a stable generational key.
+	 * Insert, Remove and Find are O(1) and iteration is over a dense array.
+	 * Removing moves the last value into the removed position, so order is not preserved and
+	 * pointers to values are invalidated. Keys stay valid until their value is removed.
+	 */
+	template <typename Type, typename Allocator = Memory::DefaultAllocator>
+	class TSlotMap
+	{
+	public:
+		using ItemType      = Type;
+		using Key           = SlotMapKey;
+		using Iterator      = typename TArray<Type, Allocator>::Iterator;
+		using ConstIterator = typename TArray<Type, Allocator>::ConstIterator;
+
+
+	private:
+		struct Slot
+		{
+			// Index of the value when in use. Next free slot when not.
+			u32 index = Key::NoSlot;
+			// Odd while in use, even while free
+			u32 generation = 0;
+		};
+
+		TArray<Slot, Allocator> slots;
+		TArray<Type, Allocator> values;
+		// Slot of each value, to fix slots when values move
+		TArray<u32, Allocator> valueSlots;
+		u32 firstFreeSlot = Key::NoSlot;
+
+
+	public:
+		TSlotMap() = default;
+
+		Key Insert(Type&& value)
+		{
+			const u32 slotIndex = NewSlot();
+			Slot& slot          = slots.Data()[slotIndex];
+			slot.index          = u32(values.Add(Move(value)));
+			valueSlots.Add(slotIndex);
+			return {slotIndex, slot.generation};
+		}
+
+		Key Insert(const Type& value)
+		{
+			return Insert(Type{value});
+		}
+
+		/**
+		 * Removes the value of a key
+		 * @return true if the key was valid and got removed
+		 */
+		bool Remove(Key key)
+		{
+			if (!Contains(key))
+			{
+				return false;
+			}
+			RemoveSlot(key.index);
+			return true;
+		}
+
+		/**
+		 * Removes all values matching a callback
+		 * @return number of removed values
+		 */
+		template <typename Callback>
+		i32 RemoveIf(Callback&& callback)
+		{
+			const i32 lastSize = Size();
+			// Iterate backwards so that swapped values have already been checked
+			for (i32 i = lastSize - 1; i >= 0; --i)
+			{
+				if (callback(values.Data()[i]))
+				{
+					RemoveSlot(valueSlots.Data()[i]);
+				}
+			}
+			return lastSize - Size();
+		}
+
+		/** @return the value of a key, or nullptr if the key is not valid */
+		Type* Find(Key key)
+		{
+			return Contains(key) ? values.Data() + slots.Data()[key.index].index : nullptr;
+		}
+
+		const Type* Find(Key key) const
+		{
+			return Contains(key) ? values.Data() + slots.Data()[key.index].index : nullptr;
+		}
+
+		bool Contains(Key key) const
+		{
+			return (key.generation & 1) != 0 && key.index < u32(slots.Size())
+			    && slots.Data()[key.index].generation == key.generation;
+		}
+
+		Type& operator[](Key key)
+		{
+			assert(Contains(key) && "Key is not in the slot map");
+			return values.Data()[slots.Data()[key.index].index];
+		}
+
+		const Type& operator[](Key key) const
+		{
+			assert(Contains(key) && "Key is not in the slot map");
+			return values.Data()[slots.Data()[key.index].index];
+		}
+
+		/** @return the key of a value from its index in the dense array */
+		Key GetKey(i32 index) const
+		{
+			assert(values.IsValidIndex(index));
+			const u32 slotIndex = valueSlots.Data()[index];
+			return {slotIndex, slots.Data()[slotIndex].generation};
+		}
+
+		void Reserve(i32 sizeNum)
+		{
+			slots.Reserve(sizeNum);
+			values.Reserve(sizeNum);
+			valueSlots.Reserve(sizeNum);
+		}
+
+		/** Empty the slot map. All keys become invalid.
+		 * @param shouldShrink false will not free memory
+		 */
+		void Empty(const bool shouldShrink = true)
+		{
+			// Slots are kept so that old keys can't match reused slots
+			while (!values.IsEmpty())
+			{
+				RemoveSlot(valueSlots.Last());
+			}
+			if (shouldShrink)
+			{
+				values.Empty();
+				valueSlots.Empty();
+			}
+		}
+
+		i32 Size() const
+		{
+			return values.Size();
+		}
+
+		bool IsEmpty() const
+		{
+			return values.IsEmpty();
+		}
+
+		/** @return all values packed contiguously */
+		TSpan<Type> GetValues()
+		{
+			return {values.Data(), sizet(values.Size())};
+		}
+
+		TSpan<const Type> GetValues() const
+		{
+			return {values.Data(), sizet(values.Size())};
+		}
+
+		Iterator begin()
+		{
+			return values.begin();
+		}
+		ConstIterator begin() const
+		{
+			return values.begin();
+		}
+		Iterator end()
+		{
+			return values.end();
+		}
+		ConstIterator end() const
+		{
+			return values.end();
+		}
+
+
+		/** INTERNAL */
+	private:
+		u32 NewSlot()
+		{
+			u32 slotIndex;
+			if (firstFreeSlot != Key::NoSlot)
+			{
+				slotIndex     = firstFreeSlot;
+				firstFreeSlot = slots.Data()[slotIndex].index;
+			}
+			else
+			{
+				slotIndex = u32(slots.Add({}));
+			}
+			++slots.Data()[slotIndex].generation;
+			return slotIndex;
+		}
+
+		void RemoveSlot(u32 slotIndex)
+		{
+			Slot& slot             = slots.Data()[slotIndex];
+			const u32 valueIndex   = slot.index;
+			const u32 lastIndex    = u32(values.Size() - 1);
+			u32* const slotByValue = valueSlots.Data();
+
+			if (valueIndex != lastIndex)
+			{
+				const u32 movedSlot           = slotByValue[lastIndex];
+				values.Data()[valueIndex]     = Move(values.Data()[lastIndex]);
+				slotByValue[valueIndex]       = movedSlot;
+				slots.Data()[movedSlot].index = valueIndex;
+			}
+			values.RemoveAt(i32(lastIndex), false);
+			valueSlots.RemoveAt(i32(lastIndex), false);
+
+			// Even generation marks the slot as free and invalidates existing keys
+			++slot.generation;
+			slot.index    = firstFreeSlot;
+			firstFreeSlot = slotIndex;
+		}
+	};
+}    // namespace Rift
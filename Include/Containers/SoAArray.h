@@ -0,0 +1,290 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Containers/Span.h"
+#include "Containers/Tuples.h"
+#include "Misc/Utility.h"
+#include "TypeTraits.h"
+
+#include <tuple>
+
+
+namespace Rift
+{
+	/**
+	 * Struct-of-arrays container. Each listed member of T is stored in its own contiguous column,
+	 * so passes that only touch one or two members read only those columns.
+	 *
+	 * Columns are declared as a list of member pointers:
+	 *   TSoAArray<Particle, &Particle::position, &Particle::velocity> particles;
+	 *   for (v3& position : particles.GetColumn<&Particle::position>()) {...}
+	 *
+	 * Members not listed are not stored. Rows can be accessed as proxies with operator[], or
+	 * gathered back into a T with Get(index).
+	 * bool members are stored as u8, since a TArray<bool> is not contiguous. Their columns are
+	 * spans of u8.
+	 */
+	template <typename T, auto... Members>
+	class TSoAArray
+	{
+		static_assert(sizeof...(Members) > 0, "TSoAArray needs at least one member column");
+		static_assert((IsSame<typename MemberPointerTraits<decltype(Members)>::Class, T> && ...),
+		    "All columns must be members of T");
+
+	public:
+		using ItemType = T;
+
+		template <auto Member>
+		using MemberType = typename MemberPointerTraits<decltype(Member)>::Member;
+
+		/** Type stored in the column of a member */
+		template <auto Member>
+		using ColumnType =
+		    std::conditional_t<IsSame<MemberType<Member>, bool>, u8, MemberType<Member>>;
+
+		static constexpr sizet numColumns = sizeof...(Members);
+
+
+		/** Proxy to a single row. Only valid until the container changes size */
+		template <bool bConst>
+		struct TRow
+		{
+			using Owner = std::conditional_t<bConst, const TSoAArray, TSoAArray>;
+
+			Owner* owner = nullptr;
+			i32 index    = NO_INDEX;
+
+			template <auto Member>
+			auto& Get() const
+			{
+				return owner->template GetColumn<Member>()[index];
+			}
+
+			/** Gathers the row into a T */
+			T Load() const
+			{
+				return owner->Get(index);
+			}
+
+			/** Scatters a T into the row */
+			void Store(const T& item) const requires(!bConst)
+			{
+				owner->Set(index, item);
+			}
+		};
+		using Row      = TRow<false>;
+		using ConstRow = TRow<true>;
+
+
+	private:
+		Tuple<TArray<ColumnType<Members>>...> columns;
+
+
+	public:
+		TSoAArray() = default;
+
+		i32 Add(const T& item)
+		{
+			std::apply(
+			    [&item](auto&... column) {
+				    (column.Add(item.*Members), ...);
+			    },
+			    columns);
+			return Size() - 1;
+		}
+
+		i32 Add(T&& item)
+		{
+			std::apply(
+			    [&item](auto&... column) {
+				    (column.Add(Move(item.*Members)), ...);
+			    },
+			    columns);
+			return Size() - 1;
+		}
+
+		i32 AddDefaulted()
+		{
+			std::apply(
+			    [](auto&... column) {
+				    (column.AddDefaulted(), ...);
+			    },
+			    columns);
+			return Size() - 1;
+		}
+
+		/**
+		 * Delete row at index
+		 * @return true if removed
+		 */
+		bool RemoveAt(i32 index, const bool shouldShrink = true)
+		{
+			if (!IsValidIndex(index))
+			{
+				return false;
+			}
+			std::apply(
+			    [index, shouldShrink](auto&... column) {
+				    (column.RemoveAt(index, shouldShrink), ...);
+			    },
+			    columns);
+			return true;
+		}
+
+		/**
+		 * Delete row at index. Doesn't preserve order but its considerably faster
+		 * @return true if removed
+		 */
+		bool RemoveAtSwap(i32 index, const bool shouldShrink = true)
+		{
+			if (!IsValidIndex(index))
+			{
+				return false;
+			}
+			std::apply(
+			    [index, shouldShrink](auto&... column) {
+				    (column.RemoveAtSwap(index, shouldShrink), ...);
+			    },
+			    columns);
+			return true;
+		}
+
+		void Swap(i32 firstIndex, i32 secondIndex)
+		{
+			std::apply(
+			    [firstIndex, secondIndex](auto&... column) {
+				    (column.Swap(firstIndex, secondIndex), ...);
+			    },
+			    columns);
+		}
+
+		void Reserve(i32 sizeNum)
+		{
+			std::apply(
+			    [sizeNum](auto&... column) {
+				    (column.Reserve(sizeNum), ...);
+			    },
+			    columns);
+		}
+
+		void Resize(i32 sizeNum)
+		{
+			std::apply(
+			    [sizeNum](auto&... column) {
+				    (column.Resize(sizeNum), ...);
+			    },
+			    columns);
+		}
+
+		/** Empty the array.
+		 * @param shouldShrink false will not free memory
+		 */
+		void Empty(const bool shouldShrink = true)
+		{
+			std::apply(
+			    [shouldShrink](auto&... column) {
+				    (column.Empty(shouldShrink), ...);
+			    },
+			    columns);
+		}
+
+		/** @return a contiguous view of all values of a member */
+		template <auto Member>
+		TSpan<ColumnType<Member>> GetColumn()
+		{
+			constexpr sizet columnIndex = GetColumnIndex<Member>();
+			static_assert(columnIndex < numColumns, "Member is not a column of this TSoAArray");
+
+			auto& column = std::get<columnIndex>(columns);
+			return {column.Data(), sizet(column.Size())};
+		}
+
+		template <auto Member>
+		TSpan<const ColumnType<Member>> GetColumn() const
+		{
+			constexpr sizet columnIndex = GetColumnIndex<Member>();
+			static_assert(columnIndex < numColumns, "Member is not a column of this TSoAArray");
+
+			const auto& column = std::get<columnIndex>(columns);
+			return {column.Data(), sizet(column.Size())};
+		}
+
+		/** Gathers a row into a T. Members that are not columns are default initialized */
+		T Get(i32 index) const
+		{
+			assert(IsValidIndex(index));
+			T item{};
+			std::apply(
+			    [&item, index](const auto&... column) {
+				    ((item.*Members = column.Data()[index]), ...);
+			    },
+			    columns);
+			return item;
+		}
+
+		/** Scatters a T into a row */
+		void Set(i32 index, const T& item)
+		{
+			assert(IsValidIndex(index));
+			std::apply(
+			    [&item, index](auto&... column) {
+				    ((column.Data()[index] = item.*Members), ...);
+			    },
+			    columns);
+		}
+
+		i32 Size() const
+		{
+			return std::get<0>(columns).Size();
+		}
+
+		bool IsEmpty() const
+		{
+			return Size() == 0;
+		}
+
+		bool IsValidIndex(i32 index) const
+		{
+			return index >= 0 && index < Size();
+		}
+
+		Row operator[](i32 index)
+		{
+			assert(IsValidIndex(index));
+			return {this, index};
+		}
+
+		ConstRow operator[](i32 index) const
+		{
+			assert(IsValidIndex(index));
+			return {this, index};
+		}
+
+		/** @return the column index of a member, or numColumns if it is not a column */
+		template <auto Member>
+		static constexpr sizet GetColumnIndex()
+		{
+			sizet i     = 0;
+			sizet found = numColumns;
+			((IsSameMember<Member, Members>() ? (found = i, ++i) : ++i), ...);
+			return found;
+		}
+
+
+		/** INTERNAL */
+	private:
+		template <auto A, auto B>
+		static constexpr bool IsSameMember()
+		{
+			if constexpr (IsSame<decltype(A), decltype(B)>)
+			{
+				return A == B;
+			}
+			return false;
+		}
+	};
+}    // namespace Rift
@@ -0,0 +1,14 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "Platform/Platform.h"
+
+#include <span>
+
+
+namespace Rift
+{
+	template <typename T, sizet Extent = std::dynamic_extent>
+	using TSpan = std::span<T, Extent>;
+}    // namespace Rift
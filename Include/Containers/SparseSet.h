@@ -0,0 +1,146 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Containers/Span.h"
+#include "Math/Math.h"
+#include "Misc/Utility.h"
+#include "TypeTraits.h"
+
+
+namespace Rift
+{
+	/**
+	 * Set of integer ids with O(1) insert, remove and lookup, and dense iteration.
+	 * Ids index a sparse array pointing into a packed dense array of the ids themselves.
+	 * Sparse memory grows with the biggest id inserted, so ids should be small and reused.
+	 * Removing swaps the last id into the removed position, so order is not preserved.
+	 */
+	template <typename Index = u32, typename Allocator = Memory::DefaultAllocator>
+	class TSparseSet
+	{
+		static_assert(Integral<Index>, "Sparse set ids must be integers");
+
+	public:
+		using ItemType      = Index;
+		using Iterator      = typename TArray<Index, Allocator>::Iterator;
+		using ConstIterator = typename TArray<Index, Allocator>::ConstIterator;
+
+
+	private:
+		TArray<Index, Allocator> dense;
+		// Position of each id in the dense array. Only meaningful when it points back to the id,
+		// so it never needs to be cleared.
+		TArray<Index, Allocator> sparse;
+
+
+	public:
+		TSparseSet() = default;
+
+		/**
+		 * Adds an id to the set
+		 * @return true if the id was not already in the set
+		 */
+		bool Insert(Index id)
+		{
+			if (Contains(id))
+			{
+				return false;
+			}
+			if (sizet(id) >= sizet(sparse.Size()))
+			{
+				// Grow geometrically to amortize big ids
+				sparse.Resize(i32(Math::Max(sizet(id) + 1, sizet(sparse.Size()) * 2)));
+			}
+			sparse.Data()[id] = Index(dense.Size());
+			dense.Add(id);
+			return true;
+		}
+
+		/**
+		 * Removes an id from the set
+		 * @return true if the id was in the set
+		 */
+		bool Remove(Index id)
+		{
+			if (!Contains(id))
+			{
+				return false;
+			}
+			Index* const denseData = dense.Data();
+			const Index position   = sparse.Data()[id];
+			const Index lastId     = dense.Last();
+
+			denseData[position]   = lastId;
+			sparse.Data()[lastId] = position;
+			dense.RemoveAt(dense.Size() - 1, false);
+			return true;
+		}
+
+		bool Contains(Index id) const
+		{
+			if (sizet(id) >= sizet(sparse.Size()))
+			{
+				return false;
+			}
+			const Index position = sparse.Data()[id];
+			return sizet(position) < sizet(dense.Size()) && dense.Data()[position] == id;
+		}
+
+		/** @return the position of an id in the dense array, or NO_INDEX if not contained */
+		i32 IndexOf(Index id) const
+		{
+			return Contains(id) ? i32(sparse.Data()[id]) : NO_INDEX;
+		}
+
+		/** Reserves dense memory for sizeNum ids and sparse memory for ids up to maxId */
+		void Reserve(i32 sizeNum, Index maxId = 0)
+		{
+			dense.Reserve(sizeNum);
+			if (sizet(maxId) >= sizet(sparse.Size()))
+			{
+				sparse.Resize(i32(maxId) + 1);
+			}
+		}
+
+		/** Empty the set.
+		 * @param shouldShrink false will not free memory
+		 */
+		void Empty(const bool shouldShrink = true)
+		{
+			dense.Empty(shouldShrink);
+			if (shouldShrink)
+			{
+				sparse.Empty();
+			}
+		}
+
+		i32 Size() const
+		{
+			return dense.Size();
+		}
+
+		bool IsEmpty() const
+		{
+			return dense.IsEmpty();
+		}
+
+		/** @return all contained ids packed contiguously */
+		TSpan<const Index> GetDense() const
+		{
+			return {dense.Data(), sizet(dense.Size())};
+		}
+
+		ConstIterator begin() const
+		{
+			return dense.begin();
+		}
+		ConstIterator end() const
+		{
+			return dense.end();
+		}
+	};
+}    // namespace Rift
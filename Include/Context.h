@@ -5,6 +5,9 @@
 #include "Assets/AssetPtr.h"
 #include "CoreObject.h"
 #include "Events/Broadcast.h"
+#include "Files/AsyncIO.h"
+#include "Files/SaveQueue.h"
+#include "Files/VirtualFileSystem.h"
 #include "Tasks.h"
 
 
@@ -16,18 +19,27 @@ namespace Rift
 
 	private:
 		static ObjectPtr<Context> globalInstance;
+		static TaskSystemConfig tasksConfig;
 
 		ObjectPtr<AssetManager> assetManager;
 
 		TaskSystem tasks;
+		AsyncIO asyncIO;
+		VirtualFileSystem vfs;
+		// Declared last so that it flushes before the tasks stop
+		SaveQueue saveQueue;
 
 
 	public:
-		/** Called to initialize the global context. */
-		static void Initialize()
+		/**
+		 * Called to initialize the global context.
+		 * @param config of the task system, which can't change once created
+		 */
+		static void Initialize(const TaskSystemConfig& config = {})
 		{
 			if (!globalInstance)
 			{
+				tasksConfig    = config;
 				globalInstance = Create<Context>();
 			}
 		}
@@ -41,7 +53,13 @@ namespace Rift
 			}
 		}
 
-		Context() : Super(), assetManager{Create<AssetManager>()} {}
+		Context()
+		    : Super()
+		    , assetManager{Create<AssetManager>()}
+		    , tasks{tasksConfig}
+		    , asyncIO{tasks}
+		    , saveQueue{tasks}
+		{}
 
 		virtual void Construct() override
 		{
@@ -68,6 +86,21 @@ namespace Rift
 			return tasks;
 		}
 
+		AsyncIO& GetAsyncIO()
+		{
+			return asyncIO;
+		}
+
+		VirtualFileSystem& GetVFS()
+		{
+			return vfs;
+		}
+
+		SaveQueue& GetSaveQueue()
+		{
+			return saveQueue;
+		}
+
 		static Ptr<Context> Get()
 		{
 			assert(globalInstance && "Context is not initialized! Call Context::Initialize().");
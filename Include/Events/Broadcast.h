@@ -1,6 +1,7 @@
 // Copyright 2015-2021 Piperift - All rights reserved
 #pragma once
 
+#include "Containers/SlotMap.h"
 #include "CoreObject.h"
 #include "CoreTypes.h"
 #include "EventHandle.h"
@@ -10,6 +11,10 @@
 
 namespace Rift
 {
+	/**
+	 * Calls all bound listeners. Listeners are called in the order they were bound until one
+	 * is unbound: unbinding moves the last listener into its place, so order is not stable.
+	 */
 	template <typename... Params>
 	class Broadcast
 	{
@@ -22,22 +27,17 @@ namespace Rift
 		using MemberMethodPtr = void (Type::*)(Params...);
 
 
-		struct BaseListener
+		struct Listener
 		{
 			u64 id;
 			Function method;
-		};
-		struct RawListener : public BaseListener
-		{
-			void* instance;
-		};
-		struct ObjListener : public BaseListener
-		{
+			void* instance = nullptr;
 			Ptr<Object> object;
+			bool bObjectBound = false;
 		};
 
-		mutable TArray<RawListener> rawListeners{};
-		mutable TArray<ObjListener> objListeners{};
+		// Packed for iteration. EventHandles keep the key of their listener to unbind in O(1)
+		mutable TSlotMap<Listener> listeners{};
 
 
 	public:
@@ -46,14 +46,9 @@ namespace Rift
 		/** Broadcast to all binded functions */
 		void DoBroadcast(const Params&... params)
 		{
-			for (RawListener& listener : rawListeners)
-			{
-				listener.method(params...);
-			}
-
-			for (auto& listener : objListeners)
+			for (Listener& listener : listeners)
 			{
-				if (listener.object)
+				if (!listener.bObjectBound || listener.object)
 				{
 					listener.method(params...);
 				}
@@ -67,9 +62,7 @@ namespace Rift
 		{
 			if (method)
 			{
-				EventHandle handle{};
-				rawListeners.Add({handle.Id(), Move(method), nullptr});
-				return handle;
+				return AddListener({0, Move(method), nullptr, {}, false});
 			}
 
 			Log::Warning("Couldn't bind delegate");
@@ -89,9 +82,10 @@ namespace Rift
 				}
 				else
 				{
-					return Bind([instance, method](Params... params) {
+					Function func = [instance, method](Params... params) {
 						(instance->*method)(params...);
-					});
+					};
+					return AddListener({0, Move(func), instance, {}, false});
 				}
 			}
 
@@ -111,9 +105,7 @@ namespace Rift
                     (instance->*method)(params...);
 				};
 
-				EventHandle handle{};
-				objListeners.Add({handle.Id(), Move(func), object});
-				return handle;
+				return AddListener({0, Move(func), nullptr, object, true});
 			}
 
 			Log::Warning("Couldn't bind delegate");
@@ -125,17 +117,24 @@ namespace Rift
 			if (!handle)
 				return false;
 
-			return rawListeners.RemoveIf([handle](const auto& listener) {
-				return listener.id == handle.Id();
-			}) > 0;
+			const SlotMapKey key     = SlotMapKey::FromU64(handle.bindKey);
+			const Listener* listener = listeners.Find(key);
+			// Ids are global. Prevents unbinding with handles from other events
+			if (listener && listener->id == handle.Id())
+			{
+				listeners.Remove(key);
+				return true;
+			}
+			return false;
 		}
 
 		bool UnbindAll(Ptr<Object> object) const
 		{
 			if (object)
 			{
-				return objListeners.RemoveIf([object](const auto& listener) {
-					return !listener.object || listener.object == object;
+				return listeners.RemoveIf([&object](const Listener& listener) {
+					return listener.bObjectBound
+					    && (!listener.object || listener.object == object);
 				}) > 0;
 			}
 			return false;
@@ -152,12 +151,23 @@ namespace Rift
 				}
 				else
 				{
-					return rawListeners.RemoveIf([instance](const auto& listener) {
+					return listeners.RemoveIf([instance](const Listener& listener) {
 						return listener.instance == instance;
 					}) > 0;
 				}
 			}
 			return false;
 		}
+
+
+		/** INTERNAL */
+	private:
+		EventHandle AddListener(Listener&& listener) const
+		{
+			EventHandle handle{};
+			listener.id    = handle.Id();
+			handle.bindKey = listeners.Insert(Move(listener)).ToU64();
+			return handle;
+		}
 	};
 }    // namespace Rift
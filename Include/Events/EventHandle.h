@@ -6,8 +6,15 @@
 
 namespace Rift
 {
+	template <typename... Params>
+	class Broadcast;
+
+
 	struct EventHandle
 	{
+		template <typename... Params>
+		friend class Broadcast;
+
 	private:
 		static u64 counter;
 
@@ -19,6 +26,8 @@ namespace Rift
 		}
 
 		u64 id;
+		/** Where the event stored the binding. Allows unbinding without searching */
+		u64 bindKey = 0;
 
 		/** Used for invalidation */
 		EventHandle(u64 customId) : id(customId) {}
@@ -0,0 +1,175 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Files/FileSystem.h"
+#include "Strings/String.h"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+
+
+namespace Rift
+{
+	struct TaskSystem;
+
+
+	/** File opened for AsyncIO. Closed when destroyed */
+	class CORE_API IOFile
+	{
+		// File descriptor, or HANDLE on Windows. Both use -1 when invalid
+		intptr_t handle = -1;
+
+
+	public:
+		IOFile() = default;
+		IOFile(IOFile&& other) : handle{other.handle}
+		{
+			other.handle = -1;
+		}
+		IOFile& operator=(IOFile&& other);
+		IOFile(const IOFile&) = delete;
+		IOFile& operator=(const IOFile&) = delete;
+		~IOFile()
+		{
+			Close();
+		}
+
+		/** Opens a file for reading or, if bWrite, creates or truncates it for writing */
+		static IOFile Open(const Path& path, bool bWrite = false);
+
+		void Close();
+
+		/** @return size of the file in bytes, 0 if not open */
+		u64 GetSize() const;
+
+		bool IsOpen() const
+		{
+			return handle != -1;
+		}
+
+		intptr_t GetHandle() const
+		{
+			return handle;
+		}
+	};
+
+
+	struct AsyncIOConfig
+	{
+		/** Operations the kernel can take at once. Queued operations are submitted at this count */
+		u32 queueDepth = 256;
+		/** Use io_uring when the kernel supports it. Only on Linux */
+		bool bUseIOUring = true;
+	};
+
+
+	/**
+	 * Asynchronous file reads and writes.
+	 * Operations are queued and start together on Submit(), or once queueDepth of them
+	 * accumulate. On Linux they are passed to the kernel through io_uring and a single thread
+	 * waits for all of them. Elsewhere, or if io_uring is not available, they run on the IO
+	 * threads of the task system.
+	 * Results are the number of bytes transferred, which can be less than requested, or a
+	 * negative error code. Files and buffers must stay valid until their operations complete.
+	 */
+	class CORE_API AsyncIO
+	{
+	public:
+		using Callback = std::function<void(i64 result)>;
+
+	private:
+		struct Operation;
+		struct Ring;
+		struct FileLoad;
+
+		const TaskSystem& tasks;
+		u32 queueDepth = 0;
+		std::unique_ptr<Ring> ring;
+		std::thread completionThread;
+
+		std::mutex mutex;
+		TArray<std::unique_ptr<Operation>> queued;
+		TArray<std::span<u8>> buffers;
+		// Operations queued or submitted that didn't complete yet
+		std::atomic<u32> numPending{0};
+
+
+	public:
+		AsyncIO(const TaskSystem& tasks, const AsyncIOConfig& config = {});
+		/** Submits queued operations and waits for all of them */
+		~AsyncIO();
+		AsyncIO(const AsyncIO&) = delete;
+		AsyncIO& operator=(const AsyncIO&) = delete;
+
+		/**
+		 * Queues a read of buffer.size() bytes at offset. onComplete runs as a worker task.
+		 * @param bufferIndex of the registered buffer containing buffer, or -1
+		 */
+		void Read(const IOFile& file, std::span<u8> buffer, u64 offset, Callback onComplete,
+		    i32 bufferIndex = -1);
+		void Write(const IOFile& file, std::span<const u8> buffer, u64 offset,
+		    Callback onComplete, i32 bufferIndex = -1);
+
+		/** Same as the ones above, but results are set on a future instead of running a task */
+		std::future<i64> Read(
+		    const IOFile& file, std::span<u8> buffer, u64 offset, i32 bufferIndex = -1);
+		std::future<i64> Write(
+		    const IOFile& file, std::span<const u8> buffer, u64 offset, i32 bufferIndex = -1);
+
+		/**
+		 * Queues reading a whole file into result, which must stay valid until the future is set
+		 * @return future set to false if the file couldn't be read
+		 */
+		std::future<bool> LoadFile(const Path& path, String& result);
+
+		/** Starts all queued operations */
+		void Submit();
+
+		/** Submits queued operations and blocks until all operations completed */
+		void Flush();
+
+		/**
+		 * Registers buffers that the kernel maps once, instead of on every operation using them.
+		 * Replaces buffers registered before. Must not be called while operations are pending.
+		 * @return false if the kernel couldn't register them. Operations can still use them
+		 */
+		bool RegisterBuffers(TArray<std::span<u8>> newBuffers);
+		void UnregisterBuffers();
+
+		bool IsUsingIOUring() const
+		{
+			return ring != nullptr;
+		}
+
+		u32 GetQueueDepth() const
+		{
+			return queueDepth;
+		}
+
+		static AsyncIO& Get();
+
+	private:
+		static std::unique_ptr<Operation> MakeOperation(bool bWrite, const IOFile& file,
+		    const u8* data, sizet size, u64 offset, i32 bufferIndex);
+		void Queue(std::unique_ptr<Operation> operation);
+		void ReadRemaining(std::shared_ptr<FileLoad> load);
+
+		/**
+		 * Passes queued operations to the ring. Must be called with mutex locked.
+		 * Operations the kernel refused are added to failed, to be completed once unlocked
+		 * @return 0, or the error of the failed operations
+		 */
+		i32 SubmitToRing(TArray<Operation*>& failed);
+		void WaitCompletions();
+		void Complete(Operation* operation, i64 result);
+	};
+}    // namespace Rift
@@ -0,0 +1,83 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Files/FileSystem.h"
+#include "Strings/String.h"
+#include "Strings/StringView.h"
+
+#include <memory>
+#include <mutex>
+
+
+namespace Rift
+{
+	struct TaskSystem;
+
+
+	struct CrawlSettings
+	{
+		/** Files must end with it, like ".rf". Empty accepts all files */
+		StringView extension;
+
+		bool bRecursive = true;
+
+		/** Reuse listings of directories not modified since they were last crawled */
+		bool bUseCache = true;
+
+		/** Task system to run on. Uses the one of the Context if null */
+		const TaskSystem* tasks = nullptr;
+	};
+
+
+	/**
+	 * Finds files in a directory tree. Subdirectories are listed in parallel by the workers.
+	 * On Linux, directories are read with getdents64 and entry types come with them, so files
+	 * are never stat'ed.
+	 * Listings are cached by the modification time of their directory, which changes when an
+	 * entry is added, removed or renamed. Cached directories cost a single stat.
+	 */
+	class CORE_API DirectoryCrawler
+	{
+	public:
+		struct Listing
+		{
+			i64 modified = 0;
+			TArray<String> files;
+			TArray<String> folders;
+		};
+
+	private:
+		struct Job;
+
+		std::mutex cacheMutex;
+		TMap<String, std::shared_ptr<const Listing>> cache;
+
+
+	public:
+		DirectoryCrawler() = default;
+		DirectoryCrawler(const DirectoryCrawler&) = delete;
+		DirectoryCrawler& operator=(const DirectoryCrawler&) = delete;
+
+		/** @return paths of the files found under folder, in no particular order */
+		TArray<Path> Crawl(const Path& folder, const CrawlSettings& settings = {});
+
+		void ClearCache();
+
+		/** @return entries of a single directory, skipping "." and ".." */
+		static bool List(const Path& folder, Listing& listing);
+
+	private:
+		std::shared_ptr<const Listing> GetListing(const Path& folder, bool bUseCache);
+
+		/**
+		 * Lists queued directories. The caller also waits until all are listed. Helpers that
+		 * start after that find nothing to do, so the job is shared with them
+		 */
+		static void Run(const std::shared_ptr<Job>& job, bool bCaller);
+	};
+}    // namespace Rift
@@ -148,6 +148,25 @@ namespace Rift
 			return path.string<TCHAR, std::char_traits<TCHAR>, STLAllocator<TCHAR>>();
 		}
 
+		/** @return true if path ends with extension, like ".rf". Doesn't allocate */
+		static bool HasExtension(const Path& path, StringView extension)
+		{
+			const auto& native = path.native();
+			if (native.size() <= extension.size())
+			{
+				return false;
+			}
+			const sizet start = native.size() - extension.size();
+			for (sizet i = 0; i < extension.size(); ++i)
+			{
+				if (native[start + i] != Path::value_type(extension[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
 		static Path FromString(StringView pathStr)
 		{
 			Path path;
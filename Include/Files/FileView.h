@@ -0,0 +1,96 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Files/FileSystem.h"
+#include "Strings/StringView.h"
+
+#include <memory>
+#include <span>
+
+
+namespace Rift
+{
+	/** How a FileView will be read, so that the OS can load its pages ahead */
+	enum class FileAccess : u8
+	{
+		/** Read from start to end. Pages start loading when the view opens */
+		Sequential,
+		/** Read in no particular order. Only touched pages are loaded */
+		Random
+	};
+
+
+	/**
+	 * Read-only view of a whole file, mapped in memory.
+	 * Pages are loaded by the OS when touched, so opening a view doesn't copy the file or
+	 * allocate a buffer for it. Files that can't be mapped, like the ones of /proc, are read
+	 * into a buffer instead.
+	 */
+	class CORE_API FileView
+	{
+		const u8* data = nullptr;
+		sizet size     = 0;
+		bool bOpen     = false;
+		bool bMapped   = false;
+#if PLATFORM_WINDOWS
+		void* mapping = nullptr;
+#endif
+		// Contents of files that couldn't be mapped
+		TArray<u8> buffer;
+		// View this one is part of, kept open by it
+		std::shared_ptr<const FileView> owner;
+
+
+	public:
+		FileView() = default;
+		FileView(const Path& path, FileAccess access = FileAccess::Sequential);
+		FileView(FileView&& other);
+		FileView& operator=(FileView&& other);
+		FileView(const FileView&) = delete;
+		FileView& operator=(const FileView&) = delete;
+		~FileView()
+		{
+			Close();
+		}
+
+		void Close();
+
+		/** @return view of size bytes of owner from offset. Owner stays open while it exists */
+		static FileView Slice(std::shared_ptr<const FileView> owner, sizet offset, sizet size);
+
+		/** @return true if the file was opened, even if it is empty */
+		bool IsOpen() const
+		{
+			return bOpen;
+		}
+
+		bool IsMapped() const
+		{
+			return bMapped;
+		}
+
+		const u8* GetData() const
+		{
+			return data;
+		}
+
+		sizet GetSize() const
+		{
+			return size;
+		}
+
+		std::span<const u8> GetBytes() const
+		{
+			return {data, size};
+		}
+
+		StringView GetString() const
+		{
+			return {reinterpret_cast<const TCHAR*>(data), size / sizeof(TCHAR)};
+		}
+	};
+}    // namespace Rift
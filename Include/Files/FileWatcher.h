@@ -0,0 +1,117 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Events/Broadcast.h"
+#include "Files/FileSystem.h"
+#include "Misc/Chrono.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+namespace Rift
+{
+	struct TaskSystem;
+
+
+	enum class FileChangeType : u8
+	{
+		Added,
+		Modified,
+		Removed,
+		/** Moved inside watched folders. The old path is kept in oldPath */
+		Renamed
+	};
+
+
+	struct FileChange
+	{
+		FileChangeType type = FileChangeType::Modified;
+		Path path;
+		Path oldPath;
+		bool bFolder = false;
+	};
+
+
+	struct FileWatcherConfig
+	{
+		/** Inotify changes are delivered once no new ones were seen for this long */
+		Chrono::milliseconds debounce{100};
+
+		/**
+		 * Inotify changes are delivered at most this long after the first one of a batch, even
+		 * if files keep changing
+		 */
+		Chrono::milliseconds maxLatency{1000};
+
+		/** Time between scans of the polling fallback */
+		Chrono::milliseconds pollInterval{1000};
+
+		/** Use inotify when the kernel supports it. Only on Linux. Polls otherwise */
+		bool bUseINotify = true;
+	};
+
+
+	/**
+	 * Reports changes to files inside watched folders and their subfolders.
+	 * On Linux, a single thread reads inotify events for all folders. Inotify watches folders,
+	 * not files, so large trees only cost a watch per folder. Moves inside watched folders
+	 * are reported as renames. Elsewhere, or if inotify is not available, that thread scans
+	 * the folders periodically instead, and moves are reported as a removal and an addition.
+	 * Changes are batched until the files stop changing, and repeated changes to a file are
+	 * merged into one.
+	 * If inotify drops events, each watched folder is reported as Modified, so that listeners
+	 * reload everything inside it.
+	 */
+	class CORE_API FileWatcher
+	{
+		struct State;
+
+		const TaskSystem& tasks;
+		FileWatcherConfig config;
+
+		std::mutex mutex;
+		std::unique_ptr<State> state;
+		std::atomic<bool> bStop{false};
+		std::thread thread;
+		// Expires when destroyed, so that batches posted to the main thread are dropped
+		std::shared_ptr<u8> alive = std::make_shared<u8>();
+
+
+	public:
+		/**
+		 * Called on the main thread with each batch of changes, when it pumps its tasks.
+		 * A file appears once per batch, with its changes merged.
+		 */
+		Broadcast<const TArray<FileChange>&> onChanged;
+
+
+		FileWatcher(const TaskSystem& tasks, const FileWatcherConfig& config = {});
+		~FileWatcher();
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		/** Starts watching folder and its subfolders. @return false if it can't be watched */
+		bool Watch(const Path& folder);
+
+		void Unwatch(const Path& folder);
+
+		bool IsUsingINotify() const;
+
+	private:
+		void RunINotify();
+		void RunPolling();
+
+		/** Reads pending inotify events. Called with the lock held */
+		void ReadEvents();
+
+		/** Sends changes gathered so far to the main thread. Called with the lock held */
+		void PostChanges();
+	};
+}    // namespace Rift
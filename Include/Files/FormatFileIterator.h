@@ -60,11 +60,16 @@ namespace Rift
 
 		bool IsEnd() const noexcept
 		{
-			return fileIterator._At_end();
+			return fileIterator == FileIterator{};
 		}
 
 	private:
 		void FindNext();
+
+		bool HasFormat() const
+		{
+			return FileSystem::HasExtension(fileIterator->path(), format);
+		}
 	};
 
 	template <typename FileIterator>
@@ -78,7 +83,7 @@ namespace Rift
 		fileIterator = FileIterator(path);
 
 		// Iterate to first found asset
-		if (fileIterator->path().extension() != AssetManager::assetFormat)
+		if (!IsEnd() && !HasFormat())
 		{
 			FindNext();
 		}
@@ -87,13 +92,12 @@ namespace Rift
 	template <typename FileIterator>
 	inline void FormatFileIterator<FileIterator>::FindNext()
 	{
-		static const FileIterator endIt{};
 		std::error_code error;
 		// Loop until end or until we find an asset
 		while (true)
 		{
 			fileIterator.increment(error);
-			if (fileIterator == endIt || fileIterator->path().extension() == format)
+			if (IsEnd() || HasFormat())
 			{
 				return;
 			}
@@ -0,0 +1,112 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Files/FileSystem.h"
+#include "Misc/Chrono.h"
+#include "Serialization/Json.h"
+#include "Strings/String.h"
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <variant>
+
+
+namespace Rift
+{
+	struct TaskSystem;
+
+
+	struct SaveQueueConfig
+	{
+		/**
+		 * Wait for written files to reach the disk before they replace the old ones, so that they
+		 * survive a power loss. Files of a batch are synced together
+		 */
+		bool bSync = true;
+
+		/** Time saves wait in the queue. Saving a file again while it waits writes it once */
+		Chrono::milliseconds delay{0};
+	};
+
+
+	/**
+	 * Writes files in the background.
+	 * Queued saves are written in batches. Their json is serialized on the workers, written to
+	 * a temporary file next to the target, and only then renamed over it. A crash can lose a
+	 * save, but never leaves a file half written.
+	 * Saving a file that is still queued replaces its data, and both saves share their result.
+	 */
+	class CORE_API SaveQueue
+	{
+		struct Entry
+		{
+			Path path;
+			std::variant<String, Json> data;
+			i32 indent = -1;
+			std::promise<bool> promise;
+			std::shared_future<bool> result;
+		};
+
+		const TaskSystem& tasks;
+		SaveQueueConfig config;
+
+		std::mutex mutex;
+		std::condition_variable changed;
+		TArray<Entry> pending;
+		// Index of each pending entry by path
+		TMap<String, i32> pendingIndices;
+		// A task to write the pending saves is queued
+		bool bScheduled = false;
+		// A batch is being written
+		bool bDraining = false;
+
+
+	public:
+		SaveQueue(const TaskSystem& tasks, const SaveQueueConfig& config = {});
+		~SaveQueue();
+		SaveQueue(const SaveQueue&) = delete;
+		SaveQueue& operator=(const SaveQueue&) = delete;
+
+		/** Queues json to be saved into path. @return false once written if it failed */
+		std::shared_future<bool> Save(const Path& path, Json data, i32 indent = -1);
+
+		/** Queues text to be saved into path. @return false once written if it failed */
+		std::shared_future<bool> Save(const Path& path, String data);
+
+		/**
+		 * Writes all queued saves and waits for them, including the ones in progress.
+		 * Pending saves are written by the calling thread with the help of the workers.
+		 */
+		void Flush();
+
+		/** @return number of saves queued and not being written yet */
+		i32 GetNumPending();
+
+		/**
+		 * Saves data into path through a temporary file, without a queue.
+		 * @param bSync waits for the data to reach the disk before replacing the file
+		 */
+		static bool WriteFile(const Path& path, StringView data, bool bSync = true);
+
+		/**
+		 * @return temporary path next to path, unique to each call in every process. Files are
+		 * written there and then renamed to path, so that they are replaced at once
+		 */
+		static Path GetTempPath(const Path& path);
+
+	private:
+		std::shared_future<bool> Queue(
+		    const Path& path, std::variant<String, Json> data, i32 indent);
+
+		/** Writes pending saves until none are left. Called with the lock held */
+		void Drain(std::unique_lock<std::mutex>& lock);
+
+		void WriteBatch(TArray<Entry>& batch);
+	};
+}    // namespace Rift
@@ -0,0 +1,191 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Files/FileSystem.h"
+#include "Files/FileView.h"
+#include "Strings/Name.h"
+#include "Strings/StringView.h"
+
+#include <memory>
+#include <shared_mutex>
+
+
+namespace Rift
+{
+	struct FileChange;
+
+
+	enum class FileType : u8
+	{
+		None,
+		File,
+		Folder
+	};
+
+
+	/** Source of files mounted in a VirtualFileSystem. Paths are relative to the mount */
+	class CORE_API VFSMount
+	{
+	public:
+		virtual ~VFSMount() = default;
+
+		virtual FileType GetType(StringView path) const = 0;
+
+		virtual FileView Open(StringView path, FileAccess access) const = 0;
+
+		/** @return true if realPath is inside the mount, and its path relative to it */
+		virtual bool ToRelative(const Path& /*realPath*/, String& /*relative*/) const
+		{
+			return false;
+		}
+	};
+
+
+	/** Mounts a folder of the disk */
+	class CORE_API FolderMount : public VFSMount
+	{
+		Path root;
+
+
+	public:
+		explicit FolderMount(Path root) : root{Move(root)} {}
+
+		FileType GetType(StringView path) const override;
+		FileView Open(StringView path, FileAccess access) const override;
+		bool ToRelative(const Path& realPath, String& relative) const override;
+
+		const Path& GetRoot() const
+		{
+			return root;
+		}
+	};
+
+
+	/**
+	 * Mounts a pack file, made of a table of paths followed by the contents of its files.
+	 * The pack is mapped once and its files are views into it, so they open without syscalls.
+	 */
+	class CORE_API PackMount : public VFSMount
+	{
+		struct Entry
+		{
+			u64 offset    = 0;
+			u64 size      = 0;
+			FileType type = FileType::None;
+		};
+
+		std::shared_ptr<const FileView> pack;
+		// Files and the folders containing them
+		TMap<Name, Entry> entries;
+
+
+	public:
+		explicit PackMount(const Path& path);
+
+		FileType GetType(StringView path) const override;
+		FileView Open(StringView path, FileAccess access) const override;
+
+		/** @return true if the pack was opened and its table is valid */
+		bool IsValid() const
+		{
+			return pack != nullptr;
+		}
+
+		/** Packs all files inside folder into a pack file. @return false if it failed */
+		static bool Write(const Path& path, const Path& folder);
+	};
+
+
+	/**
+	 * Resolves virtual paths, like "Assets/Textures/Grass.rf", to the files of its mounts.
+	 * Mounts are searched from the last one mounted, so later mounts override files of earlier
+	 * ones. Resolved paths are cached by Name, including paths that were not found, so
+	 * repeated lookups cost no syscalls. The cache must be invalidated when files change,
+	 * for example by binding OnFilesChanged to a FileWatcher.
+	 * Virtual paths use '/' and have no leading or trailing separators. See ToKey.
+	 */
+	class CORE_API VirtualFileSystem
+	{
+		struct MountPoint
+		{
+			Name point;
+			std::unique_ptr<VFSMount> mount;
+		};
+
+		struct Resolution
+		{
+			i32 mount     = -1;
+			FileType type = FileType::None;
+		};
+
+		mutable std::shared_mutex mutex;
+		TArray<MountPoint> mounts;
+		mutable TMap<Name, Resolution> cache;
+		// Increased on invalidation, so that lookups started before don't cache stale results
+		mutable u64 generation = 0;
+
+
+	public:
+		VirtualFileSystem() = default;
+		VirtualFileSystem(const VirtualFileSystem&) = delete;
+		VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+		/**
+		 * Mounts at a virtual folder, or at the root if point is None.
+		 * @return the mount, which can be used to unmount it
+		 */
+		VFSMount* Mount(const Name& point, std::unique_ptr<VFSMount> mount);
+
+		template <typename MountType, typename... Args>
+		MountType* Mount(const Name& point, Args&&... args)
+		{
+			return static_cast<MountType*>(
+			    Mount(point, std::make_unique<MountType>(Forward<Args>(args)...)));
+		}
+
+		bool Unmount(const VFSMount* mount);
+
+		FileType GetType(const Name& path) const;
+
+		bool Exists(const Name& path) const
+		{
+			return GetType(path) != FileType::None;
+		}
+
+		bool IsFile(const Name& path) const
+		{
+			return GetType(path) == FileType::File;
+		}
+
+		bool IsFolder(const Name& path) const
+		{
+			return GetType(path) == FileType::Folder;
+		}
+
+		/** @return view of a file. Not open if the file was not found */
+		FileView Read(const Name& path, FileAccess access = FileAccess::Sequential) const;
+
+		/** Forgets how path resolved. If bRecursive, also paths inside of it */
+		void Invalidate(const Name& path, bool bRecursive = false);
+
+		void InvalidateAll();
+
+		/** Invalidates paths of folder mounts that changed. Can be bound to a FileWatcher */
+		void OnFilesChanged(const TArray<FileChange>& changes);
+
+		/** @return path as a virtual path, using '/' and resolving "." and ".." */
+		static Name ToKey(StringView path);
+
+	private:
+		/** Resolves path, caching the result. Called with a shared lock */
+		Resolution Resolve(const Name& path, std::shared_lock<std::shared_mutex>& lock) const;
+
+		/** @return true if path is point or inside of it, and its path relative to point */
+		static bool GetRelative(StringView path, const Name& point, StringView& relative);
+	};
+}    // namespace Rift
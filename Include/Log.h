@@ -5,11 +5,19 @@
 #include "PCH.h"
 
 #include "Files/FileSystem.h"
+#include "Log/LogArgs.h"
 #include "Strings/String.h"
 
+#include <atomic>
 #include <mutex>
 
 
+/** Log levels below this are compiled out. 0 Verbose, 1 Info, 2 Warning, 3 Error */
+#ifndef RIFT_LOG_MIN_LEVEL
+#	define RIFT_LOG_MIN_LEVEL 0
+#endif
+
+
 namespace spdlog
 {
 	class logger;
@@ -17,41 +25,320 @@ namespace spdlog
 
 namespace Rift::Log
 {
+	enum class Level : u8
+	{
+		Verbose,
+		Info,
+		Warning,
+		Error,
+		None
+	};
+
+	constexpr StringView GetLevelName(Level level)
+	{
+		switch (level)
+		{
+			case Level::Verbose: return TX("Verbose");
+			case Level::Info: return TX("Info");
+			case Level::Warning: return TX("Warning");
+			case Level::Error: return TX("Error");
+			default: return TX("None");
+		}
+	}
+
+	/** Calls below this level do nothing and are removed by the compiler */
+	static constexpr Level compiledLevel = Level(RIFT_LOG_MIN_LEVEL);
+
+
+	/**
+	 * Group of messages with its own level. Its name is used as prefix of the messages.
+	 * Async logging writes messages later, so categories are meant to be declared once:
+	 *   inline Log::Category assetsLog{"Assets", Log::Level::Warning};
+	 */
+	struct Category
+	{
+		const TCHAR* name;
+		std::atomic<Level> level;
+
+
+		constexpr Category(const TCHAR* name, Level level = Level::Info)
+		    : name{name}, level{level}
+		{}
+
+		void SetLevel(Level newLevel)
+		{
+			level.store(newLevel, std::memory_order_relaxed);
+		}
+
+		Level GetLevel() const
+		{
+			return level.load(std::memory_order_relaxed);
+		}
+
+		bool IsEnabled(Level messageLevel) const
+		{
+			return messageLevel >= GetLevel();
+		}
+	};
+
+	/** Level of messages without category. Set with SetLevel */
+	extern CORE_API Category general;
+
+	/** What a thread does when its async buffer is full */
+	enum class OverflowPolicy : u8
+	{
+		/** Waits until the backend writes enough messages */
+		Block,
+		/** Discards new messages. The number of discarded messages gets logged */
+		Drop,
+		/** Keeps one of every sampleRate messages once the buffer is half full, then drops */
+		Sample
+	};
+
+	enum class FileFormat : u8
+	{
+		/** Rotating text files */
+		Text,
+		/**
+		 * Unformatted messages, see BinaryLogWriter. Read with the RiftLogDecoder tool.
+		 * Without bAsync messages are formatted by the caller and stored as text
+		 */
+		Binary
+	};
+
+	struct Settings
+	{
+		/** Folder or file to log into. Nothing is logged to files if empty */
+		Path logPath;
+		FileFormat fileFormat = FileFormat::Text;
+		/** Log files are rotated when they reach this size in bytes */
+		u32 maxFileSize = 5 * 1024 * 1024;
+		/** Number of rotated files kept. The newest one is "log.1.txt" */
+		u32 maxFiles = 3;
+		/** Console output. Without it, binary logs don't need to format messages at all */
+		bool bConsole = true;
+
+		/**
+		 * Messages are stored in a buffer per thread and formatted and written from a backend
+		 * thread. Arguments that are not numbers, pointers or strings are still formatted by
+		 * the calling thread. Messages still in the buffers are lost if the process crashes
+		 */
+		bool bAsync = false;
+
+		/** Size in bytes of the buffer of each thread. Rounded up to a power of two */
+		u32 threadBufferSize    = 256 * 1024;
+		OverflowPolicy overflow = OverflowPolicy::Block;
+		u32 sampleRate          = 16;
+	};
+
+
+	/** Header of a message in an async buffer. Followed by the arguments of the message */
+	struct Record
+	{
+		/** Total size, including arguments and padding */
+		u32 size;
+		Level level;
+		u8 numArgs;
+		/** The message was formatted by the caller and is stored as the only argument */
+		bool bFormatted;
+		u32 formatSize;
+		/** Format strings are literals, so only the pointer is stored */
+		const TCHAR* format;
+		const Category* category;
+		/** Nanoseconds since epoch in the system clock */
+		i64 time;
+	};
+
+
 	inline std::shared_ptr<spdlog::logger> generalLogger;
 	inline std::shared_ptr<spdlog::logger> errLogger;
 
 
 	void Init(Path logPath = {});
-	void Shutdown();
+	void CORE_API Init(const Settings& settings);
+
+	/** Writes all pending messages and stops async logging. Later messages are written inline */
+	void CORE_API Shutdown();
+
+	/** Waits until all messages logged before the call are written */
+	void CORE_API Flush();
 
-	void CORE_API Info(const String& msg);
-	void CORE_API Warning(const String& msg);
-	void CORE_API Error(const String& msg);
+	bool CORE_API IsAsync();
 
+	/**
+	 * Reserves size bytes in the async buffer of this thread, with size and time filled.
+	 * Must be followed by EndRecord.
+	 * @return null if the message should be discarded, or be written inline when async logging
+	 * stopped
+	 */
+	CORE_API Record* BeginRecord(u32 size);
+	CORE_API void EndRecord(Record* record);
+
+	inline void SetLevel(Level level)
+	{
+		general.SetLevel(level);
+	}
+
+	inline Level GetLevel()
+	{
+		return general.GetLevel();
+	}
+
+	/**
+	 * Checking before building expensive arguments avoids their cost when disabled.
+	 * Levels compiled out are always disabled
+	 */
+	template <Level level>
+	bool IsEnabled(const Category& category = general)
+	{
+		return level >= compiledLevel && category.IsEnabled(level);
+	}
+
+	/** Sends a message to the sinks (or the async buffer) without checking its level */
+	void CORE_API Write(Level level, const Category& category, StringView msg);
+
+	/** Stores a message to be formatted by the async backend */
 	template <typename... Args>
-	void Info(StringView format, Args... args)
+	void Push(Level level, const Category& category, FormatString<Args...> format, Args&&... args)
+	{
+		static_assert(sizeof...(Args) <= 255, "Too many log arguments");
+		if constexpr ((LogArgs::isEncodable<std::remove_cvref_t<Args>> && ...))
+		{
+			const fmt::basic_string_view<TCHAR> formatView = format;
+			const u32 size =
+			    u32(sizeof(Record) + (LogArgs::GetSize(args) + ... + 0) + 7) & ~u32(7);
+			Record* const record = BeginRecord(size);
+			if (!record)
+			{
+				// Async logging stopped after the caller checked it
+				if (!IsAsync())
+				{
+					ScratchBuffer message;
+					CString::FormatTo(message.Get(), format, Forward<Args>(args)...);
+					Write(level, category, message.ToView());
+				}
+				return;
+			}
+
+			record->level      = level;
+			record->numArgs    = u8(sizeof...(Args));
+			record->bFormatted = false;
+			record->formatSize = u32(formatView.size());
+			record->format     = formatView.data();
+			record->category   = &category;
+			u8* out            = reinterpret_cast<u8*>(record + 1);
+			((out = LogArgs::Encode(out, args)), ...);
+			EndRecord(record);
+		}
+		else
+		{
+			ScratchBuffer message;
+			CString::FormatTo(message.Get(), format, Forward<Args>(args)...);
+			Write(level, category, message.ToView());
+		}
+	}
+
+
+	// Disabled levels return before formatting. Arguments are only referenced, never copied.
+	// In async mode arguments are stored and formatted by the backend. Otherwise messages are
+	// formatted once into a thread-local buffer and passed as they are to the sinks
+
+	template <Level level, typename... Args>
+	void Write(const Category& category, FormatString<Args...> format, Args&&... args)
 	{
-		if (!format.empty())
+		if constexpr (level >= compiledLevel)
 		{
-			Info(CString::Format(format, std::forward<Args>(args)...));
+			if (category.IsEnabled(level)) [[unlikely]]
+			{
+				if (IsAsync())
+				{
+					Push<Args...>(level, category, format, Forward<Args>(args)...);
+					return;
+				}
+				ScratchBuffer message;
+				CString::FormatTo(message.Get(), format, Forward<Args>(args)...);
+				Write(level, category, message.ToView());
+			}
 		}
 	}
 
-	template <typename... Args>
-	void Warning(StringView format, Args... args)
+	inline void Verbose(StringView msg)
 	{
-		if (!format.empty())
+		if (IsEnabled<Level::Verbose>())
 		{
-			Warning(CString::Format(format, std::forward<Args>(args)...));
+			Write(Level::Verbose, general, msg);
 		}
 	}
 
-	template <typename... Args>
-	void Error(StringView format, Args... args)
+	inline void Info(StringView msg)
+	{
+		if (IsEnabled<Level::Info>())
+		{
+			Write(Level::Info, general, msg);
+		}
+	}
+
+	inline void Warning(StringView msg)
+	{
+		if (IsEnabled<Level::Warning>())
+		{
+			Write(Level::Warning, general, msg);
+		}
+	}
+
+	inline void Error(StringView msg)
 	{
-		if (!format.empty())
+		if (IsEnabled<Level::Error>())
 		{
-			Error(CString::Format(format, std::forward<Args>(args)...));
+			Write(Level::Error, general, msg);
 		}
 	}
+
+	template <typename... Args>
+	void Verbose(FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Verbose, Args...>(general, format, Forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	void Info(FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Info, Args...>(general, format, Forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	void Warning(FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Warning, Args...>(general, format, Forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	void Error(FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Error, Args...>(general, format, Forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	void Verbose(const Category& category, FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Verbose, Args...>(category, format, Forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	void Info(const Category& category, FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Info, Args...>(category, format, Forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	void Warning(const Category& category, FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Warning, Args...>(category, format, Forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	void Error(const Category& category, FormatString<Args...> format, Args&&... args)
+	{
+		Write<Level::Error, Args...>(category, format, Forward<Args>(args)...);
+	}
 };	  // namespace Rift::Log
@@ -0,0 +1,140 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Files/FileSystem.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <mutex>
+
+
+namespace Rift::Log
+{
+	/**
+	 * Binary log files store messages without formatting them:
+	 *   Header: magic, version and pointer size
+	 *   Format: id and text of a format string, written the first time it is used
+	 *   Category: id and name of a category, written the first time it is used
+	 *   Message: level, format id, category id, time since the previous message, thread id if
+	 *            it changed and the arguments
+	 * Times are microseconds since epoch in the system clock. The first message of a file stores
+	 * its time since epoch.
+	 * Arguments are stored as LogArgs does, but with variable length integers. Numbers are little
+	 * endian. Ids, times and sizes are variable length integers.
+	 */
+	namespace BinaryLog
+	{
+		static constexpr u32 magic   = 0x474F4C52;    // "RLOG"
+		static constexpr u16 version = 1;
+		/** Set in the level of a message when its thread id is written */
+		static constexpr u8 newThreadFlag = 0x80;
+
+		enum class EntryType : u8
+		{
+			Format,
+			Category,
+			Message
+		};
+	}    // namespace BinaryLog
+
+
+	class CORE_API BinaryLogWriter
+	{
+		std::FILE* file = nullptr;
+		std::mutex mutex;
+		Path filePath;
+		u64 maxFileSize     = 0;
+		u32 maxRotatedFiles = 0;
+		u64 written         = 0;
+		TMap<const TCHAR*, u32> formatIds;
+		TMap<const Category*, u32> categoryIds;
+		// Microseconds since epoch of the last message written
+		i64 lastTime       = 0;
+		sizet lastThreadId = 0;
+		TArray<u8> entry;
+
+
+	public:
+		BinaryLogWriter() = default;
+		~BinaryLogWriter();
+		BinaryLogWriter(const BinaryLogWriter&) = delete;
+		BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+		/**
+		 * Opens a new log file. Previous files are rotated first, so that path.rlog becomes
+		 * path.1.rlog and so on, keeping up to maxFiles of them. The file is rotated again once
+		 * it reaches maxSize bytes
+		 */
+		bool Open(const Path& path, u64 maxSize = 5 * 1024 * 1024, u32 maxFiles = 3);
+		void Close();
+		void Flush();
+
+		bool IsOpen() const
+		{
+			return file != nullptr;
+		}
+
+		/** Writes a record as it is. Formatted records are stored as a "{}" format */
+		void Write(const Record& record, sizet threadId);
+
+		/** Writes an already formatted message */
+		void Write(Level level, const Category& category, StringView msg, i64 time, sizet threadId);
+
+		/** @return path of the rotated file of an index. Index 0 is the current file */
+		static Path GetRotatedPath(const Path& path, u32 index);
+
+	private:
+		bool OpenFile();
+		void CloseFile();
+		/** Writes entry, and rotates the file if it got too big and the message is complete */
+		void WriteEntry(bool bEndsMessage = false);
+		u32 GetFormatId(const TCHAR* format, u32 formatSize);
+		u32 GetCategoryId(const Category& category);
+		/** Fills entry with the header of a message. Arguments are appended after it */
+		void BeginMessage(
+		    Level level, u32 formatId, u32 categoryId, i64 time, sizet threadId, u8 numArgs);
+	};
+
+
+	struct CORE_API BinaryLogMessage
+	{
+		/** Nanoseconds since epoch in the system clock, with microsecond precision */
+		i64 time     = 0;
+		u64 threadId = 0;
+		Level level  = Level::Info;
+		StringView category;
+		StringView format;
+		u8 numArgs = 0;
+		/** Arguments as encoded by LogArgs. Valid until the next message is read */
+		const u8* args = nullptr;
+
+
+		/** @return the formatted message, without time, level or category */
+		String ToString() const;
+	};
+
+
+	class CORE_API BinaryLogReader
+	{
+		TArray<u8> data;
+		sizet position   = 0;
+		i64 lastTime     = 0;
+		u64 lastThreadId = 0;
+		TArray<String> formats;
+		TArray<u8> args;
+		TArray<String> categories;
+
+
+	public:
+		/** @return false if the file can't be read or is not a binary log */
+		bool Open(const Path& path);
+
+		/** Reads the next message. @return false at the end of the file or if it is corrupted */
+		bool Next(BinaryLogMessage& message);
+	};
+}    // namespace Rift::Log
@@ -0,0 +1,249 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Strings/StringView.h"
+
+#include <cstring>
+#include <type_traits>
+
+
+namespace Rift::Log
+{
+	/** Type of an argument stored in a log record */
+	enum class ArgType : u8
+	{
+		Bool,
+		Char,
+		Int,
+		UInt,
+		Float,
+		Double,
+		Pointer,
+		String
+	};
+
+
+	/**
+	 * Stores format arguments as bytes so that messages can be formatted later, or never.
+	 * Each argument is an ArgType followed by its value. Strings are stored as a u32 size
+	 * followed by their characters.
+	 */
+	namespace LogArgs
+	{
+		template <typename T>
+		static constexpr bool isString = std::is_convertible_v<const T&, StringView>;
+
+		template <typename T>
+		static constexpr bool isPointer =
+		    std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, void*>
+		    || std::is_same_v<T, const void*>;
+
+		/** True if T can be stored. Other types are formatted when logged */
+		template <typename T>
+		static constexpr bool isEncodable =
+		    std::is_arithmetic_v<T> || isPointer<T> || isString<T>;
+
+
+		template <typename T>
+		constexpr ArgType GetType()
+		{
+			if constexpr (std::is_same_v<T, bool>)
+			{
+				return ArgType::Bool;
+			}
+			else if constexpr (std::is_same_v<T, TCHAR>)
+			{
+				return ArgType::Char;
+			}
+			else if constexpr (std::is_integral_v<T>)
+			{
+				return std::is_signed_v<T> ? ArgType::Int : ArgType::UInt;
+			}
+			else if constexpr (std::is_same_v<T, float>)
+			{
+				return ArgType::Float;
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				return ArgType::Double;
+			}
+			else if constexpr (isPointer<T>)
+			{
+				return ArgType::Pointer;
+			}
+			else
+			{
+				return ArgType::String;
+			}
+		}
+
+		/** Size in bytes of the value of an argument, excluding strings */
+		constexpr sizet GetValueSize(ArgType type)
+		{
+			switch (type)
+			{
+				case ArgType::Bool:
+				case ArgType::Char: return 1;
+				case ArgType::Float: return sizeof(float);
+				case ArgType::Pointer: return sizeof(void*);
+				case ArgType::String: return sizeof(u32);
+				default: return 8;
+			}
+		}
+
+		/** Null C strings are stored as "(null)" */
+		template <typename T>
+		StringView ToStringView(const T& value)
+		{
+			if constexpr (std::is_pointer_v<T>)
+			{
+				return value ? StringView{value} : StringView{"(null)"};
+			}
+			else
+			{
+				return StringView{value};
+			}
+		}
+
+		template <typename T>
+		sizet GetSize(const T& value)
+		{
+			constexpr ArgType type = GetType<std::remove_cvref_t<T>>();
+			if constexpr (type == ArgType::String)
+			{
+				return 1 + sizeof(u32) + ToStringView(value).size() * sizeof(TCHAR);
+			}
+			else
+			{
+				return 1 + GetValueSize(type);
+			}
+		}
+
+		template <typename Value>
+		u8* WriteValue(u8* out, Value value)
+		{
+			std::memcpy(out, &value, sizeof(Value));
+			return out + sizeof(Value);
+		}
+
+		/** Writes an argument into out. @return the end of the written bytes */
+		template <typename T>
+		u8* Encode(u8* out, const T& value)
+		{
+			constexpr ArgType type = GetType<std::remove_cvref_t<T>>();
+			*out++                 = u8(type);
+			if constexpr (type == ArgType::Bool || type == ArgType::Char)
+			{
+				return WriteValue(out, value);
+			}
+			else if constexpr (type == ArgType::Int)
+			{
+				return WriteValue(out, i64(value));
+			}
+			else if constexpr (type == ArgType::UInt)
+			{
+				return WriteValue(out, u64(value));
+			}
+			else if constexpr (type == ArgType::Float)
+			{
+				return WriteValue(out, value);
+			}
+			else if constexpr (type == ArgType::Double)
+			{
+				return WriteValue(out, double(value));
+			}
+			else if constexpr (type == ArgType::Pointer)
+			{
+				return WriteValue(out, static_cast<const void*>(value));
+			}
+			else
+			{
+				const StringView str = ToStringView(value);
+				out = WriteValue(out, u32(str.size()));
+				std::memcpy(out, str.data(), str.size() * sizeof(TCHAR));
+				return out + str.size() * sizeof(TCHAR);
+			}
+		}
+
+		template <typename Value>
+		const u8* ReadValue(const u8* in, Value& value)
+		{
+			std::memcpy(&value, in, sizeof(Value));
+			return in + sizeof(Value);
+		}
+
+		/**
+		 * Reads an argument and calls visitor with its value: bool, TCHAR, i64, u64, float,
+		 * double, const void* or StringView.
+		 * @return the end of the argument
+		 */
+		template <typename Visitor>
+		const u8* Decode(const u8* in, Visitor&& visitor)
+		{
+			const ArgType type = ArgType(*in++);
+			switch (type)
+			{
+				case ArgType::Bool:
+				{
+					bool value;
+					in = ReadValue(in, value);
+					visitor(value);
+					return in;
+				}
+				case ArgType::Char:
+				{
+					TCHAR value;
+					in = ReadValue(in, value);
+					visitor(value);
+					return in;
+				}
+				case ArgType::Int:
+				{
+					i64 value;
+					in = ReadValue(in, value);
+					visitor(value);
+					return in;
+				}
+				case ArgType::UInt:
+				{
+					u64 value;
+					in = ReadValue(in, value);
+					visitor(value);
+					return in;
+				}
+				case ArgType::Float:
+				{
+					float value;
+					in = ReadValue(in, value);
+					visitor(value);
+					return in;
+				}
+				case ArgType::Double:
+				{
+					double value;
+					in = ReadValue(in, value);
+					visitor(value);
+					return in;
+				}
+				case ArgType::Pointer:
+				{
+					const void* value;
+					in = ReadValue(in, value);
+					visitor(value);
+					return in;
+				}
+				case ArgType::String:
+				{
+					u32 size;
+					in = ReadValue(in, size);
+					visitor(StringView{reinterpret_cast<const TCHAR*>(in), size});
+					return in + size * sizeof(TCHAR);
+				}
+			}
+			return in;
+		}
+	}    // namespace LogArgs
+}    // namespace Rift::Log
@@ -4,15 +4,23 @@
 
 #include "PCH.h"
 
+#include "Math/Math.h"
 #include "Misc/Utility.h"
 
 
 namespace Rift::Algorithms
 {
-	template <typename Index>
+	/**
+	 * Heap helpers are parametrized by Arity (children per node). Arity 2 is a classic binary
+	 * heap. Higher arities (like 4) make the heap shallower and keep all children of a node in
+	 * the same cache line, at the cost of more comparisons per level when sifting down.
+	 */
+
+	template <u32 Arity = 2, typename Index>
 	Index HeapGetLeftChildIndex(Index index)
 	{
-		return index * 2 + 1;
+		static_assert(Arity >= 2, "Heaps need at least two children per node");
+		return index * Index(Arity) + 1;
 	}
 
 	/**
@@ -21,50 +29,60 @@ namespace Rift::Algorithms
 	 * @param	index Node index.
 	 * @returns	true if node is a leaf, false otherwise.
 	 */
-	template <typename Index>
+	template <u32 Arity = 2, typename Index>
 	bool HeapIsLeaf(Index index, Index size)
 	{
-		return HeapGetLeftChildIndex(index) >= size;
+		return HeapGetLeftChildIndex<Arity>(index) >= size;
 	}
 
 	/** @return the parent index of a node at Index. */
-	template <typename Index>
+	template <u32 Arity = 2, typename Index>
 	Index HeapGetParentIndex(Index index)
 	{
-		return (index - 1) / 2;
+		return (index - 1) / Index(Arity);
 	}
 
-	template <typename T, typename Index, typename Predicate>
-	void HeapSiftDown(T* heap, Index index, const Index count, const Predicate& predicate)
+	/** @return the index of the child that should be closest to the root. Node can't be a leaf */
+	template <u32 Arity = 2, typename T, typename Index, typename Predicate>
+	Index HeapGetBestChildIndex(T* heap, Index index, const Index count, const Predicate& predicate)
 	{
-		while (!HeapIsLeaf(index, count))
-		{
-			const Index leftChildIndex  = HeapGetLeftChildIndex(index);
-			const Index rightChildIndex = leftChildIndex + 1;
+		const Index firstChildIndex = HeapGetLeftChildIndex<Arity>(index);
+		const Index lastChildIndex  = Math::Min(firstChildIndex + Index(Arity), count);
 
-			Index minChildIndex = leftChildIndex;
-			if (rightChildIndex < index)
+		Index bestChildIndex = firstChildIndex;
+		for (Index i = firstChildIndex + 1; i < lastChildIndex; ++i)
+		{
+			if (predicate(heap[i], heap[bestChildIndex]))
 			{
-				minChildIndex = predicate(heap[leftChildIndex], heap[rightChildIndex])
-				                    ? leftChildIndex
-				                    : rightChildIndex;
+				bestChildIndex = i;
 			}
-			if (!predicate(heap[minChildIndex], heap[index]))
+		}
+		return bestChildIndex;
+	}
+
+	template <u32 Arity = 2, typename T, typename Index, typename Predicate>
+	void HeapSiftDown(T* heap, Index index, const Index count, const Predicate& predicate)
+	{
+		while (!HeapIsLeaf<Arity>(index, count))
+		{
+			const Index bestChildIndex =
+			    HeapGetBestChildIndex<Arity>(heap, index, count, predicate);
+			if (!predicate(heap[bestChildIndex], heap[index]))
 			{
 				break;
 			}
 
-			Swap(heap[index], heap[minChildIndex]);
-			index = minChildIndex;
+			Swap(heap[index], heap[bestChildIndex]);
+			index = bestChildIndex;
 		}
 	}
 
-	template <typename T, typename Index, typename Predicate>
+	template <u32 Arity = 2, typename T, typename Index, typename Predicate>
 	Index HeapSiftUp(T* heap, Index rootIndex, Index nodeIndex, const Predicate& predicate)
 	{
 		while (nodeIndex > rootIndex)
 		{
-			i32 parentIndex = HeapGetParentIndex(nodeIndex);
+			const Index parentIndex = HeapGetParentIndex<Arity>(nodeIndex);
 			if (!predicate(heap[nodeIndex], heap[parentIndex]))
 			{
 				break;
@@ -76,12 +94,17 @@ namespace Rift::Algorithms
 		return nodeIndex;
 	}
 
-	template <typename T, typename Index, typename Predicate>
+	template <u32 Arity = 2, typename T, typename Index, typename Predicate>
 	void Heapify(T* first, Index size, Predicate predicate)
 	{
-		for (Index i = HeapGetParentIndex(size - 1); i >= 0; --i)
+		if (size < 2)
+		{
+			return;
+		}
+
+		for (Index i = HeapGetParentIndex<Arity>(size - 1); i >= 0; --i)
 		{
-			HeapSiftDown(first, i, size, predicate);
+			HeapSiftDown<Arity>(first, i, size, predicate);
 		}
 	}
 
@@ -48,8 +48,25 @@ namespace Rift::Memory
 
 		void Reset();
 
+		/**
+		 * Frees all allocations but keeps the memory for reuse. If the arena grew, its blocks are
+		 * replaced by one that fits all they held
+		 */
+		void Rewind();
+
 		void Grow(sizet size, sizet align = 0);
 
+		/** @return used size, counting blocks left behind when growing as fully used */
+		sizet GetUsedSize() const
+		{
+			sizet size = usedBlockSize;
+			for (const HeapBlock& block : discardedBlocks)
+			{
+				size += block.GetSize();
+			}
+			return size;
+		}
+
 		sizet GetUsedBlockSize() const
 		{
 			return usedBlockSize;
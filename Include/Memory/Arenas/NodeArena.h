@@ -0,0 +1,58 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Memory/Arenas/IArena.h"
+
+#include <mutex>
+
+
+namespace Rift::Memory
+{
+	/**
+	 * NodeArena allocates linearly, like LinearArena, from blocks placed in the memory of one
+	 * NUMA node. It can be used from any thread.
+	 * Individual allocations can't be freed, only all of them with Reset.
+	 */
+	class CORE_API NodeArena : public IArena
+	{
+		struct NodeBlock
+		{
+			u8* data   = nullptr;
+			sizet size = 0;
+		};
+
+		u32 node        = 0;
+		sizet blockSize = 0;
+		std::mutex mutex;
+		TArray<NodeBlock> blocks;
+		sizet usedBlockSize = 0;
+
+
+	public:
+		NodeArena(u32 node, sizet blockSize = 1024 * 1024) : node{node}, blockSize{blockSize} {}
+		~NodeArena()
+		{
+			Reset();
+		}
+		NodeArena(const NodeArena&) = delete;
+		NodeArena& operator=(const NodeArena&) = delete;
+
+		void* Allocate(const sizet size) override
+		{
+			return Allocate(size, alignof(std::max_align_t));
+		}
+		void* Allocate(const sizet size, sizet alignment) override;
+
+		void Free(void* ptr) override {}
+
+		void Reset();
+
+		u32 GetNode() const
+		{
+			return node;
+		}
+	};
+}    // namespace Rift::Memory
@@ -4,7 +4,7 @@
 
 #include "PCH.h"
 
-#include "Misc/Crc.h"
+#include "Misc/Hash.h"
 #include "Reflection/ClassTraits.h"
 #include "Reflection/ReflectionTypeTraits.h"
 #include "Strings/Name.h"
@@ -306,7 +306,7 @@ namespace Rift
 	{
 		sizet operator()(const Guid& k) const
 		{
-			return Crc::MemCrc32(&k, sizeof(Guid));
+			return HashBytes(&k, sizeof(Guid));
 		}
 	};
 }    // namespace Rift
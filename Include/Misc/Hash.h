@@ -6,20 +6,273 @@
 
 #include "Platform/Platform.h"
 
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#	include <intrin.h>
+#endif
+
 
 namespace Rift
 {
 	template <typename T>
 	struct Hash : robin_hood::hash<T>
 	{
-		sizet operator()(T const& obj)
+		sizet operator()(T const& obj) const
 		{
 			return robin_hood::hash<T>::operator()(obj);
 		}
 	};
 
+
+	/**
+	 * 64-bit hash based on wyhash (https://github.com/wangyi-fudan/wyhash).
+	 * Reads 8 bytes at a time and mixes with a 64x64->128 bit multiply, so it is limited by the
+	 * multiplier rather than by loads, and vector paths would not make it faster.
+	 * Works at compile time for strings. Runtime and compile time results are the same.
+	 */
+	namespace HashImpl
+	{
+		static constexpr u64 secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+		    0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+		constexpr void Mum(u64& a, u64& b)
+		{
+#if defined(__SIZEOF_INT128__)
+			__uint128_t r = a;
+			r *= b;
+			a = u64(r);
+			b = u64(r >> 64);
+#else
+#	if defined(_MSC_VER) && defined(_M_X64)
+			if (!std::is_constant_evaluated())
+			{
+				a = _umul128(a, b, &b);
+				return;
+			}
+#	endif
+			const u64 ha = a >> 32, hb = b >> 32, la = u32(a), lb = u32(b);
+			const u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+			const u64 t  = rl + (rm0 << 32);
+			u64 c        = t < rl;
+			const u64 lo = t + (rm1 << 32);
+			c += lo < t;
+			a = lo;
+			b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+		}
+
+		constexpr u64 Mix(u64 a, u64 b)
+		{
+			Mum(a, b);
+			return a ^ b;
+		}
+
+		/** Byte of a string as if it was in memory, little endian */
+		template <typename Char>
+		constexpr u8 GetByte(const Char* data, sizet offset)
+		{
+			using Unsigned = std::make_unsigned_t<Char>;
+			return u8(Unsigned(data[offset / sizeof(Char)]) >> (8 * (offset % sizeof(Char))));
+		}
+
+		template <typename Char, sizet Size>
+		constexpr u64 Read(const Char* data, sizet offset)
+		{
+			if (std::is_constant_evaluated())
+			{
+				u64 value = 0;
+				for (sizet i = 0; i < Size; ++i)
+				{
+					value |= u64(GetByte(data, offset + i)) << (8 * i);
+				}
+				return value;
+			}
+
+			std::conditional_t<Size == 8, u64, u32> value;
+			std::memcpy(&value, reinterpret_cast<const u8*>(data) + offset, Size);
+			return value;
+		}
+
+		template <typename Char>
+		constexpr u64 Read3(const Char* data, sizet offset, sizet size)
+		{
+			return (u64(GetByte(data, offset)) << 16)
+			     | (u64(GetByte(data, offset + (size >> 1))) << 8)
+			     | u64(GetByte(data, offset + size - 1));
+		}
+
+		/** Hash of up to 16 bytes, or the last 16 bytes of bigger inputs */
+		template <typename Char>
+		constexpr u64 Finish(const Char* data, sizet offset, sizet size, u64 totalSize, u64 seed)
+		{
+			u64 a = 0, b = 0;
+			if (totalSize <= 16)
+			{
+				if (size >= 4)
+				{
+					const sizet middle = (size >> 3) << 2;
+					a = (Read<Char, 4>(data, offset) << 32) | Read<Char, 4>(data, offset + middle);
+					b = (Read<Char, 4>(data, offset + size - 4) << 32)
+					  | Read<Char, 4>(data, offset + size - 4 - middle);
+				}
+				else if (size > 0)
+				{
+					a = Read3(data, offset, size);
+				}
+			}
+			else
+			{
+				while (size > 16)
+				{
+					seed = Mix(Read<Char, 8>(data, offset) ^ secret[1],
+					    Read<Char, 8>(data, offset + 8) ^ seed);
+					offset += 16;
+					size -= 16;
+				}
+				// May read back into already mixed bytes
+				a = Read<Char, 8>(data, offset + size - 16);
+				b = Read<Char, 8>(data, offset + size - 8);
+			}
+
+			a ^= secret[1];
+			b ^= seed;
+			Mum(a, b);
+			return Mix(a ^ secret[0] ^ totalSize, b ^ secret[1]);
+		}
+
+		/** Mixes a 48 byte stripe */
+		template <typename Char>
+		constexpr void MixStripe(const Char* data, sizet offset, u64& seed, u64& see1, u64& see2)
+		{
+			seed = Mix(
+			    Read<Char, 8>(data, offset) ^ secret[1], Read<Char, 8>(data, offset + 8) ^ seed);
+			see1 = Mix(Read<Char, 8>(data, offset + 16) ^ secret[2],
+			    Read<Char, 8>(data, offset + 24) ^ see1);
+			see2 = Mix(Read<Char, 8>(data, offset + 32) ^ secret[3],
+			    Read<Char, 8>(data, offset + 40) ^ see2);
+		}
+
+		constexpr u64 InitSeed(u64 seed)
+		{
+			return seed ^ Mix(seed ^ secret[0], secret[1]);
+		}
+
+		/** @param size in bytes */
+		template <typename Char>
+		constexpr u64 HashData(const Char* data, sizet size, u64 seed)
+		{
+			seed         = InitSeed(seed);
+			sizet offset = 0;
+			if (size > 48)
+			{
+				u64 see1 = seed, see2 = seed;
+				do
+				{
+					MixStripe(data, offset, seed, see1, see2);
+					offset += 48;
+				} while (size - offset > 48);
+				seed ^= see1 ^ see2;
+			}
+			return Finish(data, offset, size - offset, size, seed);
+		}
+	}    // namespace HashImpl
+
+
+	inline u64 HashBytes64(void const* ptr, sizet const len, u64 seed = 0) noexcept
+	{
+		return HashImpl::HashData(static_cast<const u8*>(ptr), len, seed);
+	}
+
 	inline sizet HashBytes(void const* ptr, sizet const len) noexcept
 	{
-		return robin_hood::hash_bytes(ptr, len);
+		return sizet(HashBytes64(ptr, len));
+	}
+
+	/**
+	 * Hash of a string of size characters. Can be evaluated at compile time, giving the same
+	 * result as HashBytes over the same characters.
+	 */
+	constexpr sizet HashString(const TCHAR* str, sizet const size) noexcept
+	{
+		return sizet(HashImpl::HashData(str, size * sizeof(TCHAR), 0));
 	}
+
+
+	/**
+	 * Hashes data received in pieces. The result is the same as hashing all of it at once with
+	 * HashBytes64, without keeping it in memory.
+	 */
+	struct StreamHasher
+	{
+	private:
+		static constexpr sizet stripeSize  = 48;
+		static constexpr sizet historySize = 16;
+
+		u64 seed          = 0;
+		u64 see1          = 0;
+		u64 see2          = 0;
+		u64 totalSize     = 0;
+		sizet pendingSize = 0;
+		// Last 16 mixed bytes followed by the pending bytes. The final step can read back into the
+		// mixed bytes
+		u8 buffer[historySize + stripeSize]{};
+
+
+	public:
+		StreamHasher(u64 inSeed = 0)
+		{
+			seed = see1 = see2 = HashImpl::InitSeed(inSeed);
+		}
+
+		void Update(const void* data, sizet size)
+		{
+			const u8* bytes   = static_cast<const u8*>(data);
+			u8* const pending = buffer + historySize;
+			totalSize += size;
+
+			if (pendingSize > 0 || size <= stripeSize)
+			{
+				const sizet space  = stripeSize - pendingSize;
+				const sizet copied = size < space ? size : space;
+				std::memcpy(pending + pendingSize, bytes, copied);
+				pendingSize += copied;
+				bytes += copied;
+				size -= copied;
+				// A stripe is only mixed once more data comes, since the last one is special
+				if (size == 0)
+				{
+					return;
+				}
+				HashImpl::MixStripe(pending, 0, seed, see1, see2);
+				std::memcpy(buffer, pending + stripeSize - historySize, historySize);
+				pendingSize = 0;
+			}
+
+			if (size > stripeSize)
+			{
+				do
+				{
+					HashImpl::MixStripe(bytes, 0, seed, see1, see2);
+					bytes += stripeSize;
+					size -= stripeSize;
+				} while (size > stripeSize);
+				std::memcpy(buffer, bytes - historySize, historySize);
+			}
+			std::memcpy(pending, bytes, size);
+			pendingSize = size;
+		}
+
+		u64 Finish() const
+		{
+			u64 finalSeed = seed;
+			if (totalSize > stripeSize)
+			{
+				finalSeed ^= see1 ^ see2;
+			}
+			return HashImpl::Finish(
+			    static_cast<const u8*>(buffer), historySize, pendingSize, totalSize, finalSeed);
+		}
+	};
 }    // namespace Rift
@@ -0,0 +1,326 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Math/Math.h"
+#include "Misc/Utility.h"
+#include "Tasks.h"
+
+
+namespace Rift
+{
+	struct ParallelSettings
+	{
+		/** Iterations per task. 0 picks one from the input size and the number of workers */
+		i32 grainSize = 0;
+
+		/**
+		 * Split work into the same chunks independently of the number of workers. Reductions and
+		 * scans then combine in the same order on any machine (relevant for floating point).
+		 */
+		bool bDeterministic = false;
+
+		/** Task system to run on. Uses the one of the Context if null */
+		const TaskSystem* tasks = nullptr;
+
+		/**
+		 * Lane the chunks run in. Normal dispatches them straight to the workers. Other
+		 * priorities queue helper tasks in that lane, so that background work never delays High
+		 * priority tasks. The calling thread runs chunks too
+		 */
+		TaskPriority priority = TaskPriority::Normal;
+	};
+
+
+	namespace Parallel
+	{
+		/** Automatic grain sizes never go below this, so tiny inputs run inline */
+		static constexpr i32 MIN_GRAIN_SIZE = 256;
+		/** Tasks created per worker with automatic grain size, to balance uneven work */
+		static constexpr i32 CHUNKS_PER_WORKER = 4;
+		/** Chunks used for deterministic splits, regardless of the number of workers */
+		static constexpr i32 DETERMINISTIC_CHUNKS = 64;
+
+
+		inline const TaskSystem& GetTasks(const ParallelSettings& settings)
+		{
+			return settings.tasks ? *settings.tasks : TaskSystem::Get();
+		}
+
+		inline i32 GetChunkSize(i32 count, const ParallelSettings& settings)
+		{
+			if (settings.grainSize > 0)
+			{
+				return settings.grainSize;
+			}
+
+			const i32 numChunks =
+			    settings.bDeterministic
+			        ? DETERMINISTIC_CHUNKS
+			        : i32(GetTasks(settings).GetNumWorkerThreads()) * CHUNKS_PER_WORKER;
+			return Math::Max(MIN_GRAIN_SIZE, (count + numChunks - 1) / numChunks);
+		}
+
+		inline i32 GetNumChunks(i32 count, i32 chunkSize)
+		{
+			return (count + chunkSize - 1) / chunkSize;
+		}
+
+		/**
+		 * Runs callback(chunk, begin, end) for each chunk of chunkSize iterations and waits for all
+		 * of them. Runs inline if there is a single chunk or when called from a worker, since
+		 * blocking a worker on other tasks can starve the pool.
+		 */
+		template <typename Callback>
+		void ForEachChunk(
+		    i32 count, i32 chunkSize, const ParallelSettings& settings, Callback&& callback)
+		{
+			const i32 numChunks = GetNumChunks(count, chunkSize);
+			const auto runChunk = [count, chunkSize, &callback](i32 chunk) {
+				const i32 begin = chunk * chunkSize;
+				callback(chunk, begin, Math::Min(begin + chunkSize, count));
+			};
+
+			const TaskSystem* tasks = numChunks > 1 ? &GetTasks(settings) : nullptr;
+			if (!tasks || tasks->IsWorkerThread())
+			{
+				for (i32 chunk = 0; chunk < numChunks; ++chunk)
+				{
+					runChunk(chunk);
+				}
+				return;
+			}
+
+			tasks->Dispatch(numChunks, runChunk, settings.priority);
+		}
+	}    // namespace Parallel
+
+
+	/** Calls callback(begin, end) over contiguous ranges covering [0, count) in parallel */
+	template <typename Callback>
+	void ParallelForRange(i32 count, Callback&& callback, const ParallelSettings& settings = {})
+	{
+		if (count <= 0)
+		{
+			return;
+		}
+		const i32 chunkSize = Parallel::GetChunkSize(count, settings);
+		Parallel::ForEachChunk(count, chunkSize, settings, [&callback](i32, i32 begin, i32 end) {
+			callback(begin, end);
+		});
+	}
+
+	/** Calls callback(index) for every index in [0, count) in parallel */
+	template <typename Callback>
+	void ParallelFor(i32 count, Callback&& callback, const ParallelSettings& settings = {})
+	{
+		ParallelForRange(
+		    count,
+		    [&callback](i32 begin, i32 end) {
+			    for (i32 i = begin; i < end; ++i)
+			    {
+				    callback(i);
+			    }
+		    },
+		    settings);
+	}
+
+	/** Calls callback(item) for every item of an array in parallel */
+	template <typename Type, typename Allocator, typename Callback>
+	void ParallelFor(
+	    TArray<Type, Allocator>& items, Callback&& callback, const ParallelSettings& settings = {})
+	{
+		Type* const data = items.Data();
+		ParallelFor(
+		    items.Size(),
+		    [data, &callback](i32 i) {
+			    callback(data[i]);
+		    },
+		    settings);
+	}
+
+	template <typename Type, typename Allocator, typename Callback>
+	void ParallelFor(const TArray<Type, Allocator>& items, Callback&& callback,
+	    const ParallelSettings& settings = {})
+	{
+		const Type* const data = items.Data();
+		ParallelFor(
+		    items.Size(),
+		    [data, &callback](i32 i) {
+			    callback(data[i]);
+		    },
+		    settings);
+	}
+
+	/** Fills results with callback(item) for every item. results is resized to match items */
+	template <typename Type, typename Allocator, typename Result, typename Callback>
+	void ParallelTransform(const TArray<Type, Allocator>& items, TArray<Result>& results,
+	    Callback&& callback, const ParallelSettings& settings = {})
+	{
+		results.Resize(items.Size());
+		const Type* const data = items.Data();
+		Result* const outputs  = results.Data();
+		ParallelFor(
+		    items.Size(),
+		    [data, outputs, &callback](i32 i) {
+			    outputs[i] = callback(data[i]);
+		    },
+		    settings);
+	}
+
+	/**
+	 * Combines all items with an associative operation, op(a, b). identity must not change the
+	 * result when combined (0 for sums, 1 for products...).
+	 * Partial results are always combined in chunk order. Set bDeterministic to also fix the
+	 * chunks so results don't depend on the number of workers.
+	 */
+	template <typename Type, typename Allocator, typename Operation>
+	Type ParallelReduce(const TArray<Type, Allocator>& items, Type identity, Operation&& op,
+	    const ParallelSettings& settings = {})
+	{
+		const i32 count = items.Size();
+		if (count <= 0)
+		{
+			return identity;
+		}
+
+		const i32 chunkSize = Parallel::GetChunkSize(count, settings);
+		TArray<Type> partials(u32(Parallel::GetNumChunks(count, chunkSize)), identity);
+		const Type* const data  = items.Data();
+		Type* const partialData = partials.Data();
+
+		Parallel::ForEachChunk(count, chunkSize, settings,
+		    [data, partialData, &op](i32 chunk, i32 begin, i32 end) {
+			    Type value = partialData[chunk];
+			    for (i32 i = begin; i < end; ++i)
+			    {
+				    value = op(Move(value), data[i]);
+			    }
+			    partialData[chunk] = Move(value);
+		    });
+
+		Type result = Move(identity);
+		for (Type& partial : partials)
+		{
+			result = op(Move(result), partial);
+		}
+		return result;
+	}
+
+	/**
+	 * Inclusive scan (prefix sum): results[i] = op(items[0], ..., items[i]).
+	 * op must be associative. results is resized to match items.
+	 */
+	template <typename Type, typename Allocator, typename Operation>
+	void ParallelScan(const TArray<Type, Allocator>& items, TArray<Type>& results, Type identity,
+	    Operation&& op, const ParallelSettings& settings = {})
+	{
+		const i32 count = items.Size();
+		results.Resize(count);
+		if (count <= 0)
+		{
+			return;
+		}
+
+		const i32 chunkSize    = Parallel::GetChunkSize(count, settings);
+		const i32 numChunks    = Parallel::GetNumChunks(count, chunkSize);
+		const Type* const data = items.Data();
+		Type* const outputs    = results.Data();
+
+		// Scan each chunk on its own
+		Parallel::ForEachChunk(count, chunkSize, settings,
+		    [data, outputs, &identity, &op](i32, i32 begin, i32 end) {
+			    Type value = identity;
+			    for (i32 i = begin; i < end; ++i)
+			    {
+				    value      = op(Move(value), data[i]);
+				    outputs[i] = value;
+			    }
+		    });
+		if (numChunks <= 1)
+		{
+			return;
+		}
+
+		// Offset of each chunk is the scan of the last value of previous chunks
+		TArray<Type> offsets(u32(numChunks), identity);
+		Type* const offsetData = offsets.Data();
+		for (i32 chunk = 1; chunk < numChunks; ++chunk)
+		{
+			offsetData[chunk] = op(offsetData[chunk - 1], outputs[chunk * chunkSize - 1]);
+		}
+
+		Parallel::ForEachChunk(count, chunkSize, settings,
+		    [outputs, offsetData, &op](i32 chunk, i32 begin, i32 end) {
+			    if (chunk == 0)
+			    {
+				    return;
+			    }
+			    const Type& offset = offsetData[chunk];
+			    for (i32 i = begin; i < end; ++i)
+			    {
+				    outputs[i] = op(offset, outputs[i]);
+			    }
+		    });
+	}
+
+	/**
+	 * @return items for which predicate(item) is true, keeping their order.
+	 * The predicate is called once per item.
+	 */
+	template <typename Type, typename Allocator, typename Predicate>
+	TArray<Type> ParallelFilter(const TArray<Type, Allocator>& items, Predicate&& predicate,
+	    const ParallelSettings& settings = {})
+	{
+		TArray<Type> results;
+		const i32 count = items.Size();
+		if (count <= 0)
+		{
+			return results;
+		}
+
+		const i32 chunkSize    = Parallel::GetChunkSize(count, settings);
+		const i32 numChunks    = Parallel::GetNumChunks(count, chunkSize);
+		const Type* const data = items.Data();
+
+		// Flag and count kept items per chunk
+		TArray<u8> keep;
+		keep.Resize(count);
+		TArray<i32> chunkOffsets(u32(numChunks + 1), 0);
+		u8* const keepData = keep.Data();
+		i32* const offsets = chunkOffsets.Data();
+		Parallel::ForEachChunk(count, chunkSize, settings,
+		    [data, keepData, offsets, &predicate](i32 chunk, i32 begin, i32 end) {
+			    i32 kept = 0;
+			    for (i32 i = begin; i < end; ++i)
+			    {
+				    keepData[i] = predicate(data[i]) ? 1 : 0;
+				    kept += keepData[i];
+			    }
+			    offsets[chunk + 1] = kept;
+		    });
+
+		for (i32 chunk = 1; chunk <= numChunks; ++chunk)
+		{
+			offsets[chunk] += offsets[chunk - 1];
+		}
+
+		// Compact kept items into their final positions
+		results.Resize(offsets[numChunks]);
+		Type* const outputs = results.Data();
+		Parallel::ForEachChunk(count, chunkSize, settings,
+		    [data, keepData, offsets, outputs](i32 chunk, i32 begin, i32 end) {
+			    i32 index = offsets[chunk];
+			    for (i32 i = begin; i < end; ++i)
+			    {
+				    if (keepData[i])
+				    {
+					    outputs[index++] = data[i];
+				    }
+			    }
+		    });
+		return results;
+	}
+}    // namespace Rift
@@ -0,0 +1,43 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+
+
+namespace Rift
+{
+	struct NumaNode
+	{
+		/** Id of the node in the OS. Ids can have gaps */
+		u32 id = 0;
+		/** Logical cpus of the node */
+		TArray<u32> cpus;
+	};
+
+
+	struct CORE_API PlatformProcess
+	{
+		/**
+		 * @return NUMA nodes with cpus. Nodes with only memory are skipped. Platforms without
+		 * NUMA information report a single node with every cpu
+		 */
+		static TArray<NumaNode> GetNumaNodes();
+
+		/**
+		 * Restricts the calling thread to run on the given logical cpus
+		 * @return false if the platform doesn't support it
+		 */
+		static bool SetThreadAffinity(const TArray<u32>& cpus);
+
+		/**
+		 * Allocates pages preferably from the memory of a NUMA node. Falls back to any memory
+		 * if the node has none left or the platform doesn't support it.
+		 * Must be freed with FreeOnNode and the same size.
+		 */
+		static void* AllocateOnNode(sizet size, u32 node);
+		static void FreeOnNode(void* ptr, sizet size);
+	};
+}    // namespace Rift
@@ -85,7 +85,7 @@ public:
 	static Rift::Refl::TClass<ThisType>* InitType()                                         \
 	{                                                                                       \
 		static TypeBuilder builder{                                                         \
-		    TX(__FILE__), __LINE__, Rift::Name{TX(#type)}, [](auto& builder) {              \
+		    TX(__FILE__), __LINE__, Rift::StaticName<TX(#type)>(), [](auto& builder) {      \
 			    __ReflBuildProperty(builder, Rift::Refl::MetaCounter<0>{});                 \
 		    }};                                                                             \
 		return builder.GetType();                                                           \
@@ -149,7 +149,7 @@ public:
 	static Rift::Refl::TStruct<ThisType>* InitType()                                        \
 	{                                                                                       \
 		static TypeBuilder builder{                                                         \
-		    TX(__FILE__), __LINE__, Rift::Name{TX(#type)}, [](auto& builder) {              \
+		    TX(__FILE__), __LINE__, Rift::StaticName<TX(#type)>(), [](auto& builder) {      \
 			    __ReflBuildProperty(builder, Rift::Refl::MetaCounter<0>{});                 \
 		    }};                                                                             \
 		return builder.GetType();                                                           \
@@ -178,9 +178,10 @@ public:
 	static void __ReflBuildProperty(TypeBuilder& builder, Rift::Refl::MetaCounter<id_name>)   \
 	{                                                                                         \
 		constexpr Rift::ReflectionTags tags = Rift::ReflectionTagsInitializer<inTags>::value; \
-		builder.AddProperty<type, tags>(TX(#name), [](void* instance) {                       \
-			return &static_cast<ThisType*>(instance)->name;                                   \
-		});                                                                                   \
+		builder.AddProperty<type, tags>(                                                      \
+		    Rift::StaticName<TX(#name)>(), [](void* instance) {                               \
+			    return &static_cast<ThisType*>(instance)->name;                               \
+		    });                                                                               \
                                                                                               \
 		/* Registry next property if any */                                                   \
 		__ReflBuildProperty(builder, Rift::Refl::MetaCounter<(id_name) + 1>{});               \
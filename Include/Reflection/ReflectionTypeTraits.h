@@ -70,7 +70,7 @@ namespace Rift
 				return {CString::Format(
 				    TX("TArray<{}>"), GetReflectedName<typename T::ItemType>().ToString())};
 			}
-			return TX("TArray<Invalid>");
+			return StaticName<TX("TArray<Invalid>")>();
 		}
 		else if constexpr (IsAsset<T>())
 		{
@@ -82,20 +82,19 @@ namespace Rift
 		{
 			return T::StaticType()->GetName();
 		}
-		return TX("Invalid");
+		return StaticName<TX("Invalid")>();
 	}
 }    // namespace Rift
 
 
-#define DECLARE_REFLECTED_TYPE(Type)           \
-	template <>                                \
-	inline constexpr bool IsReflected<Type>()  \
-	{                                          \
-		return true;                           \
-	}                                          \
-	template <>                                \
-	inline Name GetReflectedName<Type>()       \
-	{                                          \
-		static const Name typeName{TX(#Type)}; \
-		return typeName;                       \
+#define DECLARE_REFLECTED_TYPE(Type)          \
+	template <>                               \
+	inline constexpr bool IsReflected<Type>() \
+	{                                         \
+		return true;                          \
+	}                                         \
+	template <>                               \
+	inline Name GetReflectedName<Type>()      \
+	{                                         \
+		return StaticName<TX(#Type)>();       \
 	}
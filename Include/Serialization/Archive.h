@@ -155,6 +155,10 @@ namespace Rift
 		{
 			return baseData;
 		}
+		Json& GetData()
+		{
+			return baseData;
+		}
 
 		i32 GetIndent() const
 		{
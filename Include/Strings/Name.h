@@ -8,8 +8,9 @@
 #include "Reflection/ClassTraits.h"
 #include "String.h"
 
-#include <tsl/robin_set.h>
+#include <tsl/robin_map.h>
 
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
 
@@ -18,72 +19,100 @@ namespace Rift
 {
 	struct Name;
 
-	/** Represents an string with an already hashed value */
-	struct NameKey
-	{
-	private:
-		static constexpr Hash<String> hasher{};
 
-		String str;
+	/**
+	 * A string literal with its hash, both computed at compile time.
+	 * Can be used as a template parameter: StaticName<TX("Foo")>()
+	 */
+	template <sizet N>
+	struct TStaticName
+	{
+		TCHAR chars[N]{};
 		sizet hash = 0;
 
-	public:
-		NameKey() = default;
-		NameKey(sizet hash) : hash{hash} {}
-		NameKey(StringView inStr) : str{inStr}, hash{hasher(str)} {}
 
-		NameKey(const NameKey& other) : hash{other.hash} {}
-		NameKey(NameKey&& other) noexcept : str{Move(other.str)}, hash{other.hash} {}
-		NameKey& operator=(const NameKey& other)
+		constexpr TStaticName(const TCHAR (&str)[N])
 		{
-			hash = other.hash;
-			return *this;
+			for (sizet i = 0; i < N; ++i)
+			{
+				chars[i] = str[i];
+			}
+			hash = HashString(chars, N - 1);
 		}
 
-		const String& GetString() const
+		constexpr StringView GetView() const
 		{
-			return str;
-		}
-		const sizet GetHash() const
-		{
-			return hash;
-		}
-
-		bool operator==(const NameKey& other) const
-		{
-			return hash == other.hash;
+			return {chars, N - 1};
 		}
 	};
 
-	template <>
-	struct Hash<NameKey>
+	/**
+	 * Global table storing all names.
+	 * Each distinct string gets a dense id. Registering is sharded by hash so that threads
+	 * registering different names rarely contend, and strings with equal hashes are chained and
+	 * compared, never merged. Strings live in append-only pages that are never moved or freed, so
+	 * resolving an id is lock-free.
+	 */
+	class CORE_API NameTable
 	{
-		sizet operator()(const NameKey& x) const
-		{
-			return x.GetHash();
-		}
-	};
+		friend Name;
 
+		using Id = u32;
 
-	/** Global table storing all names */
-	class NameTable
-	{
-		friend Name;
+		struct Entry
+		{
+			String str;
+			// Next entry in the same shard with the same hash
+			Id nextWithHash = 0;
+		};
 
-		// #TODO: Move to TSet
-		using Container     = tsl::robin_set<NameKey, Hash<NameKey>, std::equal_to<NameKey>>;
-		using Iterator      = Container::iterator;
-		using ConstIterator = Container::const_iterator;
+		struct Shard
+		{
+			// First entry of each hash
+			tsl::robin_map<sizet, Id> firstIds;
+			// Allows sync reads but waits for registries
+			mutable std::shared_mutex mutex;
+		};
 
-		Container table{};
-		// Mutex that allows sync reads but waits for registries
-		mutable std::shared_mutex editTableMutex;
+		static constexpr u32 SHARD_BITS = 4;
+		static constexpr u32 NUM_SHARDS = 1 << SHARD_BITS;
+		static constexpr u32 PAGE_SIZE  = 1024;
+		static constexpr u32 MAX_PAGES  = 4096;
+
+		Shard shards[NUM_SHARDS];
+		std::atomic<Entry*> pages[MAX_PAGES]{};
+		std::mutex pagesMutex;
+		// Id 0 is reserved for none
+		std::atomic<Id> nextId{1};
 
 
 		NameTable() = default;
+		~NameTable();
+
+		Id Register(StringView string);
+		/** @param hash must be HashString of the string */
+		Id Register(StringView string, sizet hash);
+
+		/** Lock-free. Id must have been returned by Register */
+		const String& Find(Id id) const
+		{
+			return GetEntry(id).str;
+		}
+
+		const Entry& GetEntry(Id id) const
+		{
+			const Entry* page = pages[id / PAGE_SIZE].load(std::memory_order_acquire);
+			return page[id % PAGE_SIZE];
+		}
+
+		Shard& GetShard(sizet hash)
+		{
+			// Top bits select the shard, leaving the low bits for the shard's own map
+			return shards[hash >> (sizeof(sizet) * 8 - SHARD_BITS)];
+		}
 
-		sizet Register(StringView string);
-		const String& Find(sizet hash) const;
+		Id FindInShard(const Shard& shard, StringView string, sizet hash) const;
+		Entry& NewEntry(Id id);
 
 		static NameTable& Get()
 		{
@@ -101,7 +130,7 @@ namespace Rift
 	struct CORE_API Name
 	{
 		friend NameTable;
-		using Id = sizet;
+		using Id = NameTable::Id;
 
 	private:
 		static const Id noneId;
@@ -124,6 +153,15 @@ namespace Rift
 #endif
 		}
 		Name(const String& str) : Name(StringView(str)) {}
+		/** Registers with the hash calculated at compile time */
+		template <sizet N>
+		Name(const TStaticName<N>& literal)
+		{
+			id = NameTable::Get().Register(literal.GetView(), literal.hash);
+#if BUILD_DEBUG
+			value = literal.GetView();
+#endif
+		}
 		Name(const Name& other)
 		    : id(other.id)
 #if BUILD_DEBUG
@@ -147,6 +185,7 @@ namespace Rift
 			return *this;
 		}
 
+		/** O(1) and lock-free */
 		const String& ToString() const
 		{
 			return IsNone() ? noneStr : NameTable::Get().Find(id);
@@ -187,6 +226,25 @@ namespace Rift
 
 	DEFINE_CLASS_TRAITS(Name, HasCustomSerialize = true);
 
+
+	/**
+	 * @return the name of a literal. It gets registered the first time this is called, after that
+	 * it only costs a static access and comparing it never touches the table.
+	 */
+	template <TStaticName literal>
+	const Name& StaticName()
+	{
+		static const Name name{literal};
+		return name;
+	}
+
+	/** "Foo"_name. Same as StaticName<"Foo">() */
+	template <TStaticName literal>
+	const Name& operator""_name()
+	{
+		return StaticName<literal>();
+	}
+
 	template <>
 	struct Hash<Name>
 	{
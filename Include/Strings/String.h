@@ -29,21 +29,68 @@ namespace Rift
 	using StringBuffer =
 	    fmt::basic_memory_buffer<TCHAR, fmt::inline_buffer_size, STLAllocator<TCHAR>>;
 
+	/** Format string checked at compile time against the types of its arguments */
+	template <typename... Args>
+	using FormatString = fmt::basic_format_string<TCHAR, fmt::type_identity_t<Args>...>;
+
+
+	/**
+	 * Borrows a thread-local StringBuffer for temporary formatting. It is empty when borrowed and
+	 * keeps its memory between uses, so formatting into it doesn't allocate in the common case.
+	 * Borrows can be nested (e.g. formatting inside a formatter), each one gets its own buffer.
+	 */
+	class CORE_API ScratchBuffer
+	{
+	public:
+		static constexpr u32 maxDepth = 4;
+		/** Buffers bigger than this are freed when returned */
+		static constexpr sizet maxKeptCapacity = 64 * 1024;
+
+	private:
+		StringBuffer* buffer = nullptr;
+		bool bOwned          = false;
+
+
+	public:
+		ScratchBuffer();
+		~ScratchBuffer();
+		ScratchBuffer(const ScratchBuffer&) = delete;
+		ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+		StringBuffer& Get()
+		{
+			return *buffer;
+		}
+
+		StringView ToView() const
+		{
+			return {buffer->data(), buffer->size()};
+		}
+	};
+
 
 	struct CORE_API CString
 	{
 		template <typename... Args>
-		static String Format(StringView format, Args... args)
+		static String Format(FormatString<Args...> format, Args&&... args)
+		{
+			// Formatting into a scratch buffer allocates the string only once
+			ScratchBuffer scratch;
+			FormatTo(scratch.Get(), format, Forward<Args>(args)...);
+			return String{scratch.ToView()};
+		}
+
+		template <typename... Args>
+		static void FormatTo(String& buffer, FormatString<Args...> format, Args&&... args)
 		{
-			String str;
-			fmt::format_to(std::back_inserter(str), format, std::forward<Args>(args)...);
-			return Move(str);
+			fmt::format_to(std::back_inserter(buffer), format, Forward<Args>(args)...);
 		}
 
+		/** Appends the formatted string into a buffer */
 		template <typename... Args>
-		static void FormatTo(String& buffer, StringView format, Args... args)
+		static void FormatTo(StringBuffer& buffer, FormatString<Args...> format, Args&&... args)
 		{
-			fmt::format_to(std::back_inserter(buffer), format, std::forward<Args>(args)...);
+			fmt::format_to(std::back_inserter(buffer), format, Forward<Args>(args)...);
 		}
 
 		static void ToSentenceCase(const String& str, String& result);
@@ -209,7 +256,7 @@ namespace Rift
 	{
 		sizet operator()(const String& str) const
 		{
-			return CString::GetStringHash(str.data());
+			return HashString(str.data(), str.size());
 		}
 	};
 
@@ -218,7 +265,7 @@ namespace Rift
 	{
 		sizet operator()(const StringView& str) const
 		{
-			return CString::GetStringHash(str.data());
+			return HashString(str.data(), str.size());
 		}
 	};
 
@@ -3,7 +3,22 @@
 
 #include "PCH.h"
 
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Containers/MPSCQueue.h"
+#include "Files/FileSystem.h"
+#include "Math/Math.h"
+#include "Memory/Arenas/LinearArena.h"
+#include "Memory/Arenas/NodeArena.h"
+#include "Misc/Chrono.h"
+#include "Strings/Name.h"
+#include "Strings/String.h"
+
+#include <atomic>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 
 namespace Rift
@@ -16,37 +31,470 @@ namespace Rift
 	using SubTaskLambda = std::function<void(Flow&)>;
 
 
+	/**
+	 * Lanes tasks are queued in. High is for latency sensitive work and always starts first.
+	 * Low is for background work, which some workers never take.
+	 */
+	enum class TaskPriority : u8
+	{
+		High,
+		Normal,
+		Low
+	};
+
+
+	struct TaskSystemConfig
+	{
+		/** Threads for CPU work. 0 uses every hardware thread except the main one */
+		u32 numWorkers = 0;
+		/** Threads for blocking work like file I/O, so that it never stalls CPU workers */
+		u32 numIOWorkers = 2;
+		/** Binds each worker to one cpu. Otherwise workers can move between cpus of their node */
+		bool bPinWorkers = false;
+		/**
+		 * Splits workers in one pool per NUMA node, each with a NodeArena of that node.
+		 * Flows started from a worker run in its own pool, keeping their memory on the same node
+		 */
+		bool bNumaPools = false;
+		/** Initial size of the scratch arena of each thread */
+		sizet scratchSize = 64 * 1024;
+		/** Workers that never run Low priority tasks, so that High ones don't wait for them */
+		u32 numReservedWorkers = 1;
+		/** If set, scheduling stats are saved as json to this file every statsInterval */
+		Path statsFile;
+		Chrono::seconds statsInterval{10};
+	};
+
+
+	struct TaskLaneStats
+	{
+		/** Tasks waiting to start */
+		u32 queueDepth = 0;
+		u64 numRun     = 0;
+		/** Time from queuing a task to starting it */
+		Chrono::microseconds averageWait{0};
+		/** 99% of tasks waited less than this. Rounded up to a power of two */
+		Chrono::microseconds p99Wait{0};
+		Chrono::microseconds maxWait{0};
+		/** Tasks by wait time. Bucket i counts tasks that waited less than 2^i microseconds */
+		TArray<u64> waitHistogram;
+	};
+
+
+	struct TaskThreadStats
+	{
+		String thread;
+		/** Time spent running tasks */
+		Chrono::microseconds busy{0};
+		/** Time since the task system started not spent running tasks */
+		Chrono::microseconds idle{0};
+		u64 numTasks = 0;
+		/**
+		 * Tasks queued from another worker that this one ran. Only counted for RunAsync tasks,
+		 * since taskflow doesn't expose its own steals
+		 */
+		u64 numSteals = 0;
+	};
+
+
+	struct TaskDurationStats
+	{
+		u64 count = 0;
+		Chrono::microseconds total{0};
+		Chrono::microseconds min{0};
+		Chrono::microseconds max{0};
+	};
+
+
+	struct TaskSystemStats
+	{
+		Chrono::microseconds uptime{0};
+		/** Main thread, then the workers and then the IO threads */
+		TArray<TaskThreadStats> threads;
+		/** Indexed by TaskPriority */
+		TaskLaneStats lanes[3];
+		/** Durations of flow tasks by name. Unnamed tasks are not tracked */
+		TMap<String, TaskDurationStats> namedTasks;
+	};
+
+
+	struct ScratchStats
+	{
+		String thread;
+		/** Most memory used by a single task */
+		sizet peakSize = 0;
+		/** Memory reserved by the arena */
+		sizet capacity = 0;
+	};
+
+
+	struct TaskSystem;
+
+	namespace Impl
+	{
+		struct ThreadState;
+
+		/** @return an address unique to Params, used to tell apart graphs of the same id */
+		template <typename Params>
+		const void* GetGraphTag()
+		{
+			static const u8 tag = 0;
+			return &tag;
+		}
+
+		/** Graphs are cached by id and Params, so a graph is always cast to its own type */
+		struct GraphKey
+		{
+			Name id;
+			const void* tag = nullptr;
+
+
+			bool operator==(const GraphKey& other) const
+			{
+				return id == other.id && tag == other.tag;
+			}
+		};
+
+		struct TaskGraphBase
+		{
+			virtual ~TaskGraphBase() = default;
+		};
+	}    // namespace Impl
+
+	template <>
+	struct Hash<Impl::GraphKey>
+	{
+		sizet operator()(const Impl::GraphKey& key) const
+		{
+			return Hash<Name>{}(key.id) ^ (sizet(key.tag) >> 4);
+		}
+	};
+
+
+	/**
+	 * Flow built once and run many times, so that its tasks are not created again on each run.
+	 * Tasks read the parameters of the current run from the params given to the builder.
+	 * Runs of the same graph happen one after another.
+	 */
+	template <typename Params>
+	class TTaskGraph : public Impl::TaskGraphBase
+	{
+		const TaskSystem& tasks;
+		TaskFlow flow;
+		Params params{};
+		std::mutex runMutex;
+		std::shared_future<void> lastRun;
+
+
+	public:
+		/** @param build called as build(flow, params) to create the tasks of the graph */
+		template <typename Builder>
+		TTaskGraph(const TaskSystem& tasks, Builder&& build) : tasks{tasks}
+		{
+			build(flow, static_cast<const Params&>(params));
+		}
+
+		/**
+		 * Waits for the previous run to finish, then runs the graph with new parameters.
+		 * Avoid calling it from a worker while the graph may still be running.
+		 */
+		std::shared_future<void> Run(Params newParams);
+
+		const Params& GetParams() const
+		{
+			return params;
+		}
+	};
+
+
 	struct CORE_API TaskSystem
 	{
 		using ThreadPool = tf::Executor;
 
+		static constexpr i32 numPriorities = 3;
+
 	private:
-		// Main thread
-		std::shared_ptr<ThreadPool> mainPool;
-		// Worker threads
-		std::shared_ptr<ThreadPool> workerPool;
+		struct WorkerPool
+		{
+			std::shared_ptr<ThreadPool> executor;
+			// Id of the NUMA node in the OS. Not the index of the pool
+			u32 node = 0;
+			std::unique_ptr<Memory::NodeArena> arena;
+		};
+
+		// Scratch arena and stats of the main thread, then the workers and then the IO threads.
+		// Declared before the pools so that they outlive their threads
+		TArray<std::unique_ptr<Impl::ThreadState>> threads;
+		// Queued tasks by priority. Declared before the pools so that it outlives their tasks
+		struct TaskLanes;
+		std::unique_ptr<TaskLanes> lanes;
+		// Graphs built by GetGraph. Declared before the pools so that they outlive their runs
+		mutable std::mutex graphsMutex;
+		mutable TMap<Impl::GraphKey, std::unique_ptr<Impl::TaskGraphBase>> graphs;
+		// Worker threads, one pool per NUMA node
+		TArray<WorkerPool> workerPools;
+		// Threads for blocking tasks
+		std::shared_ptr<ThreadPool> ioPool;
+		// Pool used by the next flow started outside of the workers
+		mutable std::atomic<u32> nextPool{0};
+		// Delayed tasks. Declared after the pools so that it stops first
+		struct TimerQueue;
+		std::unique_ptr<TimerQueue> timers;
+
+		// Thread that created the task system and pumps main tasks
+		std::thread::id mainThreadId;
+		Chrono::steady_clock::time_point startTime;
+		// Main tasks posted from any thread, one queue per priority
+		mutable TMPSCQueue<TaskLambda> mainQueues[numPriorities];
+		// Main tasks taken from the queues but not run yet. Only used by the main thread
+		TArray<TaskLambda> pendingMain[numPriorities];
+		i32 nextPendingMain[numPriorities]{};
 
 
 	public:
-		TaskSystem();
+		TaskSystem(const TaskSystemConfig& config = {});
+		~TaskSystem();
 
 		// Runs a flow in Workers thread pool
 		std::future<void> RunFlow(TaskFlow& flow) const
 		{
-			return workerPool->run(flow);
+			return GetPool().executor->run(flow);
+		}
+
+		// Runs a flow in Workers thread pool and calls onFinish from a worker once it completes
+		std::future<void> RunFlow(TaskFlow& flow, TaskLambda onFinish) const
+		{
+			return GetPool().executor->run(flow, Move(onFinish));
+		}
+
+		// Runs a flow in a Workers thread pool. node is an index up to GetNumNodes()
+		std::future<void> RunFlowOnNode(TaskFlow& flow, u32 node) const
+		{
+			return workerPools[node % workerPools.Size()].executor->run(flow);
+		}
+
+		/**
+		 * Runs a single task in Workers thread pool. Queued tasks start by priority, and in the
+		 * order they were queued within the same priority.
+		 */
+		void RunAsync(TaskLambda callback, TaskPriority priority = TaskPriority::Normal) const;
+
+		/**
+		 * Preemption point for long tasks split in steps.
+		 * @return true if tasks of a higher priority are waiting to start. The caller can then
+		 * queue its next step with RunAsync to let them run first
+		 */
+		bool ShouldYield(TaskPriority priority) const;
+
+		TaskLaneStats GetLaneStats(TaskPriority priority) const;
+
+		/**
+		 * Calls callback(index) for every index in [0, count) on the workers and waits for them.
+		 * Cheaper than running a flow for short work, since no graph is built. The calling thread
+		 * runs indices too, so it can be called from a worker.
+		 * Helpers of other priorities are queued with RunAsync. The caller never waits for an
+		 * index nobody started, so a saturated lane only leaves it more work.
+		 */
+		template <typename Callback>
+		void Dispatch(
+		    i32 count, Callback&& callback, TaskPriority priority = TaskPriority::Normal) const;
+
+		/**
+		 * @return graph cached under id and Params. The first call creates it with
+		 * build(flow, params). The same id used with other Params gets another graph.
+		 */
+		template <typename Params, typename Builder>
+		TTaskGraph<Params>& GetGraph(Name id, Builder&& build) const;
+
+		// Runs a task that blocks, like file I/O, in IO thread pool
+		void RunIO(TaskLambda callback) const
+		{
+			if (ioPool)
+			{
+				ioPool->silent_async(Move(callback));
+			}
+			else
+			{
+				RunAsync(Move(callback));
+			}
+		}
+
+		/**
+		 * Runs a task in Workers thread pool once delay has passed.
+		 * Delays are tracked by one timer thread, created the first time this is called.
+		 */
+		void RunAfter(Chrono::steady_clock::duration delay, TaskLambda callback) const;
+
+		/**
+		 * Queues a task to run on the main thread the next time it calls PumpMain.
+		 * Can be called from any thread without locking.
+		 */
+		void PostMain(TaskLambda callback, TaskPriority priority = TaskPriority::Normal) const
+		{
+			mainQueues[u8(priority)].Push(Move(callback));
+		}
+
+		/**
+		 * Runs main tasks by priority, then in the order they were posted. Must be called from
+		 * the main thread.
+		 * Tasks posted while pumping run on the next call. At least one task runs if any is
+		 * queued, and the rest wait for the next call once budget is exceeded.
+		 * @return number of tasks run
+		 */
+		u32 PumpMain(Chrono::microseconds budget = Chrono::microseconds::max());
+
+		u32 GetNumWorkerThreads() const;
+
+		u32 GetNumIOThreads() const
+		{
+			return ioPool ? (u32) ioPool->num_workers() : 0;
+		}
+
+		/** @return number of worker pools. One per NUMA node if bNumaPools was set */
+		u32 GetNumNodes() const
+		{
+			return u32(workerPools.Size());
 		}
 
-		// Creates a flow in Game thread pool
-		std::future<void> RunMainFlow(TaskFlow& flow) const
+		/**
+		 * @return index of the pool of the calling worker, or -1 if not called from a worker.
+		 * Pools of nodes without workers are skipped, so it may differ from the NUMA node id
+		 */
+		i32 GetCurrentNode() const;
+
+		/**
+		 * @return arena of the calling worker's NUMA node. Other threads get the arena of the
+		 * first node
+		 */
+		Memory::NodeArena& GetNodeArena() const;
+
+		/**
+		 * @return scratch arena of the calling thread, for temporary memory without locking.
+		 * It is rewound when the current task finishes. On the main thread, tasks run by
+		 * PumpMain rewind it too, so memory allocated outside tasks is only valid until then.
+		 * Can only be called from the main thread or threads of this task system.
+		 */
+		Memory::LinearArena& GetScratchArena() const;
+
+		/** @return scratch usage of each thread, measured when tasks finish */
+		TArray<ScratchStats> GetScratchStats() const;
+
+		/**
+		 * @return time spent by each thread running tasks, waits of each lane and durations of
+		 * named flow tasks since the task system started. Collected without the profiler
+		 */
+		TaskSystemStats GetStats() const;
+
+		/** Saves GetStats() as json. @return false if the file couldn't be written */
+		bool SaveStats(const Path& path) const;
+
+		/** @return true if called from one of the worker threads */
+		bool IsWorkerThread() const
 		{
-			return mainPool->run(flow);
+			return GetCurrentNode() >= 0;
 		}
 
-		u32 GetNumWorkerThreads() const
+		/** @return true if called from the thread that created the task system */
+		bool IsMainThread() const
 		{
-			return (u32) workerPool->num_workers();
+			return std::this_thread::get_id() == mainThreadId;
 		}
 
 		static TaskSystem& Get();
+
+	private:
+		/** @return pool of the calling worker, or the next pool in turn for other threads */
+		const WorkerPool& GetPool() const;
+
+		/** Runs the first queued task that can start. Each queued task schedules one call */
+		void RunLaneTask() const;
 	};
+
+
+	template <typename Params>
+	std::shared_future<void> TTaskGraph<Params>::Run(Params newParams)
+	{
+		std::unique_lock<std::mutex> lock{runMutex};
+		if (lastRun.valid())
+		{
+			lastRun.wait();
+		}
+		params  = Move(newParams);
+		lastRun = tasks.RunFlow(flow).share();
+		return lastRun;
+	}
+
+	template <typename Callback>
+	void TaskSystem::Dispatch(i32 count, Callback&& callback, TaskPriority priority) const
+	{
+		if (count <= 1)
+		{
+			if (count == 1)
+			{
+				callback(0);
+			}
+			return;
+		}
+
+		// Shared with helpers that may start after all indices ran. Those never touch callback
+		struct State
+		{
+			std::remove_reference_t<Callback>* callback;
+			i32 count;
+			std::atomic<i32> next{0};
+			std::atomic<i32> done{0};
+		};
+		const auto state = std::make_shared<State>(&callback, count);
+		const auto work  = [state]() {
+			i32 ran = 0;
+			i32 i;
+			while ((i = state->next.fetch_add(1, std::memory_order_relaxed)) < state->count)
+			{
+				(*state->callback)(i);
+				++ran;
+			}
+			if (ran > 0
+			    && state->done.fetch_add(ran, std::memory_order_acq_rel) + ran == state->count)
+			{
+				state->done.notify_all();
+			}
+		};
+
+		ThreadPool& pool     = *GetPool().executor;
+		const u32 numHelpers = Math::Min(u32(count - 1), u32(pool.num_workers()));
+		for (u32 i = 0; i < numHelpers; ++i)
+		{
+			if (priority == TaskPriority::Normal)
+			{
+				pool.silent_async(work);
+			}
+			else
+			{
+				RunAsync(work, priority);
+			}
+		}
+		work();
+
+		i32 done = state->done.load(std::memory_order_acquire);
+		while (done < count)
+		{
+			state->done.wait(done, std::memory_order_acquire);
+			done = state->done.load(std::memory_order_acquire);
+		}
+	}
+
+	template <typename Params, typename Builder>
+	TTaskGraph<Params>& TaskSystem::GetGraph(Name id, Builder&& build) const
+	{
+		const Impl::GraphKey key{Move(id), Impl::GetGraphTag<Params>()};
+		std::unique_lock<std::mutex> lock{graphsMutex};
+		if (std::unique_ptr<Impl::TaskGraphBase>* graph = graphs.Find(key))
+		{
+			return static_cast<TTaskGraph<Params>&>(**graph);
+		}
+		auto graph = std::make_unique<TTaskGraph<Params>>(*this, Forward<Builder>(build));
+		TTaskGraph<Params>& ref = *graph;
+		graphs.Insert(key, Move(graph));
+		return ref;
+	}
 }	 // namespace Rift
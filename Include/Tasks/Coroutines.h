@@ -0,0 +1,686 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers/Array.h"
+#include "Math/Math.h"
+#include "Misc/Chrono.h"
+#include "Misc/Utility.h"
+#include "Tasks.h"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+
+namespace Rift
+{
+	template <typename T = void>
+	class TTask;
+
+	template <typename T>
+	struct TAnyResult
+	{
+		i32 index = -1;
+		T value;
+	};
+
+	/** Result of WhenAll: values in the order of the tasks, or nothing for void tasks */
+	template <typename T>
+	using TWhenAllResult = std::conditional_t<std::is_void_v<T>, void, TArray<T>>;
+
+	/** Result of WhenAny: index of the first task to finish and its value, if any */
+	template <typename T>
+	using TWhenAnyResult = std::conditional_t<std::is_void_v<T>, i32, TAnyResult<T>>;
+
+
+	namespace Impl
+	{
+		struct TaskPromiseBase
+		{
+			// Coroutine awaiting this task. Resumed when the task finishes
+			std::coroutine_handle<> continuation;
+
+			struct FinalAwaiter
+			{
+				bool await_ready() const noexcept
+				{
+					return false;
+				}
+
+				template <typename Promise>
+				std::coroutine_handle<> await_suspend(
+				    std::coroutine_handle<Promise> handle) noexcept
+				{
+					std::coroutine_handle<> next = handle.promise().continuation;
+					return next ? next : std::noop_coroutine();
+				}
+
+				void await_resume() const noexcept {}
+			};
+
+			std::suspend_always initial_suspend() const noexcept
+			{
+				return {};
+			}
+
+			FinalAwaiter final_suspend() const noexcept
+			{
+				return {};
+			}
+
+			void unhandled_exception() const noexcept
+			{
+				std::terminate();
+			}
+		};
+
+		template <typename T>
+		struct TaskPromise : public TaskPromiseBase
+		{
+			std::optional<T> value;
+
+			TTask<T> get_return_object() noexcept;
+
+			template <typename V>
+			void return_value(V&& newValue) requires std::convertible_to<V, T>
+			{
+				value.emplace(Forward<V>(newValue));
+			}
+
+			T TakeValue()
+			{
+				return Move(*value);
+			}
+		};
+
+		template <>
+		struct TaskPromise<void> : public TaskPromiseBase
+		{
+			TTask<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+			void TakeValue() const noexcept {}
+		};
+	}    // namespace Impl
+
+
+	/**
+	 * Coroutine that produces a T. It starts when awaited, on the awaiting thread, and resumes
+	 * the awaiting coroutine when it finishes.
+	 * Use ResumeOnWorkers and ResumeOnMain to change thread, and Detach or SyncWait to run a
+	 * task from code that is not a coroutine.
+	 */
+	template <typename T>
+	class TTask
+	{
+	public:
+		using promise_type = Impl::TaskPromise<T>;
+		using Handle       = std::coroutine_handle<promise_type>;
+
+	private:
+		Handle handle;
+
+
+	public:
+		TTask() = default;
+		explicit TTask(Handle handle) : handle{handle} {}
+		TTask(TTask&& other) noexcept : handle{std::exchange(other.handle, {})} {}
+		TTask& operator=(TTask&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				handle = std::exchange(other.handle, {});
+			}
+			return *this;
+		}
+		TTask(const TTask&) = delete;
+		TTask& operator=(const TTask&) = delete;
+		~TTask()
+		{
+			Reset();
+		}
+
+		bool IsValid() const
+		{
+			return bool(handle);
+		}
+
+		bool IsDone() const
+		{
+			return handle && handle.done();
+		}
+
+		auto operator co_await() noexcept
+		{
+			assert(IsValid() && "Can't await an empty task");
+			struct Awaiter
+			{
+				Handle handle;
+
+				bool await_ready() const noexcept
+				{
+					return handle.done();
+				}
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume()
+				{
+					return handle.promise().TakeValue();
+				}
+			};
+			return Awaiter{handle};
+		}
+
+	private:
+		void Reset()
+		{
+			if (handle)
+			{
+				handle.destroy();
+				handle = {};
+			}
+		}
+	};
+
+
+	namespace Impl
+	{
+		template <typename T>
+		TTask<T> TaskPromise<T>::get_return_object() noexcept
+		{
+			return TTask<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+		}
+
+		inline TTask<void> TaskPromise<void>::get_return_object() noexcept
+		{
+			return TTask<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+		}
+
+		/** Coroutine that starts immediately and destroys itself when it finishes */
+		struct DetachedTask
+		{
+			struct promise_type
+			{
+				DetachedTask get_return_object() const noexcept
+				{
+					return {};
+				}
+
+				std::suspend_never initial_suspend() const noexcept
+				{
+					return {};
+				}
+
+				std::suspend_never final_suspend() const noexcept
+				{
+					return {};
+				}
+
+				void return_void() const noexcept {}
+
+				void unhandled_exception() const noexcept
+				{
+					std::terminate();
+				}
+			};
+		};
+
+		/** Resumes a coroutine through the main queue or directly on the current worker */
+		inline void ResumeFromWorker(
+		    const TaskSystem& tasks, std::coroutine_handle<> handle, bool bMain)
+		{
+			if (bMain)
+			{
+				tasks.PostMain([handle]() {
+					handle.resume();
+				});
+			}
+			else
+			{
+				handle.resume();
+			}
+		}
+
+		struct WorkersAwaiter
+		{
+			const TaskSystem& tasks;
+			TaskPriority priority;
+
+			bool await_ready() const noexcept
+			{
+				return tasks.IsWorkerThread();
+			}
+
+			void await_suspend(std::coroutine_handle<> handle) const
+			{
+				tasks.RunAsync(
+				    [handle]() {
+					    handle.resume();
+				    },
+				    priority);
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		struct PreemptionAwaiter
+		{
+			const TaskSystem& tasks;
+			TaskPriority priority;
+
+			bool await_ready() const noexcept
+			{
+				return !tasks.IsWorkerThread() || !tasks.ShouldYield(priority);
+			}
+
+			void await_suspend(std::coroutine_handle<> handle) const
+			{
+				tasks.RunAsync(
+				    [handle]() {
+					    handle.resume();
+				    },
+				    priority);
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		struct MainAwaiter
+		{
+			const TaskSystem& tasks;
+			TaskPriority priority;
+
+			bool await_ready() const noexcept
+			{
+				return tasks.IsMainThread();
+			}
+
+			void await_suspend(std::coroutine_handle<> handle) const
+			{
+				tasks.PostMain(
+				    [handle]() {
+					    handle.resume();
+				    },
+				    priority);
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		struct DelayAwaiter
+		{
+			const TaskSystem& tasks;
+			Chrono::steady_clock::duration delay;
+
+			bool await_ready() const noexcept
+			{
+				return delay <= Chrono::steady_clock::duration::zero();
+			}
+
+			void await_suspend(std::coroutine_handle<> handle) const
+			{
+				const bool bMain = tasks.IsMainThread();
+				tasks.RunAfter(delay, [&tasks = tasks, handle, bMain]() {
+					ResumeFromWorker(tasks, handle, bMain);
+				});
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		struct FlowAwaiter
+		{
+			const TaskSystem& tasks;
+			TaskFlow& flow;
+
+			bool await_ready() const noexcept
+			{
+				return flow.empty();
+			}
+
+			void await_suspend(std::coroutine_handle<> handle) const
+			{
+				const TaskSystem& system = tasks;
+				const bool bMain         = tasks.IsMainThread();
+				// onFinish runs before the flow is done. A helper task resumes the coroutine
+				// once the future of the run is ready, so the flow can be run or destroyed again
+				auto run = std::make_shared<std::promise<std::future<void>>>();
+				run->set_value(system.RunFlow(flow, [&system, handle, bMain, run]() {
+					system.RunAsync([&system, handle, bMain, run]() {
+						run->get_future().get().wait();
+						ResumeFromWorker(system, handle, bMain);
+					});
+				}));
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		/** Awaits an owner that decides with Suspend(handle) if the coroutine suspends */
+		template <typename Owner>
+		struct SuspendAwaiter
+		{
+			Owner& owner;
+
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			bool await_suspend(std::coroutine_handle<> handle)
+			{
+				return owner.Suspend(handle);
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		/**
+		 * Counts the tasks of WhenAll left to finish. Starts at one more than the tasks so that
+		 * the awaiting coroutine only suspends if some task is still running.
+		 */
+		struct WhenAllCounter
+		{
+			std::atomic<i32> remaining;
+			std::coroutine_handle<> continuation;
+
+
+			explicit WhenAllCounter(i32 count) : remaining{count + 1} {}
+
+			void Finish()
+			{
+				if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					continuation.resume();
+				}
+			}
+
+			/** @return false if all tasks already finished and handle must not suspend */
+			bool Suspend(std::coroutine_handle<> handle)
+			{
+				continuation = handle;
+				return remaining.fetch_sub(1, std::memory_order_acq_rel) > 1;
+			}
+
+			SuspendAwaiter<WhenAllCounter> operator co_await() noexcept
+			{
+				return {*this};
+			}
+		};
+
+		template <typename T>
+		DetachedTask RunWhenAll(TTask<T>& task, WhenAllCounter& counter, std::optional<T>& value)
+		{
+			value.emplace(co_await task);
+			counter.Finish();
+		}
+
+		inline DetachedTask RunWhenAll(TTask<void>& task, WhenAllCounter& counter)
+		{
+			co_await task;
+			counter.Finish();
+		}
+
+		/** Shared with the tasks of WhenAny, which keep running after the first one finishes */
+		template <typename T>
+		struct WhenAnyState
+		{
+			TArray<TTask<T>> tasks;
+			std::atomic<i32> firstIndex{-1};
+			std::optional<T> value;
+			std::coroutine_handle<> continuation;
+			// The first task to finish and the awaiting coroutine both signal. Last one resumes
+			std::atomic<i32> signals{2};
+
+
+			bool Signal()
+			{
+				return signals.fetch_sub(1, std::memory_order_acq_rel) == 1;
+			}
+
+			/** @return false if a task already finished and handle must not suspend */
+			bool Suspend(std::coroutine_handle<> handle)
+			{
+				continuation = handle;
+				return !Signal();
+			}
+
+			SuspendAwaiter<WhenAnyState> operator co_await() noexcept
+			{
+				return {*this};
+			}
+		};
+
+		template <typename T>
+		DetachedTask RunWhenAny(std::shared_ptr<WhenAnyState<T>> state, i32 index)
+		{
+			i32 noIndex = -1;
+			if constexpr (std::is_void_v<T>)
+			{
+				co_await state->tasks[index];
+				if (state->firstIndex.compare_exchange_strong(noIndex, index) && state->Signal())
+				{
+					state->continuation.resume();
+				}
+			}
+			else
+			{
+				T value = co_await state->tasks[index];
+				if (state->firstIndex.compare_exchange_strong(noIndex, index))
+				{
+					state->value.emplace(Move(value));
+					if (state->Signal())
+					{
+						state->continuation.resume();
+					}
+				}
+			}
+		}
+
+		template <typename T>
+		DetachedTask RunDetached(TTask<T> task)
+		{
+			co_await task;
+		}
+
+		struct WaitSignal
+		{
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool bDone = false;
+
+
+			void Notify();
+			/** Waits until notified. Pumps main tasks while waiting on the main thread */
+			void Wait(TaskSystem& tasks);
+		};
+
+		template <typename T>
+		DetachedTask RunAndSignal(TTask<T>& task, WaitSignal& signal, std::optional<T>& value)
+		{
+			value.emplace(co_await task);
+			signal.Notify();
+		}
+
+		inline DetachedTask RunAndSignal(TTask<void>& task, WaitSignal& signal)
+		{
+			co_await task;
+			signal.Notify();
+		}
+	}    // namespace Impl
+
+
+	/** Continues the awaiting coroutine on a worker thread */
+	inline Impl::WorkersAwaiter ResumeOnWorkers(const TaskSystem& tasks = TaskSystem::Get())
+	{
+		return {tasks, TaskPriority::Normal};
+	}
+
+	/** Continues the awaiting coroutine on a worker thread, queued with a priority */
+	inline Impl::WorkersAwaiter ResumeOnWorkers(
+	    TaskPriority priority, const TaskSystem& tasks = TaskSystem::Get())
+	{
+		return {tasks, priority};
+	}
+
+	/**
+	 * Preemption point for long running coroutines on workers. If tasks of a higher priority are
+	 * waiting, the coroutine is queued again behind them.
+	 */
+	inline Impl::PreemptionAwaiter PreemptionPoint(
+	    TaskPriority priority, const TaskSystem& tasks = TaskSystem::Get())
+	{
+		return {tasks, priority};
+	}
+
+	/** Continues the awaiting coroutine on the main thread, the next time it pumps main tasks */
+	inline Impl::MainAwaiter ResumeOnMain(
+	    TaskPriority priority = TaskPriority::Normal, const TaskSystem& tasks = TaskSystem::Get())
+	{
+		return {tasks, priority};
+	}
+
+	/**
+	 * Continues the awaiting coroutine once delay has passed, without blocking any thread.
+	 * Resumes on the main thread if awaited from it, otherwise on a worker.
+	 */
+	inline Impl::DelayAwaiter Delay(
+	    Chrono::steady_clock::duration delay, const TaskSystem& tasks = TaskSystem::Get())
+	{
+		return {tasks, delay};
+	}
+
+	/**
+	 * Runs a flow and continues the awaiting coroutine when it finishes.
+	 * Resumes on the main thread if awaited from it, otherwise on a worker.
+	 */
+	inline Impl::FlowAwaiter AwaitFlow(TaskFlow& flow, const TaskSystem& tasks = TaskSystem::Get())
+	{
+		return {tasks, flow};
+	}
+
+	/**
+	 * Waits for a future without blocking a thread, checking it with increasing delays.
+	 * Prefer AwaitFlow for flows, which resumes as soon as they finish.
+	 */
+	template <typename T>
+	TTask<T> AwaitFuture(std::future<T> future, const TaskSystem& tasks = TaskSystem::Get())
+	{
+		static constexpr Chrono::microseconds maxWait{2000};
+		Chrono::microseconds wait{50};
+		while (future.wait_for(Chrono::seconds(0)) != std::future_status::ready)
+		{
+			co_await Delay(wait, tasks);
+			wait = Math::Min(wait * 2, maxWait);
+		}
+		co_return future.get();
+	}
+
+	/**
+	 * Runs all tasks at once and finishes when all of them did.
+	 * Each task starts on the calling thread. The awaiting coroutine resumes on the thread that
+	 * finished the last task.
+	 */
+	template <typename T>
+	TTask<TWhenAllResult<T>> WhenAll(TArray<TTask<T>> tasks)
+	{
+		Impl::WhenAllCounter counter{tasks.Size()};
+		if constexpr (std::is_void_v<T>)
+		{
+			for (TTask<T>& task : tasks)
+			{
+				Impl::RunWhenAll(task, counter);
+			}
+			co_await counter;
+		}
+		else
+		{
+			TArray<std::optional<T>> values;
+			values.Resize(tasks.Size());
+			for (i32 i = 0; i < tasks.Size(); ++i)
+			{
+				Impl::RunWhenAll(tasks[i], counter, values[i]);
+			}
+			co_await counter;
+
+			TArray<T> results;
+			results.Reserve(values.Size());
+			for (std::optional<T>& value : values)
+			{
+				results.Add(Move(*value));
+			}
+			co_return results;
+		}
+	}
+
+	/**
+	 * Runs all tasks at once and finishes when the first of them does. The others keep running
+	 * in the background and their results are discarded.
+	 * The awaiting coroutine resumes on the thread that finished the first task.
+	 */
+	template <typename T>
+	TTask<TWhenAnyResult<T>> WhenAny(TArray<TTask<T>> tasks)
+	{
+		assert(tasks.Size() > 0 && "WhenAny needs at least one task");
+		auto state   = std::make_shared<Impl::WhenAnyState<T>>();
+		state->tasks = Move(tasks);
+		for (i32 i = 0; i < state->tasks.Size(); ++i)
+		{
+			Impl::RunWhenAny(state, i);
+		}
+		co_await *state;
+
+		if constexpr (std::is_void_v<T>)
+		{
+			co_return state->firstIndex.load();
+		}
+		else
+		{
+			co_return TAnyResult<T>{state->firstIndex.load(), Move(*state->value)};
+		}
+	}
+
+	/** Starts a task without waiting for it. The task is destroyed when it finishes */
+	template <typename T>
+	void Detach(TTask<T> task)
+	{
+		Impl::RunDetached(Move(task));
+	}
+
+	/**
+	 * Starts a task and blocks the calling thread until it finishes.
+	 * From the main thread it keeps pumping main tasks, so the task can still use ResumeOnMain.
+	 */
+	template <typename T>
+	T SyncWait(TTask<T> task, TaskSystem& tasks = TaskSystem::Get())
+	{
+		Impl::WaitSignal signal;
+		if constexpr (std::is_void_v<T>)
+		{
+			Impl::RunAndSignal(task, signal);
+			signal.Wait(tasks);
+		}
+		else
+		{
+			std::optional<T> value;
+			Impl::RunAndSignal(task, signal, value);
+			signal.Wait(tasks);
+			return Move(*value);
+		}
+	}
+}    // namespace Rift
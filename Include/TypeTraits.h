@@ -75,6 +75,18 @@ namespace Rift
 	public:
 		static const bool value = std::is_void<decltype(Impl<T>(0))>::value;
 	};
+
+
+	/** Decomposes a pointer to member (&Class::member) into its class and member types */
+	template <typename T>
+	struct MemberPointerTraits;
+
+	template <typename ClassT, typename MemberT>
+	struct MemberPointerTraits<MemberT ClassT::*>
+	{
+		using Class  = ClassT;
+		using Member = MemberT;
+	};
 }    // namespace Rift
 
 #define RIFT_DECLARE_IS_POD(T, isPod)                                                \
@@ -1,7 +1,9 @@
 // Copyright 2015-2021 Piperift - All rights reserved
 #include "Assets/AssetData.h"
 
+#include "Context.h"
 #include "Files/FileSystem.h"
+#include "Files/SaveQueue.h"
 
 
 namespace Rift
@@ -25,20 +27,44 @@ namespace Rift
 
 	bool AssetData::SaveToPath(const Name& path)
 	{
-		const String& sPath = path.ToString();
-		if (sPath.empty() || !FileSystem::IsFolder(sPath))
-			return false;
-
-		JsonArchive ar{};
-		Name className = GetType()->GetName();
-		ar("asset_type", className);
-		Serialize(ar);
-
-		return FileSystem::SaveJsonFile(sPath, ar.GetData(), ar.GetIndent());
+		// Goes through the queue, so that an older save still queued can't overwrite this one
+		SaveQueue& queue                    = Context::Get()->GetSaveQueue();
+		const std::shared_future<bool> done = QueueSave(path);
+		queue.Flush();
+		return done.get();
 	}
 
 	bool AssetData::Save()
 	{
 		return SaveToPath(info.GetPath());
 	}
+
+	std::shared_future<bool> AssetData::SaveAsync()
+	{
+		return QueueSave(info.GetPath());
+	}
+
+	std::shared_future<bool> AssetData::QueueSave(const Name& path)
+	{
+		const Path filePath = FileSystem::FromString(path.ToString());
+		// Assets are saved as files inside an existing folder
+		const Path folder = filePath.has_parent_path() ? filePath.parent_path() : Path{"."};
+		if (!FileSystem::IsFile(filePath) || !FileSystem::ExistsAsFolder(folder))
+		{
+			std::promise<bool> failed;
+			failed.set_value(false);
+			return failed.get_future().share();
+		}
+
+		JsonArchive ar{};
+		SerializeForSave(ar);
+		return Context::Get()->GetSaveQueue().Save(filePath, Move(ar.GetData()), ar.GetIndent());
+	}
+
+	void AssetData::SerializeForSave(JsonArchive& ar)
+	{
+		Name className = GetType()->GetName();
+		ar("asset_type", className);
+		Serialize(ar);
+	}
 }	 // namespace Rift
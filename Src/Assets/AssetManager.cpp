@@ -2,7 +2,9 @@
 
 #include "Assets/AssetManager.h"
 #include "Context.h"
+#include "Files/AsyncIO.h"
 #include "Files/FileSystem.h"
+#include "Parallel.h"
 #include "Profiler.h"
 #include "Tasks.h"
 
@@ -48,19 +50,48 @@ namespace Rift
 			}
 		}
 
-		TaskFlow loadTask;
 		TArray<FAssetLoadingData> loadedDatas(infos.Size());
 
-		loadTask.for_each_index(0, infos.Size(), 1, [&loadedDatas, &infos](i32 i) {
+		// Up to a queue depth of reads are in flight, so that loading is bound by the disk and not
+		// by the workers. Files are opened when their read is queued, so few are open at once
+		TArray<String> contents(infos.Size());
+		TArray<std::future<bool>> reads;
+		reads.Reserve(infos.Size());
+		AsyncIO& io           = AsyncIO::Get();
+		const i32 maxInFlight = i32(io.GetQueueDepth());
+		for (i32 i = 0; i < infos.Size(); ++i)
+		{
+			const i32 lastRead = Math::Min(i + maxInFlight, infos.Size());
+			if (reads.Size() < lastRead)
+			{
+				while (reads.Size() < lastRead)
+				{
+					const i32 next = reads.Size();
+					reads.Add(io.LoadFile(FileSystem::FromString(infos[next].GetStrPath()),
+					    contents[next]));
+				}
+				io.Submit();
+			}
+			reads[i].wait();
+		}
+
+		const auto loadAsset = [&loadedDatas, &infos, &contents, &reads](i32 i) {
 			ZoneScopedNC("Load Asset File", 0xD19D45);
 			auto& info = infos[i];
 			auto& data = loadedDatas[i];
 
-			if (!FileSystem::LoadJsonFile(info.GetStrPath(), data.json))
+			if (!reads[i].get())
 			{
 				Log::Error("Asset ({}) could not be loaded from disk", info.GetStrPath());
 				return;
 			}
+			data.json = Json::parse(contents[i], nullptr, false);
+			String{}.swap(contents[i]);
+			if (data.json.is_discarded())
+			{
+				Log::Error("Asset ({}) is not valid json", info.GetStrPath());
+				return;
+			}
 
 			const auto type = data.json["asset_type"];
 			if (!type.is_string())
@@ -76,8 +107,9 @@ namespace Rift
 			{
 				Log::Error("Asset ({}) has unknown asset_type '{}' ", info.GetStrPath(), typeStr);
 			}
-		});
-		TaskSystem::Get().RunFlow(loadTask).wait();
+		};
+		// Parsing each asset is slow enough to go in its own task
+		ParallelFor(infos.Size(), loadAsset, {.grainSize = 1});
 
 		// Deserialize asset instances
 		for (i32 I = 0; I < infos.Size(); ++I)
@@ -137,6 +169,24 @@ namespace Rift
 		return {};
 	}
 
+	TArray<AssetInfo> AssetManager::FindAssets(const Path& folder, bool bRecursive)
+	{
+		ZoneScopedN("AssetManager::FindAssets");
+		CrawlSettings settings;
+		settings.extension  = assetFormat;
+		settings.bRecursive = bRecursive;
+		settings.tasks      = &Context::Get()->GetTasks();
+
+		const TArray<Path> paths = crawler.Crawl(folder, settings);
+		TArray<AssetInfo> infos;
+		infos.Reserve(paths.Size());
+		for (const Path& path : paths)
+		{
+			infos.Add(AssetInfo{path});
+		}
+		return infos;
+	}
+
 	Ptr<AssetManager> AssetManager::Get()
 	{
 		return Context::Get()->GetAssetManager();
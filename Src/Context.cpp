@@ -5,4 +5,5 @@
 namespace Rift
 {
 	ObjectPtr<Context> Context::globalInstance{};
+	TaskSystemConfig Context::tasksConfig{};
 }
@@ -0,0 +1,747 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Files/AsyncIO.h"
+
+#include "Context.h"
+#include "Log.h"
+#include "Math/Math.h"
+#include "Profiler.h"
+#include "Tasks.h"
+
+#include <common/TracySystem.hpp>
+#include <cstring>
+
+#if PLATFORM_WINDOWS
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+#if PLATFORM_LINUX
+#	include <linux/io_uring.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <sys/uio.h>
+#endif
+
+
+namespace Rift
+{
+	// Reads and writes are split in calls of at most this size
+	static constexpr u64 maxOperationSize = 1u << 30;
+
+
+	struct AsyncIO::Operation
+	{
+		bool bWrite     = false;
+		intptr_t handle = -1;
+		u8* data        = nullptr;
+		u32 size        = 0;
+		u64 offset      = 0;
+		i32 bufferIndex = -1;
+		// Called from the thread that sees the operation complete
+		std::function<void(i64)> onComplete;
+
+
+		/** Runs the operation blocking the calling thread */
+		i64 Execute() const
+		{
+#if PLATFORM_WINDOWS
+			OVERLAPPED overlapped{};
+			overlapped.Offset     = DWORD(offset);
+			overlapped.OffsetHigh = DWORD(offset >> 32);
+			DWORD transferred     = 0;
+			const BOOL bSuccess =
+			    bWrite ? WriteFile(HANDLE(handle), data, size, &transferred, &overlapped)
+			           : ReadFile(HANDLE(handle), data, size, &transferred, &overlapped);
+			if (!bSuccess && GetLastError() != ERROR_HANDLE_EOF)
+			{
+				return -i64(GetLastError());
+			}
+			return i64(transferred);
+#else
+			const ssize_t transferred = bWrite ? pwrite(i32(handle), data, size, off_t(offset))
+			                                   : pread(i32(handle), data, size, off_t(offset));
+			return transferred >= 0 ? i64(transferred) : -i64(errno);
+#endif
+		}
+	};
+
+
+	/** Runs a callback as a worker task when the operation completes */
+	static std::function<void(i64)> ToTask(const TaskSystem& tasks, AsyncIO::Callback callback)
+	{
+		return [&tasks, callback = Move(callback)](i64 result) {
+			tasks.RunAsync([callback, result]() {
+				callback(result);
+			});
+		};
+	}
+
+	/** @return future set when the operation completes */
+	static std::future<i64> ToPromise(std::function<void(i64)>& onComplete)
+	{
+		auto promise = std::make_shared<std::promise<i64>>();
+		onComplete   = [promise](i64 result) {
+			promise->set_value(result);
+		};
+		return promise->get_future();
+	}
+
+
+	struct AsyncIO::FileLoad
+	{
+		IOFile file;
+		String& result;
+		u64 size = 0;
+		u64 read = 0;
+		std::promise<bool> promise;
+	};
+
+
+#if PLATFORM_LINUX
+	/** io_uring queues, shared with the kernel */
+	struct AsyncIO::Ring
+	{
+		i32 fd             = -1;
+		void* sqMap        = nullptr;
+		sizet sqMapSize    = 0;
+		void* cqMap        = nullptr;
+		sizet cqMapSize    = 0;
+		io_uring_sqe* sqes = nullptr;
+		sizet sqesSize     = 0;
+
+		u32* sqHead        = nullptr;
+		u32* sqTail        = nullptr;
+		u32* sqArray       = nullptr;
+		u32 sqMask         = 0;
+		u32 sqEntries      = 0;
+		u32* cqHead        = nullptr;
+		u32* cqTail        = nullptr;
+		io_uring_cqe* cqes = nullptr;
+		u32 cqMask         = 0;
+
+		// Set if the kernel didn't take all entries, so that they are submitted again later
+		std::atomic<bool> bRetrySubmit{false};
+		// Entries taken by the kernel that didn't complete yet
+		std::atomic<u32> numInFlight{0};
+
+
+		~Ring()
+		{
+			if (sqes)
+			{
+				munmap(sqes, sqesSize);
+			}
+			if (cqMap && cqMap != sqMap)
+			{
+				munmap(cqMap, cqMapSize);
+			}
+			if (sqMap)
+			{
+				munmap(sqMap, sqMapSize);
+			}
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+		}
+
+		bool Init(u32 entries)
+		{
+			io_uring_params params{};
+			fd = i32(syscall(__NR_io_uring_setup, entries, &params));
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			sqMapSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+			cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool bSingleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+			if (bSingleMap)
+			{
+				sqMapSize = cqMapSize = Math::Max(sqMapSize, cqMapSize);
+			}
+
+			sqMap = Map(sqMapSize, IORING_OFF_SQ_RING);
+			if (!sqMap)
+			{
+				return false;
+			}
+			cqMap = bSingleMap ? sqMap : Map(cqMapSize, IORING_OFF_CQ_RING);
+			if (!cqMap)
+			{
+				return false;
+			}
+			sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			sqes     = static_cast<io_uring_sqe*>(Map(sqesSize, IORING_OFF_SQES));
+			if (!sqes)
+			{
+				return false;
+			}
+
+			u8* const sq = static_cast<u8*>(sqMap);
+			sqHead       = reinterpret_cast<u32*>(sq + params.sq_off.head);
+			sqTail       = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+			sqArray      = reinterpret_cast<u32*>(sq + params.sq_off.array);
+			sqMask       = *reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+			sqEntries    = params.sq_entries;
+
+			u8* const cq = static_cast<u8*>(cqMap);
+			cqHead       = reinterpret_cast<u32*>(cq + params.cq_off.head);
+			cqTail       = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+			cqes         = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+			cqMask       = *reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+			return SupportsOperations();
+		}
+
+		/** @return true if the kernel supports all operations used. Some came after io_uring */
+		bool SupportsOperations() const
+		{
+			// Probing came with IORING_OP_READ and IORING_OP_WRITE, so kernels without it
+			// don't have them either
+			static constexpr u32 maxOps = 256;
+			TArray<u8> data(u32(sizeof(io_uring_probe) + maxOps * sizeof(io_uring_probe_op)), 0);
+			auto* const probe = reinterpret_cast<io_uring_probe*>(data.Data());
+			if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, maxOps) < 0)
+			{
+				return false;
+			}
+			for (const u8 op : {IORING_OP_NOP, IORING_OP_READ, IORING_OP_WRITE,
+			         IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED})
+			{
+				if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void* Map(sizet size, u64 offset) const
+		{
+			void* const ptr =
+			    mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+			return ptr != MAP_FAILED ? ptr : nullptr;
+		}
+
+		/** @return next free entry, or null if the queue is full */
+		io_uring_sqe* NextEntry()
+		{
+			const u32 tail = *sqTail;
+			if (tail - std::atomic_ref<u32>(*sqHead).load(std::memory_order_acquire) >= sqEntries)
+			{
+				return nullptr;
+			}
+			io_uring_sqe* const sqe = &sqes[tail & sqMask];
+			*sqe                    = {};
+			sqArray[tail & sqMask]  = tail & sqMask;
+			return sqe;
+		}
+
+		/** Makes the last entry returned by NextEntry visible to the kernel */
+		void Push()
+		{
+			std::atomic_ref<u32>(*sqTail).fetch_add(1, std::memory_order_release);
+		}
+
+		/** @return entries pushed but not taken by the kernel */
+		u32 GetNumUnsubmitted() const
+		{
+			return *sqTail - std::atomic_ref<u32>(*sqHead).load(std::memory_order_acquire);
+		}
+
+		i32 Enter(u32 toSubmit, u32 minComplete, u32 flags) const
+		{
+			const i32 result = i32(
+			    syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+			return result >= 0 ? result : -errno;
+		}
+
+		/**
+		 * Passes pushed entries to the kernel. Must be called with AsyncIO::mutex locked
+		 * @return 0, or the error that kept entries from being submitted. Those are left pushed
+		 */
+		i32 Submit()
+		{
+			u32 unsubmitted = GetNumUnsubmitted();
+			while (unsubmitted > 0)
+			{
+				const i32 result = Enter(unsubmitted, 0, 0);
+				if (result == -EINTR)
+				{
+					continue;
+				}
+				if (result < 0)
+				{
+					if (result == -EBUSY || result == -EAGAIN)
+					{
+						// Kernel is busy. Tried again once completions are consumed, if any
+						// are coming. Set before checking, since completions clear it after
+						// counting themselves
+						bRetrySubmit = true;
+						if (numInFlight > 0)
+						{
+							return 0;
+						}
+						bRetrySubmit = false;
+					}
+					return result;
+				}
+				numInFlight += u32(result);
+				unsubmitted = GetNumUnsubmitted();
+			}
+			return 0;
+		}
+
+		/**
+		 * Takes back the entries pushed but not submitted, adding their operations.
+		 * The kernel only reads entries when they are submitted
+		 */
+		void TakeUnsubmitted(TArray<Operation*>& operations)
+		{
+			const u32 head = std::atomic_ref<u32>(*sqHead).load(std::memory_order_acquire);
+			for (u32 i = head; i != *sqTail; ++i)
+			{
+				const io_uring_sqe& sqe = sqes[sqArray[i & sqMask]];
+				if (sqe.user_data != 0)
+				{
+					operations.Add(reinterpret_cast<Operation*>(sqe.user_data));
+				}
+			}
+			std::atomic_ref<u32>(*sqTail).store(head, std::memory_order_release);
+		}
+	};
+#else
+	struct AsyncIO::Ring
+	{};
+#endif
+
+
+	IOFile& IOFile::operator=(IOFile&& other)
+	{
+		if (this != &other)
+		{
+			Close();
+			handle       = other.handle;
+			other.handle = -1;
+		}
+		return *this;
+	}
+
+	IOFile IOFile::Open(const Path& path, bool bWrite)
+	{
+		IOFile file;
+#if PLATFORM_WINDOWS
+		const HANDLE handle = CreateFileW(path.c_str(), bWrite ? GENERIC_WRITE : GENERIC_READ,
+		    FILE_SHARE_READ, nullptr, bWrite ? CREATE_ALWAYS : OPEN_EXISTING,
+		    FILE_ATTRIBUTE_NORMAL, nullptr);
+		file.handle = handle != INVALID_HANDLE_VALUE ? intptr_t(handle) : -1;
+#else
+		const i32 flags = bWrite ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY;
+		file.handle     = open(path.c_str(), flags | O_CLOEXEC, 0644);
+#endif
+		return file;
+	}
+
+	void IOFile::Close()
+	{
+		if (IsOpen())
+		{
+#if PLATFORM_WINDOWS
+			CloseHandle(HANDLE(handle));
+#else
+			close(i32(handle));
+#endif
+			handle = -1;
+		}
+	}
+
+	u64 IOFile::GetSize() const
+	{
+		if (!IsOpen())
+		{
+			return 0;
+		}
+#if PLATFORM_WINDOWS
+		LARGE_INTEGER size;
+		return GetFileSizeEx(HANDLE(handle), &size) ? u64(size.QuadPart) : 0;
+#else
+		struct stat info;
+		return fstat(i32(handle), &info) == 0 ? u64(info.st_size) : 0;
+#endif
+	}
+
+
+	AsyncIO::AsyncIO(const TaskSystem& tasks, const AsyncIOConfig& config)
+	    : tasks{tasks}, queueDepth{Math::Max(1u, config.queueDepth)}
+	{
+#if PLATFORM_LINUX
+		if (config.bUseIOUring)
+		{
+			ring = std::make_unique<Ring>();
+			if (ring->Init(queueDepth))
+			{
+				completionThread = std::thread{[this]() {
+					WaitCompletions();
+				}};
+			}
+			else
+			{
+				Log::Warning("io_uring is not available, file I/O will run on IO threads");
+				ring.reset();
+			}
+		}
+#endif
+	}
+
+	AsyncIO::~AsyncIO()
+	{
+		Flush();
+#if PLATFORM_LINUX
+		if (ring)
+		{
+			// An entry without operation stops the completion thread
+			{
+				std::unique_lock<std::mutex> lock{mutex};
+				io_uring_sqe* sqe = ring->NextEntry();
+				while (!sqe)
+				{
+					ring->Submit();
+					sqe = ring->NextEntry();
+				}
+				sqe->opcode    = IORING_OP_NOP;
+				sqe->user_data = 0;
+				ring->Push();
+				if (const i32 result = ring->Submit(); result < 0)
+				{
+					// The completion thread can't be woken. It keeps waiting on the leaked ring
+					Log::Error("io_uring failed to stop: {}", std::strerror(-result));
+					completionThread.detach();
+					ring.release();
+					return;
+				}
+			}
+			completionThread.join();
+		}
+#endif
+	}
+
+	void AsyncIO::Read(const IOFile& file, std::span<u8> buffer, u64 offset, Callback onComplete,
+	    i32 bufferIndex)
+	{
+		auto operation =
+		    MakeOperation(false, file, buffer.data(), buffer.size(), offset, bufferIndex);
+		operation->onComplete = ToTask(tasks, Move(onComplete));
+		Queue(Move(operation));
+	}
+
+	void AsyncIO::Write(const IOFile& file, std::span<const u8> buffer, u64 offset,
+	    Callback onComplete, i32 bufferIndex)
+	{
+		auto operation =
+		    MakeOperation(true, file, buffer.data(), buffer.size(), offset, bufferIndex);
+		operation->onComplete = ToTask(tasks, Move(onComplete));
+		Queue(Move(operation));
+	}
+
+	std::future<i64> AsyncIO::Read(
+	    const IOFile& file, std::span<u8> buffer, u64 offset, i32 bufferIndex)
+	{
+		auto operation =
+		    MakeOperation(false, file, buffer.data(), buffer.size(), offset, bufferIndex);
+		std::future<i64> result = ToPromise(operation->onComplete);
+		Queue(Move(operation));
+		return result;
+	}
+
+	std::future<i64> AsyncIO::Write(
+	    const IOFile& file, std::span<const u8> buffer, u64 offset, i32 bufferIndex)
+	{
+		auto operation =
+		    MakeOperation(true, file, buffer.data(), buffer.size(), offset, bufferIndex);
+		std::future<i64> result = ToPromise(operation->onComplete);
+		Queue(Move(operation));
+		return result;
+	}
+
+	std::future<bool> AsyncIO::LoadFile(const Path& path, String& result)
+	{
+		auto load  = std::make_shared<FileLoad>(IOFile::Open(path), result);
+		auto value = load->promise.get_future();
+		if (!load->file.IsOpen())
+		{
+			load->promise.set_value(false);
+			return value;
+		}
+
+		load->size = load->file.GetSize();
+		result.resize(load->size);
+		if (load->size == 0)
+		{
+			load->promise.set_value(true);
+			return value;
+		}
+		ReadRemaining(Move(load));
+		return value;
+	}
+
+	void AsyncIO::ReadRemaining(std::shared_ptr<FileLoad> load)
+	{
+		const u64 size = Math::Min(load->size - load->read, maxOperationSize);
+		auto operation = MakeOperation(false, load->file,
+		    reinterpret_cast<u8*>(load->result.data()) + load->read, size, load->read, -1);
+		operation->onComplete = [this, load](i64 result) {
+			if (result <= 0)
+			{
+				load->promise.set_value(false);
+				return;
+			}
+			load->read += u64(result);
+			if (load->read < load->size)
+			{
+				// Short read, continue where it stopped
+				ReadRemaining(load);
+				Submit();
+				return;
+			}
+			load->file.Close();
+			load->promise.set_value(true);
+		};
+		Queue(Move(operation));
+	}
+
+	void AsyncIO::Submit()
+	{
+		std::unique_lock<std::mutex> lock{mutex};
+		if (ring)
+		{
+			TArray<Operation*> failed;
+			const i32 result = SubmitToRing(failed);
+			lock.unlock();
+			for (Operation* operation : failed)
+			{
+				Complete(operation, result);
+			}
+			return;
+		}
+
+		for (std::unique_ptr<Operation>& queuedOperation : queued)
+		{
+			tasks.RunIO([this, operation = queuedOperation.release()]() {
+				Complete(operation, operation->Execute());
+			});
+		}
+		queued.Empty(false);
+	}
+
+	void AsyncIO::Flush()
+	{
+		Submit();
+		u32 pending = numPending.load(std::memory_order_acquire);
+		while (pending > 0)
+		{
+			numPending.wait(pending, std::memory_order_acquire);
+			pending = numPending.load(std::memory_order_acquire);
+		}
+	}
+
+	bool AsyncIO::RegisterBuffers(TArray<std::span<u8>> newBuffers)
+	{
+		assert(numPending == 0 && "Buffers can't change while operations are pending");
+		UnregisterBuffers();
+
+		std::unique_lock<std::mutex> lock{mutex};
+		buffers = Move(newBuffers);
+#if PLATFORM_LINUX
+		if (ring && !buffers.IsEmpty())
+		{
+			TArray<iovec> vectors;
+			vectors.Reserve(buffers.Size());
+			for (const std::span<u8>& buffer : buffers)
+			{
+				vectors.Add({buffer.data(), buffer.size()});
+			}
+			const i32 result = i32(syscall(__NR_io_uring_register, ring->fd,
+			    IORING_REGISTER_BUFFERS, vectors.Data(), u32(vectors.Size())));
+			if (result < 0)
+			{
+				// Operations fall back to plain reads and writes
+				buffers.Empty();
+				return false;
+			}
+		}
+#endif
+		return true;
+	}
+
+	void AsyncIO::UnregisterBuffers()
+	{
+		std::unique_lock<std::mutex> lock{mutex};
+#if PLATFORM_LINUX
+		if (ring && !buffers.IsEmpty())
+		{
+			syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+		}
+#endif
+		buffers.Empty();
+	}
+
+	AsyncIO& AsyncIO::Get()
+	{
+		return Context::Get()->GetAsyncIO();
+	}
+
+	std::unique_ptr<AsyncIO::Operation> AsyncIO::MakeOperation(bool bWrite, const IOFile& file,
+	    const u8* data, sizet size, u64 offset, i32 bufferIndex)
+	{
+		assert(size <= maxOperationSize && "Operation is too big");
+		auto operation         = std::make_unique<Operation>();
+		operation->bWrite      = bWrite;
+		operation->handle      = file.GetHandle();
+		operation->data        = const_cast<u8*>(data);
+		operation->size        = u32(size);
+		operation->offset      = offset;
+		operation->bufferIndex = bufferIndex;
+		return operation;
+	}
+
+	void AsyncIO::Queue(std::unique_ptr<Operation> operation)
+	{
+		numPending.fetch_add(1, std::memory_order_relaxed);
+		bool bFull;
+		{
+			std::unique_lock<std::mutex> lock{mutex};
+			queued.Add(Move(operation));
+			bFull = u32(queued.Size()) >= queueDepth;
+		}
+		if (bFull)
+		{
+			Submit();
+		}
+	}
+
+	i32 AsyncIO::SubmitToRing(TArray<Operation*>& failed)
+	{
+#if PLATFORM_LINUX
+		// Operations the kernel refused complete with the error
+		const auto fail = [this, &failed](i32 first) {
+			ring->TakeUnsubmitted(failed);
+			for (i32 i = first; i < queued.Size(); ++i)
+			{
+				failed.Add(queued[i].release());
+			}
+			queued.Empty(false);
+		};
+
+		for (std::unique_ptr<Operation>& operation : queued)
+		{
+			io_uring_sqe* sqe = ring->NextEntry();
+			while (!sqe)
+			{
+				// Queue is full. The kernel copies entries when they are submitted
+				if (const i32 result = ring->Submit(); result < 0)
+				{
+					fail(i32(&operation - queued.Data()));
+					return result;
+				}
+				if (ring->bRetrySubmit)
+				{
+					// Kernel is busy, keep the rest for later
+					queued.RemoveAt(0, i32(&operation - queued.Data()), false);
+					return 0;
+				}
+				sqe = ring->NextEntry();
+			}
+
+			const bool bFixed = operation->bufferIndex >= 0 && !buffers.IsEmpty();
+			if (bFixed)
+			{
+				sqe->opcode    = operation->bWrite ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+				sqe->buf_index = u16(operation->bufferIndex);
+			}
+			else
+			{
+				sqe->opcode = operation->bWrite ? IORING_OP_WRITE : IORING_OP_READ;
+			}
+			sqe->fd        = i32(operation->handle);
+			sqe->addr      = u64(operation->data);
+			sqe->len       = operation->size;
+			sqe->off       = operation->offset;
+			sqe->user_data = u64(operation.release());
+			ring->Push();
+		}
+		queued.Empty(false);
+		if (const i32 result = ring->Submit(); result < 0)
+		{
+			fail(0);
+			return result;
+		}
+#endif
+		return 0;
+	}
+
+	void AsyncIO::WaitCompletions()
+	{
+#if PLATFORM_LINUX
+		tracy::SetThreadName("IO Completions");
+		bool bStop = false;
+		while (!bStop)
+		{
+			u32 head       = *ring->cqHead;
+			const u32 tail = std::atomic_ref<u32>(*ring->cqTail).load(std::memory_order_acquire);
+			if (head == tail)
+			{
+				ring->Enter(0, 1, IORING_ENTER_GETEVENTS);
+				continue;
+			}
+
+			ring->numInFlight -= tail - head;
+			for (; head != tail; ++head)
+			{
+				const io_uring_cqe& cqe = ring->cqes[head & ring->cqMask];
+				if (cqe.user_data == 0)
+				{
+					bStop = true;
+					continue;
+				}
+				Complete(reinterpret_cast<Operation*>(cqe.user_data), cqe.res);
+			}
+			std::atomic_ref<u32>(*ring->cqHead).store(head, std::memory_order_release);
+
+			if (!bStop && ring->bRetrySubmit.exchange(false))
+			{
+				std::unique_lock<std::mutex> lock{mutex};
+				TArray<Operation*> failed;
+				i32 result = ring->Submit();
+				if (result < 0)
+				{
+					ring->TakeUnsubmitted(failed);
+				}
+				else
+				{
+					result = SubmitToRing(failed);
+				}
+				lock.unlock();
+				for (Operation* operation : failed)
+				{
+					Complete(operation, result);
+				}
+			}
+		}
+#endif
+	}
+
+	void AsyncIO::Complete(Operation* operation, i64 result)
+	{
+		ZoneScopedN("AsyncIO::Complete");
+		operation->onComplete(result);
+		delete operation;
+		if (numPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			numPending.notify_all();
+		}
+	}
+}    // namespace Rift
@@ -0,0 +1,287 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Files/DirectoryCrawler.h"
+
+#include "Profiler.h"
+#include "Tasks.h"
+
+#include <condition_variable>
+
+#if PLATFORM_LINUX
+#	include <dirent.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+
+namespace Rift
+{
+	struct DirectoryCrawler::Job
+	{
+		// Only used while directories are outstanding, so late helpers never touch them
+		DirectoryCrawler& crawler;
+		const CrawlSettings& settings;
+		const TaskSystem& tasks;
+		i32 maxHelpers = 0;
+
+		std::mutex mutex;
+		std::condition_variable changed;
+		TArray<Path> pending;
+		// Directories pending or being listed
+		i32 numOutstanding = 0;
+		i32 numHelpers     = 0;
+		TArray<Path> found;
+
+
+		Job(DirectoryCrawler& crawler, const CrawlSettings& settings, const TaskSystem& tasks)
+		    : crawler{crawler}
+		    , settings{settings}
+		    , tasks{tasks}
+		    , maxHelpers{i32(tasks.GetNumWorkerThreads())}
+		{}
+	};
+
+
+#if PLATFORM_LINUX
+	// Layout of the entries returned by getdents64
+	struct LinuxDirent64
+	{
+		u64 ino;
+		i64 off;
+		u16 reclen;
+		u8 type;
+		char name[];
+	};
+
+	static i64 GetModifiedTime(const struct stat& info)
+	{
+		return i64(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+	}
+#endif
+
+
+	static bool MatchesExtension(StringView name, StringView extension)
+	{
+		return extension.empty()
+		    || (name.size() > extension.size() && name.ends_with(extension));
+	}
+
+
+	bool DirectoryCrawler::List(const Path& folder, Listing& listing)
+	{
+#if PLATFORM_LINUX
+		const i32 fd = open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			return false;
+		}
+		struct stat info;
+		if (fstat(fd, &info) == 0)
+		{
+			listing.modified = GetModifiedTime(info);
+		}
+
+		alignas(8) u8 buffer[16 * 1024];
+		while (true)
+		{
+			const i64 size = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+			if (size <= 0)
+			{
+				break;
+			}
+			for (i64 offset = 0; offset < size;)
+			{
+				const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+				offset += entry->reclen;
+
+				const StringView name{entry->name};
+				if (name == "." || name == "..")
+				{
+					continue;
+				}
+
+				u8 type = entry->type;
+				struct stat entryInfo;
+				if (type == DT_UNKNOWN)
+				{
+					// Some file systems don't report types. Links are checked below
+					if (fstatat(fd, entry->name, &entryInfo, AT_SYMLINK_NOFOLLOW) != 0)
+					{
+						continue;
+					}
+					if (S_ISDIR(entryInfo.st_mode))
+					{
+						type = DT_DIR;
+					}
+					else if (S_ISREG(entryInfo.st_mode))
+					{
+						type = DT_REG;
+					}
+					else if (S_ISLNK(entryInfo.st_mode))
+					{
+						type = DT_LNK;
+					}
+				}
+				if (type == DT_LNK)
+				{
+					// Links are followed only to files, so folder links can't form cycles
+					const bool bFile =
+					    fstatat(fd, entry->name, &entryInfo, 0) == 0 && S_ISREG(entryInfo.st_mode);
+					type = bFile ? DT_REG : DT_UNKNOWN;
+				}
+
+				if (type == DT_DIR)
+				{
+					listing.folders.Add(String{name});
+				}
+				else if (type == DT_REG)
+				{
+					listing.files.Add(String{name});
+				}
+			}
+		}
+		close(fd);
+		return true;
+#else
+		std::error_code error;
+		fs::directory_iterator it{folder, error};
+		if (error)
+		{
+			return false;
+		}
+		listing.modified = fs::last_write_time(folder, error).time_since_epoch().count();
+		for (const fs::directory_entry& entry : it)
+		{
+			// Types are cached by the iterator on most platforms
+			if (entry.is_directory(error) && !entry.is_symlink(error))
+			{
+				listing.folders.Add(FileSystem::ToString(entry.path().filename()));
+			}
+			else if (entry.is_regular_file(error))
+			{
+				listing.files.Add(FileSystem::ToString(entry.path().filename()));
+			}
+		}
+		return true;
+#endif
+	}
+
+	TArray<Path> DirectoryCrawler::Crawl(const Path& folder, const CrawlSettings& settings)
+	{
+		ZoneScopedNC("DirectoryCrawler::Crawl", 0xBB45D1);
+
+		const TaskSystem& tasks = settings.tasks ? *settings.tasks : TaskSystem::Get();
+		const auto job = std::make_shared<Job>(*this, settings, tasks);
+		job->pending.Add(folder);
+		job->numOutstanding = 1;
+		Run(job, true);
+		std::unique_lock<std::mutex> lock{job->mutex};
+		return Move(job->found);
+	}
+
+	void DirectoryCrawler::ClearCache()
+	{
+		std::unique_lock<std::mutex> lock{cacheMutex};
+		cache = {};
+	}
+
+	std::shared_ptr<const DirectoryCrawler::Listing> DirectoryCrawler::GetListing(
+	    const Path& folder, bool bUseCache)
+	{
+		String key;
+		if (bUseCache)
+		{
+			key = FileSystem::ToString(folder);
+#if PLATFORM_LINUX
+			struct stat info;
+			const i64 modified = stat(folder.c_str(), &info) == 0 ? GetModifiedTime(info) : -1;
+#else
+			std::error_code error;
+			const i64 modified = fs::last_write_time(folder, error).time_since_epoch().count();
+#endif
+			std::unique_lock<std::mutex> lock{cacheMutex};
+			if (const auto* cached = cache.Find(key); cached && (*cached)->modified == modified)
+			{
+				return *cached;
+			}
+		}
+
+		auto listing = std::make_shared<Listing>();
+		if (!List(folder, *listing))
+		{
+			return {};
+		}
+		if (bUseCache)
+		{
+			std::unique_lock<std::mutex> lock{cacheMutex};
+			cache.Insert(Move(key), listing);
+		}
+		return listing;
+	}
+
+	void DirectoryCrawler::Run(const std::shared_ptr<Job>& job, bool bCaller)
+	{
+		TArray<Path> found;
+		std::unique_lock<std::mutex> lock{job->mutex};
+		while (true)
+		{
+			if (job->pending.IsEmpty())
+			{
+				// Like Dispatch, the caller doesn't wait for helpers that didn't start
+				if (!bCaller || job->numOutstanding == 0)
+				{
+					break;
+				}
+				// Wait for other threads to find more directories or to finish
+				job->changed.wait(lock);
+				continue;
+			}
+
+			const Path folder = Move(job->pending.Last());
+			job->pending.RemoveAt(job->pending.Size() - 1, false);
+			lock.unlock();
+
+			const auto listing = job->crawler.GetListing(folder, job->settings.bUseCache);
+			if (listing)
+			{
+				for (const String& file : listing->files)
+				{
+					if (MatchesExtension(file, job->settings.extension))
+					{
+						found.Add(folder / file);
+					}
+				}
+			}
+
+			lock.lock();
+			job->found.Append(Move(found));
+			found.Empty(false);
+			if (listing && job->settings.bRecursive)
+			{
+				for (const String& child : listing->folders)
+				{
+					job->pending.Add(folder / child);
+				}
+				job->numOutstanding += listing->folders.Size();
+			}
+			--job->numOutstanding;
+
+			// Split the remaining subtrees between idle workers
+			while (job->numHelpers < job->maxHelpers && job->pending.Size() > 1)
+			{
+				++job->numHelpers;
+				job->tasks.RunAsync([job]() {
+					Run(job, false);
+				});
+			}
+			job->changed.notify_all();
+		}
+
+		if (!bCaller)
+		{
+			--job->numHelpers;
+		}
+	}
+}    // namespace Rift
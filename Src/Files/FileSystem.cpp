@@ -2,6 +2,7 @@
 
 #include "Files/FileSystem.h"
 
+#include "Files/FileView.h"
 #include "Profiler.h"
 
 
@@ -16,15 +17,17 @@ namespace Rift
 			return false;
 		}
 
-		std::ifstream file(path);
-		result = {};
-		try
+		const FileView file{path};
+		if (!file.IsOpen())
 		{
-			file >> result;
+			return false;
 		}
-		catch (nlohmann::detail::exception& ex)
+		// Parse straight from the mapped file
+		result = Json::parse(file.GetData(), file.GetData() + file.GetSize(), nullptr, false);
+		if (result.is_discarded())
 		{
-			Log::Error("Failed to parse json asset:\n{}", ex.what());
+			Log::Error("Failed to parse json file: {}", ToString(path));
+			result = {};
 			return false;
 		}
 		return true;
@@ -58,18 +61,8 @@ namespace Rift
 			return false;
 		}
 
-		std::ifstream file(path);
-
-		// Clean string and reserve it
-		result = {};
-		file.seekg(0, std::ios::end);
-		result.reserve(i32(file.tellg()));
-		file.seekg(0, std::ios::beg);
-
-		// Improve by avoiding this copy from std::string to String
-		std::string str{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
-		result.assign(str.data(), str.size());
-
+		const FileView file{path};
+		result.assign(file.GetString());
 		return !result.empty();
 	}
 
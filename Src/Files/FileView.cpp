@@ -0,0 +1,170 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Files/FileView.h"
+
+#include "Profiler.h"
+
+#include <utility>
+
+#if PLATFORM_WINDOWS
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+
+namespace Rift
+{
+#if !PLATFORM_WINDOWS
+	/** Reads a file until its end. Used for files that report no size, like the ones of /proc */
+	static void ReadAll(i32 fd, TArray<u8>& buffer)
+	{
+		constexpr i32 chunkSize = 4096;
+		i32 used                = 0;
+		while (true)
+		{
+			buffer.Resize(used + chunkSize);
+			const ssize_t read = ::read(fd, buffer.Data() + used, chunkSize);
+			if (read <= 0)
+			{
+				break;
+			}
+			used += i32(read);
+		}
+		buffer.Resize(used);
+	}
+#endif
+
+
+	FileView::FileView(const Path& path, FileAccess access)
+	{
+		ZoneScopedNC("FileView", 0xBB45D1);
+#if PLATFORM_WINDOWS
+		const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		    OPEN_EXISTING,
+		    access == FileAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+		                                     : FILE_FLAG_RANDOM_ACCESS,
+		    nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+		bOpen = true;
+
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+		{
+			// The view keeps the file referenced, so both handles can close
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping)
+			{
+				data    = static_cast<const u8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				bMapped = data != nullptr;
+				size    = bMapped ? sizet(fileSize.QuadPart) : 0;
+			}
+		}
+		CloseHandle(file);
+#else
+		const i32 fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			return;
+		}
+		bOpen = true;
+
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void* const map = mmap(nullptr, sizet(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map != MAP_FAILED)
+			{
+				data    = static_cast<const u8*>(map);
+				size    = sizet(info.st_size);
+				bMapped = true;
+				if (access == FileAccess::Sequential)
+				{
+					madvise(map, size, MADV_SEQUENTIAL);
+					madvise(map, size, MADV_WILLNEED);
+				}
+				else
+				{
+					madvise(map, size, MADV_RANDOM);
+				}
+			}
+		}
+		if (!bMapped)
+		{
+			ReadAll(fd, buffer);
+			data = buffer.Data();
+			size = sizet(buffer.Size());
+		}
+		// The mapping stays valid after closing the file
+		close(fd);
+#endif
+	}
+
+	FileView::FileView(FileView&& other)
+	{
+		*this = Move(other);
+	}
+
+	FileView& FileView::operator=(FileView&& other)
+	{
+		if (this != &other)
+		{
+			Close();
+			data    = std::exchange(other.data, nullptr);
+			size    = std::exchange(other.size, 0);
+			bOpen   = std::exchange(other.bOpen, false);
+			bMapped = std::exchange(other.bMapped, false);
+			buffer  = Move(other.buffer);
+			owner   = Move(other.owner);
+#if PLATFORM_WINDOWS
+			mapping = std::exchange(other.mapping, nullptr);
+#endif
+		}
+		return *this;
+	}
+
+	FileView FileView::Slice(std::shared_ptr<const FileView> owner, sizet offset, sizet size)
+	{
+		FileView view;
+		if (owner && owner->IsOpen() && offset + size <= owner->GetSize())
+		{
+			view.data    = owner->GetData() + offset;
+			view.size    = size;
+			view.bOpen   = true;
+			view.bMapped = owner->IsMapped();
+			view.owner   = Move(owner);
+		}
+		return view;
+	}
+
+	void FileView::Close()
+	{
+		if (IsMapped() && !owner)
+		{
+#if PLATFORM_WINDOWS
+			UnmapViewOfFile(data);
+#else
+			munmap(const_cast<u8*>(data), size);
+#endif
+		}
+#if PLATFORM_WINDOWS
+		if (mapping)
+		{
+			CloseHandle(mapping);
+			mapping = nullptr;
+		}
+#endif
+		buffer.Empty();
+		owner.reset();
+		data    = nullptr;
+		size    = 0;
+		bOpen   = false;
+		bMapped = false;
+	}
+}    // namespace Rift
@@ -0,0 +1,559 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Files/FileWatcher.h"
+
+#include "Containers/Map.h"
+#include "Files/DirectoryCrawler.h"
+#include "Log.h"
+#include "Math/Math.h"
+#include "Profiler.h"
+#include "Tasks.h"
+
+#include <common/TracySystem.hpp>
+#include <condition_variable>
+
+#if PLATFORM_LINUX
+#	include <poll.h>
+#	include <sys/eventfd.h>
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#endif
+
+
+namespace Rift
+{
+#if PLATFORM_LINUX
+	static constexpr u32 watchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE
+	                               | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+#endif
+
+
+	/** @return true if path is folder or is inside of it */
+	static bool IsInFolder(const Path& path, const Path& folder)
+	{
+		const auto& native       = path.native();
+		const auto& folderNative = folder.native();
+		return native.starts_with(folderNative)
+		    && (native.size() == folderNative.size()
+		        || native[folderNative.size()] == Path::preferred_separator);
+	}
+
+
+	struct PolledFile
+	{
+		i64 modified = 0;
+		bool bFolder = false;
+	};
+
+	static void Scan(const Path& root, TMap<String, PolledFile>& files)
+	{
+		ZoneScopedNC("FileWatcher::Scan", 0xBB45D1);
+		std::error_code error;
+		const auto options = fs::directory_options::skip_permission_denied;
+		for (fs::recursive_directory_iterator it{root, options, error}, end; it != end;
+		     it.increment(error))
+		{
+			PolledFile file;
+			file.bFolder = it->is_directory(error);
+			if (!file.bFolder)
+			{
+				file.modified = it->last_write_time(error).time_since_epoch().count();
+			}
+			files.Insert(FileSystem::ToString(it->path()), file);
+		}
+	}
+
+
+	struct FileWatcher::State
+	{
+		TArray<Path> roots;
+		// Increased when roots change, to discard scans that started before
+		u32 rootsVersion = 0;
+
+		// Changes not posted yet, merged by path
+		TArray<FileChange> changes;
+		TMap<String, i32> changeIndices;
+		Chrono::steady_clock::time_point firstChange;
+		Chrono::steady_clock::time_point lastChange;
+
+#if PLATFORM_LINUX
+		i32 inotifyFd = -1;
+		// Wakes the thread up to stop
+		i32 wakeFd = -1;
+		// Folder of each watch
+		TMap<i32, Path> folders;
+		// Moves waiting for their destination, by cookie
+		TMap<u32, FileChange> moves;
+#endif
+
+		// Files found in the last scan of the polling fallback
+		TMap<String, PolledFile> snapshot;
+		std::condition_variable wake;
+
+
+		void AddChange(
+		    FileChangeType type, const Path& path, bool bFolder, const Path& oldPath = {});
+
+#if PLATFORM_LINUX
+		/** Watches folder and its subfolders. If bReport, their contents are reported as added */
+		bool AddFolder(const Path& folder, bool bReport);
+		void RemoveFolder(const Path& folder);
+		void RenameFolder(const Path& from, const Path& to);
+#endif
+	};
+
+
+	void FileWatcher::State::AddChange(
+	    FileChangeType type, const Path& path, bool bFolder, const Path& oldPath)
+	{
+		if (type == FileChangeType::Renamed)
+		{
+			const i32* index = changeIndices.Find(FileSystem::ToString(oldPath));
+			if (index && !changes[*index].path.empty()
+			    && changes[*index].type == FileChangeType::Added)
+			{
+				// Created and renamed in the same batch, so listeners only see it added
+				changes[*index].path.clear();
+				type = FileChangeType::Added;
+			}
+		}
+
+		String key = FileSystem::ToString(path);
+		if (const i32* index = changeIndices.Find(key))
+		{
+			FileChange& change = changes[*index];
+			// Changes with no path were discarded
+			if (!change.path.empty())
+			{
+				if (change.type == FileChangeType::Added && type == FileChangeType::Removed)
+				{
+					change.path.clear();
+					return;
+				}
+				if (type == FileChangeType::Modified && change.type != FileChangeType::Removed)
+				{
+					return;
+				}
+				if (change.type == FileChangeType::Removed && type == FileChangeType::Added)
+				{
+					type = FileChangeType::Modified;
+				}
+				else if (change.type == FileChangeType::Renamed && type == FileChangeType::Removed)
+				{
+					change = {type, change.oldPath, {}, bFolder};
+					return;
+				}
+			}
+			change = {type, path, oldPath, bFolder};
+			return;
+		}
+		changeIndices.Insert(Move(key), changes.Add({type, path, oldPath, bFolder}));
+	}
+
+#if PLATFORM_LINUX
+	bool FileWatcher::State::AddFolder(const Path& folder, bool bReport)
+	{
+		const i32 wd = inotify_add_watch(inotifyFd, folder.c_str(), watchMask);
+		if (wd < 0)
+		{
+			if (errno == ENOSPC)
+			{
+				Log::Error("Out of inotify watches. Raise fs.inotify.max_user_watches");
+			}
+			return false;
+		}
+		folders[wd] = folder;
+
+		// Entries created before the watch was added have no events
+		DirectoryCrawler::Listing listing;
+		DirectoryCrawler::List(folder, listing);
+		if (bReport)
+		{
+			for (const String& file : listing.files)
+			{
+				AddChange(FileChangeType::Added, folder / file, false);
+			}
+		}
+		for (const String& child : listing.folders)
+		{
+			if (bReport)
+			{
+				AddChange(FileChangeType::Added, folder / child, true);
+			}
+			AddFolder(folder / child, bReport);
+		}
+		return true;
+	}
+
+	void FileWatcher::State::RemoveFolder(const Path& folder)
+	{
+		TArray<i32> removed;
+		for (const auto& watch : folders)
+		{
+			if (IsInFolder(watch.second, folder))
+			{
+				removed.Add(watch.first);
+			}
+		}
+		for (i32 wd : removed)
+		{
+			inotify_rm_watch(inotifyFd, wd);
+			folders.Remove(wd);
+		}
+	}
+
+	void FileWatcher::State::RenameFolder(const Path& from, const Path& to)
+	{
+		const sizet fromSize = from.native().size();
+		for (auto& watch : folders)
+		{
+			if (IsInFolder(watch.second, from))
+			{
+				Path& path = *folders.Find(watch.first);
+				path       = Path{to.native() + path.native().substr(fromSize)};
+			}
+		}
+	}
+#endif
+
+
+	FileWatcher::FileWatcher(const TaskSystem& tasks, const FileWatcherConfig& config)
+	    : tasks{tasks}, config{config}, state{std::make_unique<State>()}
+	{
+#if PLATFORM_LINUX
+		if (config.bUseINotify)
+		{
+			state->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			state->wakeFd    = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (state->inotifyFd < 0 || state->wakeFd < 0)
+			{
+				Log::Warning("Inotify is not available. Changes to files will be polled");
+				close(state->inotifyFd);
+				close(state->wakeFd);
+				state->inotifyFd = state->wakeFd = -1;
+			}
+		}
+#endif
+		thread = std::thread([this]() {
+			tracy::SetThreadName("File Watcher");
+			if (IsUsingINotify())
+			{
+				RunINotify();
+			}
+			else
+			{
+				RunPolling();
+			}
+		});
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		{
+			std::unique_lock<std::mutex> lock{mutex};
+			bStop = true;
+		}
+#if PLATFORM_LINUX
+		if (IsUsingINotify())
+		{
+			const u64 value = 1;
+			if (write(state->wakeFd, &value, sizeof(value)) != sizeof(value))
+			{
+				// Without the wake up, the thread stops after its next inotify event
+				Log::Error("Couldn't wake up the file watcher thread");
+			}
+		}
+#endif
+		state->wake.notify_all();
+		thread.join();
+
+#if PLATFORM_LINUX
+		if (IsUsingINotify())
+		{
+			close(state->inotifyFd);
+			close(state->wakeFd);
+		}
+#endif
+	}
+
+	bool FileWatcher::Watch(const Path& folder)
+	{
+		ZoneScopedNC("FileWatcher::Watch", 0xBB45D1);
+		if (!FileSystem::IsFolder(folder))
+		{
+			return false;
+		}
+
+		std::unique_lock<std::mutex> lock{mutex};
+		state->roots.Add(folder);
+		++state->rootsVersion;
+#if PLATFORM_LINUX
+		if (IsUsingINotify())
+		{
+			return state->AddFolder(folder, false);
+		}
+#endif
+		Scan(folder, state->snapshot);
+		return true;
+	}
+
+	void FileWatcher::Unwatch(const Path& folder)
+	{
+		std::unique_lock<std::mutex> lock{mutex};
+		state->roots.Remove(folder);
+		++state->rootsVersion;
+#if PLATFORM_LINUX
+		if (IsUsingINotify())
+		{
+			state->RemoveFolder(folder);
+			return;
+		}
+#endif
+		TArray<String> removed;
+		for (const auto& file : state->snapshot)
+		{
+			if (IsInFolder(FileSystem::FromString(file.first), folder))
+			{
+				removed.Add(file.first);
+			}
+		}
+		for (const String& file : removed)
+		{
+			state->snapshot.Remove(file);
+		}
+	}
+
+	bool FileWatcher::IsUsingINotify() const
+	{
+#if PLATFORM_LINUX
+		return state->inotifyFd >= 0;
+#else
+		return false;
+#endif
+	}
+
+	void FileWatcher::RunINotify()
+	{
+#if PLATFORM_LINUX
+		std::unique_lock<std::mutex> lock{mutex};
+		while (!bStop)
+		{
+			i32 timeout = -1;
+			if (!state->changes.IsEmpty() || state->moves.Size() > 0)
+			{
+				// Post once changes stop, or if they never stop, once the batch is too old
+				const auto now       = Chrono::steady_clock::now();
+				const auto remaining = Math::Min(state->lastChange + config.debounce - now,
+				    state->firstChange + config.maxLatency - now);
+				if (remaining <= Chrono::steady_clock::duration::zero())
+				{
+					PostChanges();
+					continue;
+				}
+				timeout = i32(Chrono::ceil<Chrono::milliseconds>(remaining).count());
+			}
+
+			lock.unlock();
+			pollfd fds[2]{{state->inotifyFd, POLLIN, 0}, {state->wakeFd, POLLIN, 0}};
+			poll(fds, 2, timeout);
+			lock.lock();
+
+			if (fds[0].revents & POLLIN)
+			{
+				ReadEvents();
+			}
+		}
+#endif
+	}
+
+	void FileWatcher::RunPolling()
+	{
+		std::unique_lock<std::mutex> lock{mutex};
+		while (true)
+		{
+			state->wake.wait_for(lock, config.pollInterval, [this]() {
+				return bStop.load();
+			});
+			if (bStop)
+			{
+				break;
+			}
+
+			const TArray<Path> roots = state->roots;
+			const u32 version        = state->rootsVersion;
+			lock.unlock();
+			TMap<String, PolledFile> files;
+			for (const Path& root : roots)
+			{
+				Scan(root, files);
+			}
+			lock.lock();
+
+			if (version != state->rootsVersion)
+			{
+				// Watched folders changed during the scan
+				continue;
+			}
+			for (const auto& file : files)
+			{
+				const PolledFile* last = state->snapshot.Find(file.first);
+				if (!last)
+				{
+					state->AddChange(FileChangeType::Added, FileSystem::FromString(file.first),
+					    file.second.bFolder);
+				}
+				else if (last->modified != file.second.modified)
+				{
+					state->AddChange(FileChangeType::Modified,
+					    FileSystem::FromString(file.first), file.second.bFolder);
+				}
+			}
+			for (const auto& file : state->snapshot)
+			{
+				if (!files.Contains(file.first))
+				{
+					state->AddChange(FileChangeType::Removed, FileSystem::FromString(file.first),
+					    file.second.bFolder);
+				}
+			}
+			state->snapshot = Move(files);
+			PostChanges();
+		}
+	}
+
+	void FileWatcher::ReadEvents()
+	{
+#if PLATFORM_LINUX
+		ZoneScopedNC("FileWatcher::ReadEvents", 0xBB45D1);
+		alignas(inotify_event) u8 buffer[64 * 1024];
+		while (true)
+		{
+			const ssize_t size = read(state->inotifyFd, buffer, sizeof(buffer));
+			if (size <= 0)
+			{
+				break;
+			}
+			if (state->changes.IsEmpty() && state->moves.Size() == 0)
+			{
+				state->firstChange = Chrono::steady_clock::now();
+			}
+			for (ssize_t offset = 0; offset < size;)
+			{
+				const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					Log::Warning(
+					    "File watcher missed changes. Raise fs.inotify.max_queued_events");
+					// Anything may have changed. Folders created meanwhile get their watches
+					for (const Path& root : state->roots)
+					{
+						state->AddChange(FileChangeType::Modified, root, true);
+						state->AddFolder(root, false);
+					}
+					continue;
+				}
+				if (event->mask & IN_IGNORED)
+				{
+					// The folder was removed or unwatched
+					state->folders.Remove(event->wd);
+					continue;
+				}
+				const Path* folder = state->folders.Find(event->wd);
+				if (!folder || event->len == 0)
+				{
+					continue;
+				}
+
+				const Path path    = *folder / event->name;
+				const bool bFolder = event->mask & IN_ISDIR;
+				if (event->mask & IN_CREATE)
+				{
+					state->AddChange(FileChangeType::Added, path, bFolder);
+					if (bFolder)
+					{
+						state->AddFolder(path, true);
+					}
+				}
+				else if (event->mask & IN_DELETE)
+				{
+					state->AddChange(FileChangeType::Removed, path, bFolder);
+				}
+				else if (event->mask & IN_MOVED_FROM)
+				{
+					FileChange move{FileChangeType::Removed, path, {}, bFolder};
+					state->moves.Insert(event->cookie, Move(move));
+				}
+				else if (event->mask & IN_MOVED_TO)
+				{
+					if (const FileChange* from = state->moves.Find(event->cookie))
+					{
+						state->AddChange(FileChangeType::Renamed, path, bFolder, from->path);
+						if (bFolder)
+						{
+							state->RenameFolder(from->path, path);
+						}
+						state->moves.Remove(event->cookie);
+					}
+					else
+					{
+						// Moved from a folder not watched
+						state->AddChange(FileChangeType::Added, path, bFolder);
+						if (bFolder)
+						{
+							state->AddFolder(path, true);
+						}
+					}
+				}
+				else if (!bFolder)
+				{
+					state->AddChange(FileChangeType::Modified, path, bFolder);
+				}
+				state->lastChange = Chrono::steady_clock::now();
+			}
+		}
+#endif
+	}
+
+	void FileWatcher::PostChanges()
+	{
+#if PLATFORM_LINUX
+		// Moves without destination left the watched folders
+		for (const auto& move : state->moves)
+		{
+			const FileChange& change = move.second;
+			state->AddChange(FileChangeType::Removed, change.path, change.bFolder);
+			if (change.bFolder)
+			{
+				state->RemoveFolder(change.path);
+			}
+		}
+		state->moves.Empty();
+#endif
+
+		TArray<FileChange> batch;
+		batch.Reserve(state->changes.Size());
+		for (FileChange& change : state->changes)
+		{
+			if (!change.path.empty())
+			{
+				batch.Add(Move(change));
+			}
+		}
+		state->changes.Empty();
+		state->changeIndices.Empty();
+		if (batch.IsEmpty())
+		{
+			return;
+		}
+
+		std::weak_ptr<u8> token = alive;
+		tasks.PostMain([this, token, batch = Move(batch)]() {
+			if (!token.expired())
+			{
+				onChanged.DoBroadcast(batch);
+			}
+		});
+	}
+}    // namespace Rift
@@ -0,0 +1,285 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Files/SaveQueue.h"
+
+#include "Log.h"
+#include "Math/Math.h"
+#include "Profiler.h"
+#include "Tasks.h"
+
+#include <atomic>
+
+#if PLATFORM_WINDOWS
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+
+namespace Rift
+{
+	static bool WriteTemp(const Path& temp, StringView data, bool bSync)
+	{
+#if PLATFORM_WINDOWS
+		const HANDLE file = CreateFileW(
+		    temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		bool bWritten = true;
+		for (sizet offset = 0; bWritten && offset < data.size();)
+		{
+			const DWORD size = DWORD(Math::Min<sizet>(data.size() - offset, 1u << 30));
+			DWORD written    = 0;
+			bWritten = ::WriteFile(file, data.data() + offset, size, &written, nullptr);
+			offset += written;
+		}
+		bWritten = bWritten && (!bSync || FlushFileBuffers(file));
+		CloseHandle(file);
+#else
+		const i32 fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0)
+		{
+			return false;
+		}
+		bool bWritten = true;
+		for (sizet offset = 0; bWritten && offset < data.size();)
+		{
+			const ssize_t written = write(fd, data.data() + offset, data.size() - offset);
+			bWritten              = written > 0;
+			offset += bWritten ? sizet(written) : 0;
+		}
+		bWritten = bWritten && (!bSync || fdatasync(fd) == 0);
+		close(fd);
+#endif
+		if (!bWritten)
+		{
+			FileSystem::Delete(temp, false, false);
+		}
+		return bWritten;
+	}
+
+	/** Replaces path with its temporary file. Readers see the old or the new file, never both */
+	static bool Replace(const Path& temp, const Path& path)
+	{
+#if PLATFORM_WINDOWS
+		const DWORD flags = MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH;
+		if (MoveFileExW(temp.c_str(), path.c_str(), flags))
+#else
+		if (rename(temp.c_str(), path.c_str()) == 0)
+#endif
+		{
+			return true;
+		}
+		FileSystem::Delete(temp, false, false);
+		return false;
+	}
+
+	/** Makes renames inside a folder reach the disk */
+	static void SyncFolder(const Path& folder)
+	{
+#if !PLATFORM_WINDOWS
+		const i32 fd = open(folder.empty() ? "." : folder.c_str(), O_RDONLY | O_DIRECTORY);
+		if (fd >= 0)
+		{
+			fsync(fd);
+			close(fd);
+		}
+#endif
+	}
+
+
+	SaveQueue::SaveQueue(const TaskSystem& tasks, const SaveQueueConfig& config)
+	    : tasks{tasks}, config{config}
+	{}
+
+	SaveQueue::~SaveQueue()
+	{
+		Flush();
+		// Scheduled tasks will find nothing to write, but still reference the queue
+		std::unique_lock<std::mutex> lock{mutex};
+		changed.wait(lock, [this]() {
+			return !bScheduled;
+		});
+	}
+
+	std::shared_future<bool> SaveQueue::Save(const Path& path, Json data, i32 indent)
+	{
+		return Queue(path, Move(data), indent);
+	}
+
+	std::shared_future<bool> SaveQueue::Save(const Path& path, String data)
+	{
+		return Queue(path, Move(data), -1);
+	}
+
+	void SaveQueue::Flush()
+	{
+		ZoneScopedNC("SaveQueue::Flush", 0xBB45D1);
+		std::unique_lock<std::mutex> lock{mutex};
+		while (true)
+		{
+			if (bDraining)
+			{
+				changed.wait(lock);
+			}
+			else if (!pending.IsEmpty())
+			{
+				Drain(lock);
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	i32 SaveQueue::GetNumPending()
+	{
+		std::unique_lock<std::mutex> lock{mutex};
+		return pending.Size();
+	}
+
+	bool SaveQueue::WriteFile(const Path& path, StringView data, bool bSync)
+	{
+		ZoneScopedNC("SaveQueue::WriteFile", 0xBB45D1);
+		const Path temp = GetTempPath(path);
+		if (!WriteTemp(temp, data, bSync) || !Replace(temp, path))
+		{
+			return false;
+		}
+		if (bSync)
+		{
+			SyncFolder(path.parent_path());
+		}
+		return true;
+	}
+
+	Path SaveQueue::GetTempPath(const Path& path)
+	{
+		static std::atomic<u64> nextTemp{0};
+#if PLATFORM_WINDOWS
+		const u32 processId = u32(GetCurrentProcessId());
+#else
+		const u32 processId = u32(getpid());
+#endif
+		Path temp = path;
+		temp += CString::Format(
+		    ".{}.{}.tmp", processId, nextTemp.fetch_add(1, std::memory_order_relaxed));
+		return temp;
+	}
+
+	std::shared_future<bool> SaveQueue::Queue(
+	    const Path& path, std::variant<String, Json> data, i32 indent)
+	{
+		String key = FileSystem::ToString(path);
+		std::unique_lock<std::mutex> lock{mutex};
+		if (const i32* index = pendingIndices.Find(key))
+		{
+			// Not written yet, so only the last data needs to be
+			Entry& entry = pending[*index];
+			entry.data   = Move(data);
+			entry.indent = indent;
+			return entry.result;
+		}
+
+		const i32 index = pending.AddDefaulted();
+		pendingIndices.Insert(Move(key), index);
+		Entry& entry = pending[index];
+		entry.path   = path;
+		entry.data   = Move(data);
+		entry.indent = indent;
+		entry.result = entry.promise.get_future().share();
+
+		// A batch being written picks up new saves once it finishes
+		if (!bScheduled && !bDraining)
+		{
+			bScheduled = true;
+			auto drain = [this]() {
+				std::unique_lock<std::mutex> lock{mutex};
+				bScheduled = false;
+				if (!bDraining)
+				{
+					Drain(lock);
+				}
+				changed.notify_all();
+			};
+			if (config.delay.count() > 0)
+			{
+				tasks.RunAfter(config.delay, Move(drain));
+			}
+			else
+			{
+				tasks.RunIO(Move(drain));
+			}
+		}
+		return entry.result;
+	}
+
+	void SaveQueue::Drain(std::unique_lock<std::mutex>& lock)
+	{
+		bDraining = true;
+		while (!pending.IsEmpty())
+		{
+			TArray<Entry> batch = Move(pending);
+			pending.Empty();
+			pendingIndices = {};
+
+			lock.unlock();
+			WriteBatch(batch);
+			lock.lock();
+		}
+		bDraining = false;
+		changed.notify_all();
+	}
+
+	void SaveQueue::WriteBatch(TArray<Entry>& batch)
+	{
+		ZoneScopedNC("SaveQueue::WriteBatch", 0xBB45D1);
+
+		TArray<u8> results(u32(batch.Size()), 0);
+		TArray<Path> temps;
+		temps.Resize(batch.Size());
+		tasks.Dispatch(batch.Size(), [this, &batch, &results, &temps](i32 index) {
+			const Entry& entry = batch[index];
+			temps[index]       = GetTempPath(entry.path);
+			const Path& temp   = temps[index];
+			if (const String* text = std::get_if<String>(&entry.data))
+			{
+				results[index] = WriteTemp(temp, *text, config.bSync);
+			}
+			else
+			{
+				const String dump = std::get<Json>(entry.data).dump(entry.indent);
+				results[index]    = WriteTemp(temp, dump, config.bSync);
+			}
+		});
+
+		// Old files are replaced once all files of the batch were written
+		TArray<Path> folders;
+		for (i32 i = 0; i < batch.Size(); ++i)
+		{
+			const Path& path = batch[i].path;
+			results[i]       = results[i] && Replace(temps[i], path);
+			if (results[i] && config.bSync)
+			{
+				folders.AddUnique(path.parent_path());
+			}
+		}
+		for (const Path& folder : folders)
+		{
+			SyncFolder(folder);
+		}
+
+		for (i32 i = 0; i < batch.Size(); ++i)
+		{
+			if (!results[i])
+			{
+				Log::Error("Failed to save '{}'", FileSystem::ToString(batch[i].path));
+			}
+			batch[i].promise.set_value(results[i] != 0);
+		}
+	}
+}    // namespace Rift
@@ -0,0 +1,437 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Files/VirtualFileSystem.h"
+
+#include "Files/FileWatcher.h"
+#include "Files/SaveQueue.h"
+#include "Log.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+namespace Rift
+{
+	// "RFPK" when read as bytes
+	static constexpr u32 packMagic   = 0x4B504652;
+	static constexpr u32 packVersion = 1;
+
+
+	template <typename T>
+	static bool ReadValue(std::span<const u8> bytes, sizet& offset, T& value)
+	{
+		if (bytes.size() - offset < sizeof(T))
+		{
+			return false;
+		}
+		std::memcpy(&value, bytes.data() + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	template <typename T>
+	static void WriteValue(String& data, const T& value)
+	{
+		data.append(reinterpret_cast<const TCHAR*>(&value), sizeof(T) / sizeof(TCHAR));
+	}
+
+
+	FileType FolderMount::GetType(StringView path) const
+	{
+		std::error_code error;
+		const fs::file_status status = fs::status(root / path, error);
+		if (fs::is_regular_file(status))
+		{
+			return FileType::File;
+		}
+		return fs::is_directory(status) ? FileType::Folder : FileType::None;
+	}
+
+	FileView FolderMount::Open(StringView path, FileAccess access) const
+	{
+		return FileView{root / path, access};
+	}
+
+	bool FolderMount::ToRelative(const Path& realPath, String& relative) const
+	{
+		const Path path = realPath.lexically_relative(root);
+		if (path.empty() || *path.begin() == "..")
+		{
+			return false;
+		}
+		relative = path == "." ? String{} : FileSystem::ToString(path.generic_string());
+		return true;
+	}
+
+
+	PackMount::PackMount(const Path& path)
+	{
+		ZoneScopedNC("PackMount", 0xBB45D1);
+		auto view = std::make_shared<FileView>(path, FileAccess::Random);
+		if (!view->IsOpen())
+		{
+			Log::Error("Couldn't open pack '{}'", FileSystem::ToString(path));
+			return;
+		}
+
+		const std::span<const u8> bytes = view->GetBytes();
+		sizet offset                    = 0;
+		u32 magic = 0, version = 0, count = 0;
+		bool bValid = ReadValue(bytes, offset, magic) && ReadValue(bytes, offset, version)
+		           && ReadValue(bytes, offset, count) && magic == packMagic
+		           && version == packVersion;
+		for (u32 i = 0; bValid && i < count; ++i)
+		{
+			u32 pathSize = 0;
+			Entry entry{0, 0, FileType::File};
+			bValid = ReadValue(bytes, offset, pathSize) && ReadValue(bytes, offset, entry.offset)
+			      && ReadValue(bytes, offset, entry.size) && bytes.size() - offset >= pathSize
+			      && entry.size <= bytes.size() && entry.offset <= bytes.size() - entry.size;
+			if (!bValid)
+			{
+				break;
+			}
+
+			const StringView filePath{
+			    reinterpret_cast<const TCHAR*>(bytes.data() + offset), pathSize / sizeof(TCHAR)};
+			offset += pathSize;
+			entries.Insert(Name{filePath}, entry);
+
+			// Register folders up to the first one already known
+			sizet end = filePath.rfind('/');
+			while (end != StringView::npos && end > 0)
+			{
+				const Name folder{filePath.substr(0, end)};
+				if (entries.Contains(folder))
+				{
+					break;
+				}
+				entries.Insert(folder, Entry{0, 0, FileType::Folder});
+				end = filePath.rfind('/', end - 1);
+			}
+		}
+
+		if (!bValid)
+		{
+			Log::Error("Pack '{}' is not valid", FileSystem::ToString(path));
+			entries.Empty();
+			return;
+		}
+		pack = Move(view);
+	}
+
+	FileType PackMount::GetType(StringView path) const
+	{
+		if (!pack)
+		{
+			return FileType::None;
+		}
+		if (path.empty())
+		{
+			return FileType::Folder;
+		}
+		const Entry* entry = entries.Find(Name{path});
+		return entry ? entry->type : FileType::None;
+	}
+
+	FileView PackMount::Open(StringView path, FileAccess /*access*/) const
+	{
+		const Entry* entry = pack ? entries.Find(Name{path}) : nullptr;
+		if (!entry || entry->type != FileType::File)
+		{
+			return {};
+		}
+		return FileView::Slice(pack, sizet(entry->offset), sizet(entry->size));
+	}
+
+	bool PackMount::Write(const Path& path, const Path& folder)
+	{
+		ZoneScopedNC("PackMount::Write", 0xBB45D1);
+		TArray<Path> files;
+		std::error_code error;
+		for (fs::recursive_directory_iterator it{folder, error}, end; it != end;
+		     it.increment(error))
+		{
+			if (it->is_regular_file(error))
+			{
+				files.Add(it->path());
+			}
+		}
+		if (error)
+		{
+			return false;
+		}
+		std::sort(files.begin(), files.end());
+
+		TArray<String> names;
+		TArray<u64> sizes;
+		sizet headerSize = sizeof(u32) * 3;
+		for (const Path& file : files)
+		{
+			names.Add(FileSystem::ToString(file.lexically_relative(folder).generic_string()));
+			sizes.Add(u64(fs::file_size(file, error)));
+			if (error)
+			{
+				return false;
+			}
+			headerSize += sizeof(u32) + sizeof(u64) * 2 + names.Last().size() * sizeof(TCHAR);
+		}
+
+		// Only the table is kept in memory. Files are copied into the pack one at a time
+		u64 offset = headerSize;
+		String header;
+		header.reserve(headerSize);
+		WriteValue(header, packMagic);
+		WriteValue(header, packVersion);
+		WriteValue(header, u32(files.Size()));
+		for (i32 i = 0; i < files.Size(); ++i)
+		{
+			WriteValue(header, u32(names[i].size() * sizeof(TCHAR)));
+			WriteValue(header, offset);
+			WriteValue(header, sizes[i]);
+			header.append(names[i]);
+			offset += sizes[i];
+		}
+
+		const Path temp   = SaveQueue::GetTempPath(path);
+		std::FILE* output = std::fopen(FileSystem::ToString(temp).c_str(), "wb");
+		if (!output)
+		{
+			return false;
+		}
+		bool bWritten = std::fwrite(header.data(), 1, header.size(), output) == header.size();
+		for (i32 i = 0; bWritten && i < files.Size(); ++i)
+		{
+			// Files that changed size since the table was written would corrupt the pack
+			const FileView view{files[i]};
+			const std::span<const u8> bytes = view.GetBytes();
+			bWritten = view.IsOpen() && bytes.size() == sizes[i]
+			        && std::fwrite(bytes.data(), 1, bytes.size(), output) == bytes.size();
+		}
+		bWritten = std::fclose(output) == 0 && bWritten;
+		if (bWritten)
+		{
+			fs::rename(temp, path, error);
+		}
+		if (!bWritten || error)
+		{
+			FileSystem::Delete(temp, false, false);
+			return false;
+		}
+		return true;
+	}
+
+
+	VFSMount* VirtualFileSystem::Mount(const Name& point, std::unique_ptr<VFSMount> mount)
+	{
+		std::unique_lock<std::shared_mutex> lock{mutex};
+		VFSMount* const added = mount.get();
+		mounts.Add({point, Move(mount)});
+		cache.Empty();
+		++generation;
+		return added;
+	}
+
+	bool VirtualFileSystem::Unmount(const VFSMount* mount)
+	{
+		std::unique_lock<std::shared_mutex> lock{mutex};
+		for (i32 i = 0; i < mounts.Size(); ++i)
+		{
+			if (mounts[i].mount.get() == mount)
+			{
+				mounts.RemoveAt(i);
+				cache.Empty();
+				++generation;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	FileType VirtualFileSystem::GetType(const Name& path) const
+	{
+		std::shared_lock<std::shared_mutex> lock{mutex};
+		return Resolve(path, lock).type;
+	}
+
+	FileView VirtualFileSystem::Read(const Name& path, FileAccess access) const
+	{
+		std::shared_lock<std::shared_mutex> lock{mutex};
+		const Resolution resolution = Resolve(path, lock);
+		if (resolution.type != FileType::File)
+		{
+			return {};
+		}
+		const MountPoint& mountPoint = mounts[resolution.mount];
+		StringView relative;
+		GetRelative(path.ToString(), mountPoint.point, relative);
+		return mountPoint.mount->Open(relative, access);
+	}
+
+	void VirtualFileSystem::Invalidate(const Name& path, bool bRecursive)
+	{
+		std::unique_lock<std::shared_mutex> lock{mutex};
+		++generation;
+		cache.Remove(path);
+		if (bRecursive)
+		{
+			TArray<Name> removed;
+			for (const auto& resolved : cache)
+			{
+				StringView relative;
+				if (GetRelative(resolved.first.ToString(), path, relative))
+				{
+					removed.Add(resolved.first);
+				}
+			}
+			for (const Name& key : removed)
+			{
+				cache.Remove(key);
+			}
+		}
+	}
+
+	void VirtualFileSystem::InvalidateAll()
+	{
+		std::unique_lock<std::shared_mutex> lock{mutex};
+		++generation;
+		cache.Empty();
+	}
+
+	void VirtualFileSystem::OnFilesChanged(const TArray<FileChange>& changes)
+	{
+		TArray<Name> files;
+		TArray<Name> folders;
+		{
+			std::shared_lock<std::shared_mutex> lock{mutex};
+			String relative;
+			for (const FileChange& change : changes)
+			{
+				for (const MountPoint& mountPoint : mounts)
+				{
+					for (const Path* path : {&change.path, &change.oldPath})
+					{
+						if (path->empty() || !mountPoint.mount->ToRelative(*path, relative))
+						{
+							continue;
+						}
+						const Name key = mountPoint.point.IsNone()
+						                   ? ToKey(relative)
+						                   : ToKey(mountPoint.point.ToString() + "/" + relative);
+						(change.bFolder ? folders : files).Add(key);
+					}
+				}
+			}
+		}
+		for (const Name& file : files)
+		{
+			Invalidate(file);
+		}
+		for (const Name& folder : folders)
+		{
+			Invalidate(folder, true);
+		}
+	}
+
+	Name VirtualFileSystem::ToKey(StringView path)
+	{
+		String key;
+		key.reserve(path.size());
+		for (sizet start = 0; start <= path.size();)
+		{
+			sizet end = path.find_first_of("/\\", start);
+			if (end == StringView::npos)
+			{
+				end = path.size();
+			}
+
+			const StringView segment = path.substr(start, end - start);
+			if (segment == "..")
+			{
+				const sizet last = key.rfind('/');
+				key.resize(last == String::npos ? 0 : last);
+			}
+			else if (!segment.empty() && segment != ".")
+			{
+				if (!key.empty())
+				{
+					key.push_back('/');
+				}
+				key.append(segment);
+			}
+			start = end + 1;
+		}
+		return Name{key};
+	}
+
+	VirtualFileSystem::Resolution VirtualFileSystem::Resolve(
+	    const Name& path, std::shared_lock<std::shared_mutex>& lock) const
+	{
+		while (true)
+		{
+			if (const Resolution* cached = cache.Find(path))
+			{
+				return *cached;
+			}
+
+			Resolution resolution;
+			const StringView pathStr = path.ToString();
+			for (i32 i = mounts.Size() - 1; i >= 0; --i)
+			{
+				StringView relative;
+				if (GetRelative(pathStr, mounts[i].point, relative))
+				{
+					const FileType type = mounts[i].mount->GetType(relative);
+					if (type != FileType::None)
+					{
+						resolution = {i, type};
+						break;
+					}
+				}
+			}
+
+			// Caching needs exclusive access. Discarded if mounts or files changed meanwhile
+			const u64 resolvedGeneration = generation;
+			lock.unlock();
+			{
+				std::unique_lock<std::shared_mutex> cacheLock{mutex};
+				if (generation == resolvedGeneration)
+				{
+					cache.Insert(path, resolution);
+				}
+			}
+			lock.lock();
+			if (generation == resolvedGeneration)
+			{
+				return resolution;
+			}
+		}
+	}
+
+	bool VirtualFileSystem::GetRelative(StringView path, const Name& point, StringView& relative)
+	{
+		if (point.IsNone())
+		{
+			relative = path;
+			return true;
+		}
+		const StringView pointStr = point.ToString();
+		if (!path.starts_with(pointStr))
+		{
+			return false;
+		}
+		if (path.size() == pointStr.size())
+		{
+			relative = {};
+			return true;
+		}
+		if (path[pointStr.size()] != '/')
+		{
+			return false;
+		}
+		relative = path.substr(pointStr.size() + 1);
+		return true;
+	}
+}    // namespace Rift
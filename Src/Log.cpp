@@ -3,8 +3,12 @@
 #include "Log.h"
 
 #include "Files/FileSystem.h"
+#include "Log/BinaryLog.h"
+#include "Math/Math.h"
 
+#include <fmt/args.h>
 #include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
 #include <spdlog/sinks/base_sink.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -12,9 +16,18 @@
 
 #include <Tracy.hpp>
 
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <thread>
+
 
 namespace Rift::Log
 {
+	// Constant initialized, so it can be used by other static initializers
+	Category general{TX("Log"), Level::Info};
+
+
 #if TRACY_ENABLE
 	template <typename Mutex>
 	class ProfilerSink : public spdlog::sinks::base_sink<Mutex>
@@ -48,14 +61,432 @@ namespace Rift::Log
 #endif
 
 
-	void Init(Path logFile)
+
+	/**
+	 * Records logged by one thread, read by the backend. Records are contiguous, so the space
+	 * left at the end of the buffer is skipped with a padding marker when one doesn't fit.
+	 */
+	struct ThreadBuffer
+	{
+		static constexpr u32 paddingFlag = 1u << 31;
+
+		TArray<u8> data;
+		u64 mask         = 0;
+		sizet threadId   = 0;
+		u32 sampleCount  = 0;
+		u64 cachedTail   = 0;
+		std::atomic<u64> dropped{0};
+		std::atomic<bool> bClosed{false};
+		// The owner thread is between BeginRecord and EndRecord. StopAsync waits for it
+		std::atomic<bool> bWriting{false};
+
+		// Written by the owner thread
+		alignas(64) std::atomic<u64> head{0};
+		// Written by the backend
+		alignas(64) std::atomic<u64> tail{0};
+
+
+		ThreadBuffer(u32 capacity) : mask{capacity - 1}, threadId{spdlog::details::os::thread_id()}
+		{
+			data.Resize(capacity);
+		}
+
+		u64 GetCapacity() const
+		{
+			return mask + 1;
+		}
+
+		u64 GetUsedSize() const
+		{
+			return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+		}
+
+		Record* Reserve(u32 size)
+		{
+			const u64 writeHead = head.load(std::memory_order_relaxed);
+			const u64 offset    = writeHead & mask;
+			const u64 padding   = offset + size > GetCapacity() ? GetCapacity() - offset : 0;
+			if (writeHead + padding + size - cachedTail > GetCapacity())
+			{
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (writeHead + padding + size - cachedTail > GetCapacity())
+				{
+					return nullptr;
+				}
+			}
+
+			if (padding > 0)
+			{
+				const u32 marker = u32(padding) | paddingFlag;
+				std::memcpy(data.Data() + offset, &marker, sizeof(u32));
+				head.store(writeHead + padding, std::memory_order_release);
+			}
+			return reinterpret_cast<Record*>(data.Data() + ((writeHead + padding) & mask));
+		}
+
+		void Commit(u32 size)
+		{
+			head.store(head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+		}
+	};
+
+	/** Keeps the buffer of a thread alive until the backend has written all of it */
+	struct ThreadBufferRef
+	{
+		std::shared_ptr<ThreadBuffer> buffer;
+
+		~ThreadBufferRef()
+		{
+			if (buffer)
+			{
+				buffer->bClosed = true;
+			}
+		}
+	};
+
+	struct AsyncLog
+	{
+		Settings settings;
+		std::atomic<bool> bEnabled{false};
+		std::atomic<bool> bRunning{false};
+		std::thread backend;
+
+		std::mutex buffersMutex;
+		TArray<std::shared_ptr<ThreadBuffer>> buffers;
+
+		std::mutex wakeMutex;
+		std::condition_variable wake;
+		std::condition_variable flushed;
+		std::atomic<u64> flushRequested{0};
+		u64 flushCompleted = 0;
+
+
+		~AsyncLog();
+	};
+
+	struct PendingRecord
+	{
+		const Record* record;
+		const ThreadBuffer* buffer;
+	};
+
+	// Declared before asyncLog, so it outlives the backend
+	static BinaryLogWriter binaryLog;
+	static AsyncLog asyncLog;
+	static thread_local ThreadBufferRef threadBuffer;
+
+
+	static i64 GetTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		    std::chrono::system_clock::now().time_since_epoch())
+		    .count();
+	}
+
+	static ThreadBuffer& GetThreadBuffer()
+	{
+		if (!threadBuffer.buffer) [[unlikely]]
+		{
+			auto buffer = std::make_shared<ThreadBuffer>(asyncLog.settings.threadBufferSize);
+			std::scoped_lock lock{asyncLog.buffersMutex};
+			asyncLog.buffers.Add(buffer);
+			threadBuffer.buffer = Move(buffer);
+		}
+		return *threadBuffer.buffer;
+	}
+
+	static spdlog::logger* GetLogger(Level level, spdlog::level::level_enum& spdLevel)
+	{
+		switch (level)
+		{
+			case Level::Verbose: spdLevel = spdlog::level::trace; return generalLogger.get();
+			case Level::Info: spdLevel = spdlog::level::info; return generalLogger.get();
+			case Level::Warning: spdLevel = spdlog::level::warn; return errLogger.get();
+			case Level::Error: spdLevel = spdlog::level::err; return errLogger.get();
+			default: return nullptr;
+		}
+	}
+
+	/** @return true if there are text sinks for this level, so it needs formatting */
+	static bool HasSinks(Level level)
+	{
+		spdlog::level::level_enum spdLevel;
+		const spdlog::logger* logger = GetLogger(level, spdLevel);
+		return logger && !logger->sinks().empty();
+	}
+
+	static void WriteToSinks(
+	    Level level, const Category& category, StringView msg, i64 time, sizet threadId)
+	{
+		spdlog::level::level_enum spdLevel;
+		spdlog::logger* const logger = GetLogger(level, spdLevel);
+		if (!logger)
+		{
+			return;
+		}
+
+		ScratchBuffer prefixed;
+		if (&category != &general)
+		{
+			CString::FormatTo(prefixed.Get(), "[{}] {}", category.name, msg);
+			msg = prefixed.ToView();
+		}
+
+		spdlog::details::log_msg logMsg{
+		    spdlog::log_clock::time_point{std::chrono::duration_cast<spdlog::log_clock::duration>(
+		        std::chrono::nanoseconds{time})},
+		    spdlog::source_loc{}, logger->name(), spdLevel, msg};
+		logMsg.thread_id = threadId;
+		for (const auto& sink : logger->sinks())
+		{
+			if (sink->should_log(spdLevel))
+			{
+				sink->log(logMsg);
+			}
+		}
+	}
+
+	/** Writes a formatted message to the binary log and the sinks */
+	static void WriteText(
+	    Level level, const Category& category, StringView msg, i64 time, sizet threadId)
+	{
+		if (binaryLog.IsOpen())
+		{
+			binaryLog.Write(level, category, msg, time, threadId);
+		}
+		WriteToSinks(level, category, msg, time, threadId);
+	}
+
+	static void FlushSinks()
+	{
+		binaryLog.Flush();
+		if (generalLogger)
+		{
+			generalLogger->flush();
+		}
+		if (errLogger)
+		{
+			errLogger->flush();
+		}
+	}
+
+	static void WriteRecord(const Record& record, const ThreadBuffer& buffer,
+	    StringBuffer& message, fmt::dynamic_format_arg_store<fmt::format_context>& args)
+	{
+		if (binaryLog.IsOpen())
+		{
+			binaryLog.Write(record, buffer.threadId);
+		}
+		if (!HasSinks(record.level))
+		{
+			return;
+		}
+
+		const u8* in = reinterpret_cast<const u8*>(&record + 1);
+		StringView text;
+		if (record.bFormatted)
+		{
+			LogArgs::Decode(in, [&text](auto value) {
+				if constexpr (std::is_same_v<decltype(value), StringView>)
+				{
+					text = value;
+				}
+			});
+		}
+		else
+		{
+			args.clear();
+			for (u8 i = 0; i < record.numArgs; ++i)
+			{
+				in = LogArgs::Decode(in, [&args](auto value) {
+					args.push_back(value);
+				});
+			}
+			message.clear();
+			try
+			{
+				fmt::vformat_to(std::back_inserter(message),
+				    fmt::string_view{record.format, record.formatSize}, args);
+				text = {message.data(), message.size()};
+			}
+			catch (const fmt::format_error&)
+			{
+				// A bad format must not stop the backend thread. The format is written instead
+				text = {record.format, record.formatSize};
+			}
+		}
+		WriteToSinks(record.level, *record.category, text, record.time, buffer.threadId);
+	}
+
+	/**
+	 * Writes all the records in the buffers, ordered by time.
+	 * @return number of records written
+	 */
+	static i32 DrainBuffers(TArray<std::shared_ptr<ThreadBuffer>>& buffers,
+	    TArray<PendingRecord>& pending, TArray<u64>& heads, StringBuffer& message,
+	    fmt::dynamic_format_arg_store<fmt::format_context>& args)
+	{
+		{
+			std::scoped_lock lock{asyncLog.buffersMutex};
+			// Buffers of finished threads are removed once they have been written
+			asyncLog.buffers.RemoveIf([](const auto& buffer) {
+				return buffer->bClosed && buffer->GetUsedSize() == 0;
+			});
+			buffers = asyncLog.buffers;
+		}
+
+		pending.Empty(false);
+		heads.Resize(buffers.Size());
+		for (i32 i = 0; i < buffers.Size(); ++i)
+		{
+			ThreadBuffer& buffer = *buffers[i];
+			u64 readTail         = buffer.tail.load(std::memory_order_relaxed);
+			heads[i]             = buffer.head.load(std::memory_order_acquire);
+			while (readTail < heads[i])
+			{
+				const u8* data = buffer.data.Data() + (readTail & buffer.mask);
+				u32 size;
+				std::memcpy(&size, data, sizeof(u32));
+				if (!(size & ThreadBuffer::paddingFlag))
+				{
+					pending.Add({reinterpret_cast<const Record*>(data), &buffer});
+				}
+				readTail += size & ~ThreadBuffer::paddingFlag;
+			}
+
+			if (const u64 dropped = buffer.dropped.exchange(0, std::memory_order_relaxed))
+			{
+				CString::FormatTo(message, "{} log messages were dropped", dropped);
+				WriteText(Level::Warning, general, {message.data(), message.size()}, GetTime(),
+				    buffer.threadId);
+				message.clear();
+			}
+		}
+
+		// Each buffer is already sorted. Stable keeps the order of equal times
+		std::stable_sort(pending.begin(), pending.end(), [](const auto& a, const auto& b) {
+			return a.record->time < b.record->time;
+		});
+		for (const PendingRecord& item : pending)
+		{
+			WriteRecord(*item.record, *item.buffer, message, args);
+		}
+
+		for (i32 i = 0; i < buffers.Size(); ++i)
+		{
+			buffers[i]->tail.store(heads[i], std::memory_order_release);
+		}
+		return pending.Size();
+	}
+
+	static void RunBackend()
 	{
+		TArray<std::shared_ptr<ThreadBuffer>> buffers;
+		TArray<PendingRecord> pending;
+		TArray<u64> heads;
+		StringBuffer message;
+		fmt::dynamic_format_arg_store<fmt::format_context> args;
+		bool bUnflushed = false;
+		while (true)
+		{
+			// Read before draining, so everything logged before is written
+			const bool bStop      = !asyncLog.bRunning.load(std::memory_order_acquire);
+			const u64 flushTarget = asyncLog.flushRequested.load(std::memory_order_acquire);
+			if (DrainBuffers(buffers, pending, heads, message, args) > 0)
+			{
+				bUnflushed = true;
+				continue;
+			}
+
+			// Nothing left to write
+			if (bUnflushed)
+			{
+				FlushSinks();
+				bUnflushed = false;
+			}
+
+			std::unique_lock lock{asyncLog.wakeMutex};
+			if (flushTarget > asyncLog.flushCompleted)
+			{
+				asyncLog.flushCompleted = flushTarget;
+				asyncLog.flushed.notify_all();
+			}
+			if (bStop)
+			{
+				break;
+			}
+			asyncLog.wake.wait_for(lock, std::chrono::milliseconds(1), [flushTarget]() {
+				return !asyncLog.bRunning || asyncLog.flushRequested != flushTarget;
+			});
+		}
+	}
+
+	static void StartAsync(const Settings& settings)
+	{
+		asyncLog.settings = settings;
+		asyncLog.settings.threadBufferSize =
+		    std::bit_ceil(Math::Max(settings.threadBufferSize, 4096u));
+		asyncLog.settings.sampleRate = Math::Max(settings.sampleRate, 1u);
+		asyncLog.bRunning            = true;
+		asyncLog.backend             = std::thread{&RunBackend};
+		// Publishes the settings to the threads that see it enabled
+		asyncLog.bEnabled.store(true, std::memory_order_release);
+	}
+
+	static void StopAsync()
+	{
+		if (!asyncLog.backend.joinable())
+		{
+			return;
+		}
+
+		// New messages are written inline. Records already started are committed before the
+		// backend stops, so that its last drain writes them
+		asyncLog.bEnabled.store(false, std::memory_order_seq_cst);
+		TArray<std::shared_ptr<ThreadBuffer>> buffers;
+		{
+			std::scoped_lock lock{asyncLog.buffersMutex};
+			buffers = asyncLog.buffers;
+		}
+		for (const auto& buffer : buffers)
+		{
+			while (buffer->bWriting.load(std::memory_order_seq_cst))
+			{
+				std::this_thread::yield();
+			}
+		}
+		{
+			std::scoped_lock lock{asyncLog.wakeMutex};
+			asyncLog.bRunning = false;
+		}
+		asyncLog.wake.notify_all();
+		asyncLog.backend.join();
+		asyncLog.flushed.notify_all();
+	}
+
+	AsyncLog::~AsyncLog()
+	{
+		StopAsync();
+	}
+
+
+	void Init(Path logPath)
+	{
+		Init(Settings{.logPath = Move(logPath)});
+	}
+
+	void Init(const Settings& settings)
+	{
+		StopAsync();
+		binaryLog.Close();
+
 		std::vector<spdlog::sink_ptr> sinks;
 		sinks.reserve(3);
 
 		// File
-		if (!logFile.empty())
+		if (!settings.logPath.empty())
 		{
+			Path logFile   = settings.logPath;
 			Path logFolder = logFile;
 			if (FileSystem::IsFile(logFile))
 			{
@@ -63,12 +494,20 @@ namespace Rift::Log
 			}
 			else
 			{
-				logFile /= "log.txt";
+				logFile /= settings.fileFormat == FileFormat::Binary ? "log.rlog" : "log.txt";
 			}
 			FileSystem::CreateFolder(logFolder, true);
 
-			sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
-				FileSystem::ToString(logFile).c_str(), 1048576 * 5, 3));
+			if (settings.fileFormat == FileFormat::Binary)
+			{
+				binaryLog.Open(logFile, settings.maxFileSize, settings.maxFiles);
+			}
+			else
+			{
+				sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+					FileSystem::ToString(logFile).c_str(), settings.maxFileSize,
+					settings.maxFiles));
+			}
 		}
 
 #if TRACY_ENABLE
@@ -76,43 +515,145 @@ namespace Rift::Log
 		sinks.push_back(std::make_shared<ProfilerSink_mt>());
 #endif
 
-		// Console
 		generalLogger = std::make_shared<spdlog::logger>("Log", sinks.begin(), sinks.end());
 		errLogger = std::make_shared<spdlog::logger>("Log", sinks.begin(), sinks.end());
 		generalLogger->set_pattern("%^[%D %T][%l]%$ %v");
 		errLogger->set_pattern("%^[%D %T][%t][%l]%$ %v");
+		// Levels are filtered before formatting by Log::Category
+		generalLogger->set_level(spdlog::level::trace);
+		errLogger->set_level(spdlog::level::trace);
 
-		auto cliSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-		generalLogger->sinks().push_back(cliSink);
-		cliSink->set_pattern("%^%v%$");
+		// Console
+		if (settings.bConsole)
+		{
+			auto cliSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+			generalLogger->sinks().push_back(cliSink);
+			cliSink->set_pattern("%^%v%$");
 
-		auto cliErrSink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
-		errLogger->sinks().push_back(cliErrSink);
-		cliErrSink->set_pattern("%^[%l] %v%$");
+			auto cliErrSink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
+			errLogger->sinks().push_back(cliErrSink);
+			cliErrSink->set_pattern("%^[%l] %v%$");
 
 #if PLATFORM_WINDOWS
-		cliSink->set_color(spdlog::level::info, cliSink->WHITE);
-		cliErrSink->set_color(spdlog::level::warn, cliSink->YELLOW);
+			cliSink->set_color(spdlog::level::info, cliSink->WHITE);
+			cliErrSink->set_color(spdlog::level::warn, cliSink->YELLOW);
 #else
-		cliSink->set_color(spdlog::level::info, cliSink->white);
-		cliErrSink->set_color(spdlog::level::warn, cliSink->yellow);
+			cliSink->set_color(spdlog::level::info, cliSink->white);
+			cliErrSink->set_color(spdlog::level::warn, cliSink->yellow);
 #endif
+		}
+
+		if (settings.bAsync)
+		{
+			StartAsync(settings);
+		}
+	}
+
+	void Shutdown()
+	{
+		StopAsync();
+		FlushSinks();
+	}
+
+	void Flush()
+	{
+		if (!IsAsync())
+		{
+			FlushSinks();
+			return;
+		}
+
+		std::unique_lock lock{asyncLog.wakeMutex};
+		const u64 target = ++asyncLog.flushRequested;
+		asyncLog.wake.notify_one();
+		asyncLog.flushed.wait(lock, [target]() {
+			return asyncLog.flushCompleted >= target || !asyncLog.bRunning;
+		});
 	}
 
-	void Shutdown() {}
+	bool IsAsync()
+	{
+		return asyncLog.bEnabled.load(std::memory_order_acquire);
+	}
 
-	void Info(const String& msg)
+	Record* BeginRecord(u32 size)
 	{
-		generalLogger->info(msg);
+		if (!IsAsync())
+		{
+			return nullptr;
+		}
+		ThreadBuffer& buffer = GetThreadBuffer();
+		// Marked before checking again. Either StopAsync waits for this record, or it is seen
+		// stopped here and the caller writes the message inline
+		buffer.bWriting.store(true, std::memory_order_seq_cst);
+		if (!asyncLog.bEnabled.load(std::memory_order_seq_cst))
+		{
+			buffer.bWriting.store(false, std::memory_order_release);
+			return nullptr;
+		}
+
+		const Settings& settings = asyncLog.settings;
+		Record* record           = nullptr;
+		// Bigger records may never fit
+		if (size <= buffer.GetCapacity() / 2)
+		{
+			const bool bSkip = settings.overflow == OverflowPolicy::Sample
+			                && buffer.GetUsedSize() > buffer.GetCapacity() / 2
+			                && ++buffer.sampleCount % settings.sampleRate != 0;
+			if (!bSkip)
+			{
+				record = buffer.Reserve(size);
+				while (!record && settings.overflow == OverflowPolicy::Block
+				       && asyncLog.bRunning.load(std::memory_order_relaxed))
+				{
+					std::this_thread::yield();
+					record = buffer.Reserve(size);
+				}
+			}
+		}
+
+		if (!record)
+		{
+			buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+			buffer.bWriting.store(false, std::memory_order_release);
+			return nullptr;
+		}
+		record->size = size;
+		record->time = GetTime();
+		return record;
 	}
 
-	void Warning(const String& msg)
+	void EndRecord(Record* record)
 	{
-		errLogger->warn(msg);
+		ThreadBuffer& buffer = *threadBuffer.buffer;
+		buffer.Commit(record->size);
+		buffer.bWriting.store(false, std::memory_order_release);
 	}
 
-	void Error(const String& msg)
+	void Write(Level level, const Category& category, StringView msg)
 	{
-		errLogger->error(msg);
+		if (!IsAsync())
+		{
+			WriteText(level, category, msg, GetTime(), spdlog::details::os::thread_id());
+			return;
+		}
+
+		const u32 size = u32(sizeof(Record) + LogArgs::GetSize(msg) + 7) & ~u32(7);
+		if (Record* const record = BeginRecord(size))
+		{
+			record->level      = level;
+			record->numArgs    = 1;
+			record->bFormatted = true;
+			record->formatSize = 0;
+			record->format     = nullptr;
+			record->category   = &category;
+			LogArgs::Encode(reinterpret_cast<u8*>(record + 1), msg);
+			EndRecord(record);
+		}
+		else if (!IsAsync())
+		{
+			// Async logging stopped after the check above
+			WriteText(level, category, msg, GetTime(), spdlog::details::os::thread_id());
+		}
 	}
 }	 // namespace Rift::Log
@@ -0,0 +1,526 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Log/BinaryLog.h"
+
+#include <fmt/args.h>
+
+#include <fstream>
+
+
+namespace Rift::Log
+{
+	static constexpr StringView textFormat = TX("{}");
+
+
+	static void WriteVarInt(TArray<u8>& out, u64 value)
+	{
+		while (value >= 0x80)
+		{
+			out.Add(u8(value) | 0x80);
+			value >>= 7;
+		}
+		out.Add(u8(value));
+	}
+
+	static bool ReadVarInt(const TArray<u8>& data, sizet& position, u64& value)
+	{
+		value = 0;
+		for (u32 shift = 0; shift < 64 && position < sizet(data.Size()); shift += 7)
+		{
+			const u8 byte = data[i32(position++)];
+			value |= u64(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template <typename T>
+	static void AppendArg(TArray<u8>& out, const T& value)
+	{
+		const i32 offset = out.Size();
+		out.Resize(offset + i32(LogArgs::GetSize(value)));
+		LogArgs::Encode(out.Data() + offset, value);
+	}
+
+	template <typename T>
+	static bool ReadBytes(const TArray<u8>& data, sizet& position, T& value)
+	{
+		if (sizeof(T) > data.Size() - position)
+		{
+			return false;
+		}
+		std::memcpy(&value, data.Data() + position, sizeof(T));
+		position += sizeof(T);
+		return true;
+	}
+
+	static u64 ZigZag(i64 value)
+	{
+		return (u64(value) << 1) ^ u64(value >> 63);
+	}
+
+	static i64 UnZigZag(u64 value)
+	{
+		return i64(value >> 1) ^ -i64(value & 1);
+	}
+
+	static void WriteBytes(TArray<u8>& out, const void* data, sizet size)
+	{
+		const i32 offset = out.Size();
+		out.Resize(offset + i32(size));
+		std::memcpy(out.Data() + offset, data, size);
+	}
+
+	static void WriteString(TArray<u8>& out, StringView str)
+	{
+		WriteVarInt(out, str.size());
+		WriteBytes(out, str.data(), str.size() * sizeof(TCHAR));
+	}
+
+	/** Writes arguments encoded by LogArgs with variable length integers */
+	static void WriteArgs(TArray<u8>& out, const u8* args, u8 numArgs)
+	{
+		for (u8 i = 0; i < numArgs; ++i)
+		{
+			out.Add(*args);
+			args = LogArgs::Decode(args, [&out](auto value) {
+				using Type = decltype(value);
+				if constexpr (std::is_same_v<Type, i64>)
+				{
+					WriteVarInt(out, ZigZag(value));
+				}
+				else if constexpr (std::is_same_v<Type, u64>)
+				{
+					WriteVarInt(out, value);
+				}
+				else if constexpr (std::is_same_v<Type, const void*>)
+				{
+					WriteVarInt(out, u64(reinterpret_cast<uintptr_t>(value)));
+				}
+				else if constexpr (std::is_same_v<Type, StringView>)
+				{
+					WriteString(out, value);
+				}
+				else
+				{
+					WriteBytes(out, &value, sizeof(value));
+				}
+			});
+		}
+	}
+
+	/** Reads arguments written by WriteArgs, encoding them back as LogArgs does */
+	static bool ReadArgs(const TArray<u8>& data, sizet& position, u8 numArgs, TArray<u8>& out)
+	{
+		out.Empty(false);
+		for (u8 i = 0; i < numArgs; ++i)
+		{
+			if (position >= sizet(data.Size()))
+			{
+				return false;
+			}
+			const ArgType type = ArgType(data[i32(position++)]);
+			bool bValid        = true;
+			switch (type)
+			{
+				case ArgType::Bool:
+				{
+					bool value;
+					bValid = ReadBytes(data, position, value);
+					AppendArg(out, value);
+					break;
+				}
+				case ArgType::Char:
+				{
+					TCHAR value;
+					bValid = ReadBytes(data, position, value);
+					AppendArg(out, value);
+					break;
+				}
+				case ArgType::Int:
+				{
+					u64 value;
+					bValid = ReadVarInt(data, position, value);
+					AppendArg(out, UnZigZag(value));
+					break;
+				}
+				case ArgType::UInt:
+				{
+					u64 value;
+					bValid = ReadVarInt(data, position, value);
+					AppendArg(out, value);
+					break;
+				}
+				case ArgType::Float:
+				{
+					float value;
+					bValid = ReadBytes(data, position, value);
+					AppendArg(out, value);
+					break;
+				}
+				case ArgType::Double:
+				{
+					double value;
+					bValid = ReadBytes(data, position, value);
+					AppendArg(out, value);
+					break;
+				}
+				case ArgType::Pointer:
+				{
+					u64 value;
+					bValid = ReadVarInt(data, position, value);
+					AppendArg(out, reinterpret_cast<const void*>(uintptr_t(value)));
+					break;
+				}
+				case ArgType::String:
+				{
+					u64 size;
+					bValid = ReadVarInt(data, position, size) && size <= data.Size() - position;
+					if (bValid)
+					{
+						AppendArg(out,
+						    StringView{reinterpret_cast<const TCHAR*>(data.Data() + position),
+						        sizet(size)});
+						position += size;
+					}
+					break;
+				}
+				default: return false;
+			}
+			if (!bValid)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool ReadString(const TArray<u8>& data, sizet& position, String& str)
+	{
+		u64 size;
+		if (!ReadVarInt(data, position, size) || size > data.Size() - position)
+		{
+			return false;
+		}
+		str.assign(reinterpret_cast<const TCHAR*>(data.Data() + position), sizet(size));
+		position += size;
+		return true;
+	}
+
+
+	BinaryLogWriter::~BinaryLogWriter()
+	{
+		Close();
+	}
+
+	bool BinaryLogWriter::Open(const Path& path, u64 maxSize, u32 maxFiles)
+	{
+		std::scoped_lock lock{mutex};
+		CloseFile();
+		filePath        = path;
+		maxFileSize     = maxSize;
+		maxRotatedFiles = maxFiles;
+		return OpenFile();
+	}
+
+	void BinaryLogWriter::Close()
+	{
+		std::scoped_lock lock{mutex};
+		CloseFile();
+	}
+
+	void BinaryLogWriter::Flush()
+	{
+		std::scoped_lock lock{mutex};
+		if (file)
+		{
+			std::fflush(file);
+		}
+	}
+
+	void BinaryLogWriter::Write(const Record& record, sizet threadId)
+	{
+		std::scoped_lock lock{mutex};
+		if (!file)
+		{
+			return;
+		}
+		const u32 formatId = record.bFormatted
+		                       ? GetFormatId(textFormat.data(), u32(textFormat.size()))
+		                       : GetFormatId(record.format, record.formatSize);
+		BeginMessage(record.level, formatId, GetCategoryId(*record.category), record.time,
+		    threadId, record.numArgs);
+		WriteArgs(entry, reinterpret_cast<const u8*>(&record + 1), record.numArgs);
+		WriteEntry(true);
+	}
+
+	void BinaryLogWriter::Write(
+	    Level level, const Category& category, StringView msg, i64 time, sizet threadId)
+	{
+		std::scoped_lock lock{mutex};
+		if (!file)
+		{
+			return;
+		}
+		const u32 formatId = GetFormatId(textFormat.data(), u32(textFormat.size()));
+		BeginMessage(level, formatId, GetCategoryId(category), time, threadId, 1);
+		entry.Add(u8(ArgType::String));
+		WriteString(entry, msg);
+		WriteEntry(true);
+	}
+
+	Path BinaryLogWriter::GetRotatedPath(const Path& path, u32 index)
+	{
+		if (index == 0)
+		{
+			return path;
+		}
+		Path rotated = path;
+		rotated.replace_filename(
+		    CString::Format("{}.{}{}", path.stem().string(), index, path.extension().string()));
+		return rotated;
+	}
+
+	bool BinaryLogWriter::OpenFile()
+	{
+		// Keep previous logs instead of overwriting them. The oldest one is removed
+		std::error_code error;
+		for (u32 index = maxRotatedFiles; index > 0; --index)
+		{
+			const Path previous = GetRotatedPath(filePath, index - 1);
+			if (fs::exists(previous, error))
+			{
+				fs::rename(previous, GetRotatedPath(filePath, index), error);
+			}
+		}
+
+		file = std::fopen(FileSystem::ToString(filePath).c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+		std::setvbuf(file, nullptr, _IOFBF, 64 * 1024);
+
+		const u32 fileMagic   = BinaryLog::magic;
+		const u16 fileVersion = BinaryLog::version;
+		const u8 pointerSize  = sizeof(void*);
+		const u8 reserved     = 0;
+		std::fwrite(&fileMagic, sizeof(fileMagic), 1, file);
+		std::fwrite(&fileVersion, sizeof(fileVersion), 1, file);
+		std::fwrite(&pointerSize, sizeof(pointerSize), 1, file);
+		std::fwrite(&reserved, sizeof(reserved), 1, file);
+		written = sizeof(fileMagic) + sizeof(fileVersion) + sizeof(pointerSize) + sizeof(reserved);
+		return true;
+	}
+
+	void BinaryLogWriter::CloseFile()
+	{
+		if (file)
+		{
+			std::fclose(file);
+			file = nullptr;
+		}
+		// Each file is read on its own, so ids start again
+		formatIds    = {};
+		categoryIds  = {};
+		lastTime     = 0;
+		lastThreadId = 0;
+	}
+
+	void BinaryLogWriter::WriteEntry(bool bEndsMessage)
+	{
+		std::fwrite(entry.Data(), 1, entry.Size(), file);
+		written += entry.Size();
+		if (bEndsMessage && maxFileSize > 0 && written >= maxFileSize)
+		{
+			CloseFile();
+			OpenFile();
+		}
+	}
+
+	u32 BinaryLogWriter::GetFormatId(const TCHAR* format, u32 formatSize)
+	{
+		if (const u32* id = formatIds.Find(format))
+		{
+			return *id;
+		}
+
+		const u32 id = formatIds.Size();
+		formatIds.Insert(format, id);
+		entry.Empty(false);
+		entry.Add(u8(BinaryLog::EntryType::Format));
+		WriteVarInt(entry, id);
+		WriteString(entry, {format, formatSize});
+		WriteEntry();
+		return id;
+	}
+
+	u32 BinaryLogWriter::GetCategoryId(const Category& category)
+	{
+		if (const u32* id = categoryIds.Find(&category))
+		{
+			return *id;
+		}
+
+		const u32 id = categoryIds.Size();
+		categoryIds.Insert(&category, id);
+		entry.Empty(false);
+		entry.Add(u8(BinaryLog::EntryType::Category));
+		WriteVarInt(entry, id);
+		// Messages without category have no prefix
+		WriteString(entry, &category == &general ? StringView{} : StringView{category.name});
+		WriteEntry();
+		return id;
+	}
+
+	void BinaryLogWriter::BeginMessage(
+	    Level level, u32 formatId, u32 categoryId, i64 time, sizet threadId, u8 numArgs)
+	{
+		// Records are timed in nanoseconds. Files store microseconds
+		const i64 micros      = time / 1000;
+		const bool bNewThread = threadId != lastThreadId;
+
+		entry.Empty(false);
+		entry.Add(u8(BinaryLog::EntryType::Message));
+		entry.Add(u8(level) | (bNewThread ? BinaryLog::newThreadFlag : 0));
+		WriteVarInt(entry, formatId);
+		WriteVarInt(entry, categoryId);
+		WriteVarInt(entry, ZigZag(micros - lastTime));
+		if (bNewThread)
+		{
+			WriteVarInt(entry, threadId);
+		}
+		entry.Add(numArgs);
+		lastTime     = micros;
+		lastThreadId = threadId;
+	}
+
+
+	String BinaryLogMessage::ToString() const
+	{
+		fmt::dynamic_format_arg_store<fmt::format_context> store;
+		const u8* in = args;
+		for (u8 i = 0; i < numArgs; ++i)
+		{
+			in = LogArgs::Decode(in, [&store](auto value) {
+				store.push_back(value);
+			});
+		}
+		String result;
+		fmt::vformat_to(
+		    std::back_inserter(result), fmt::string_view{format.data(), format.size()}, store);
+		return result;
+	}
+
+
+	bool BinaryLogReader::Open(const Path& path)
+	{
+		data.Empty();
+		position     = 0;
+		lastTime     = 0;
+		lastThreadId = 0;
+		formats.Empty();
+		categories.Empty();
+
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file)
+		{
+			return false;
+		}
+		data.Resize(i32(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		file.read(reinterpret_cast<char*>(data.Data()), data.Size());
+
+		constexpr sizet headerSize = sizeof(u32) + sizeof(u16) + 2;
+		if (sizet(data.Size()) < headerSize)
+		{
+			return false;
+		}
+		u32 fileMagic;
+		u16 fileVersion;
+		std::memcpy(&fileMagic, data.Data(), sizeof(u32));
+		std::memcpy(&fileVersion, data.Data() + sizeof(u32), sizeof(u16));
+		const u8 pointerSize = data[sizeof(u32) + sizeof(u16)];
+		position             = headerSize;
+		return fileMagic == BinaryLog::magic && fileVersion == BinaryLog::version
+		    && pointerSize == sizeof(void*);
+	}
+
+	bool BinaryLogReader::Next(BinaryLogMessage& message)
+	{
+		while (position < sizet(data.Size()))
+		{
+			const auto type = BinaryLog::EntryType(data[i32(position++)]);
+			u64 id;
+			switch (type)
+			{
+				case BinaryLog::EntryType::Format:
+				{
+					formats.AddDefaulted();
+					String& format = formats.Last();
+					if (!ReadVarInt(data, position, id) || id != u64(formats.Size() - 1)
+					    || !ReadString(data, position, format))
+					{
+						return false;
+					}
+					break;
+				}
+				case BinaryLog::EntryType::Category:
+				{
+					categories.AddDefaulted();
+					String& category = categories.Last();
+					if (!ReadVarInt(data, position, id) || id != u64(categories.Size() - 1)
+					    || !ReadString(data, position, category))
+					{
+						return false;
+					}
+					break;
+				}
+				case BinaryLog::EntryType::Message:
+				{
+					if (position >= sizet(data.Size()))
+					{
+						return false;
+					}
+					const u8 flags = data[i32(position++)];
+					u64 formatId, categoryId, timeDelta;
+					if (!ReadVarInt(data, position, formatId) || formatId >= u64(formats.Size())
+					    || !ReadVarInt(data, position, categoryId)
+					    || categoryId >= u64(categories.Size())
+					    || !ReadVarInt(data, position, timeDelta))
+					{
+						return false;
+					}
+					if ((flags & BinaryLog::newThreadFlag)
+					    && !ReadVarInt(data, position, lastThreadId))
+					{
+						return false;
+					}
+					if (position >= sizet(data.Size()))
+					{
+						return false;
+					}
+					message.numArgs = data[i32(position++)];
+					if (!ReadArgs(data, position, message.numArgs, args))
+					{
+						return false;
+					}
+
+					lastTime += UnZigZag(timeDelta);
+					message.time     = lastTime * 1000;
+					message.threadId = lastThreadId;
+					message.level    = Level(flags & ~BinaryLog::newThreadFlag);
+					message.format   = formats[i32(formatId)];
+					message.category = categories[i32(categoryId)];
+					message.args     = args.Data();
+					return true;
+				}
+				default: return false;
+			}
+		}
+		return false;
+	}
+}    // namespace Rift::Log
@@ -63,6 +63,20 @@ namespace Rift::Memory
 		discardedBlocks.Empty();
 	}
 
+	void LinearArena::Rewind()
+	{
+		if (discardedBlocks.Size() > 0)
+		{
+			const sizet size = GetUsedSize();
+			Reset();
+			if (size > 0)
+			{
+				activeBlock.Allocate(size);
+			}
+		}
+		usedBlockSize = 0;
+	}
+
 	void LinearArena::Grow(sizet size, sizet /*align*/)
 	{
 		if (size > 0)    // Don't reserve an empty block
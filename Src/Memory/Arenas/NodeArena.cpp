@@ -0,0 +1,53 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Memory/Arenas/NodeArena.h"
+
+#include "Math/Math.h"
+#include "Memory/Alloc.h"
+#include "Platform/PlatformProcess.h"
+
+
+namespace Rift::Memory
+{
+	void* NodeArena::Allocate(const sizet size, sizet alignment)
+	{
+		alignment = Math::Max<sizet>(alignment, 1);
+
+		std::unique_lock<std::mutex> lock{mutex};
+		if (blocks.Size() > 0)
+		{
+			NodeBlock& block    = blocks.Last();
+			u8* const current   = block.data + usedBlockSize;
+			const sizet padding = GetAlignmentPadding(current, alignment);
+			if (usedBlockSize + padding + size <= block.size)
+			{
+				usedBlockSize += padding + size;
+				return current + padding;
+			}
+		}
+
+		NodeBlock block;
+		block.size = Math::Max(blockSize, size + alignment);
+		block.data = static_cast<u8*>(PlatformProcess::AllocateOnNode(block.size, node));
+		if (!block.data)
+		{
+			return nullptr;
+		}
+		blocks.Add(block);
+
+		const sizet padding = GetAlignmentPadding(block.data, alignment);
+		usedBlockSize       = padding + size;
+		return block.data + padding;
+	}
+
+	void NodeArena::Reset()
+	{
+		std::unique_lock<std::mutex> lock{mutex};
+		for (const NodeBlock& block : blocks)
+		{
+			PlatformProcess::FreeOnNode(block.data, block.size);
+		}
+		blocks.Empty();
+		usedBlockSize = 0;
+	}
+}    // namespace Rift::Memory
@@ -158,7 +158,7 @@ namespace Rift
 				break;
 		}
 
-		return CString::Format(TX("{}, {:02d} {} {} {:02i}:{:02i}:{:02i} GMT"), DayStr.c_str(),
+		return CString::Format(TX("{}, {:02d} {} {} {:02d}:{:02d}:{:02d} GMT"), DayStr.c_str(),
 			GetDay(), MonthStr.c_str(), GetYear(), GetHour(), GetMinute(), GetSecond());
 	}
 
@@ -195,34 +195,34 @@ namespace Rift
 							result += IsMorning() ? TX("AM") : TX("PM");
 							break;
 						case TX('d'):
-							CString::FormatTo(result, TX("{:02i}"), GetDay());
+							CString::FormatTo(result, TX("{:02d}"), GetDay());
 							break;
 						case TX('D'):
-							CString::FormatTo(result, TX("{:03i}"), GetDayOfYear());
+							CString::FormatTo(result, TX("{:03d}"), GetDayOfYear());
 							break;
 						case TX('m'):
-							CString::FormatTo(result, TX("{:02i}"), GetMonth());
+							CString::FormatTo(result, TX("{:02d}"), GetMonth());
 							break;
 						case TX('y'):
-							CString::FormatTo(result, TX("{:02i}"), GetYear() % 100);
+							CString::FormatTo(result, TX("{:02d}"), GetYear() % 100);
 							break;
 						case TX('Y'):
-							CString::FormatTo(result, TX("{:04i}"), GetYear());
+							CString::FormatTo(result, TX("{:04d}"), GetYear());
 							break;
 						case TX('h'):
-							CString::FormatTo(result, TX("{:02i}"), GetHour12());
+							CString::FormatTo(result, TX("{:02d}"), GetHour12());
 							break;
 						case TX('H'):
-							CString::FormatTo(result, TX("{:02i}"), GetHour());
+							CString::FormatTo(result, TX("{:02d}"), GetHour());
 							break;
 						case TX('M'):
-							CString::FormatTo(result, TX("{:02i}"), GetMinute());
+							CString::FormatTo(result, TX("{:02d}"), GetMinute());
 							break;
 						case TX('S'):
-							CString::FormatTo(result, TX("{:02i}"), GetSecond());
+							CString::FormatTo(result, TX("{:02d}"), GetSecond());
 							break;
 						case TX('s'):
-							CString::FormatTo(result, TX("{:03i}"), GetMillisecond());
+							CString::FormatTo(result, TX("{:03d}"), GetMillisecond());
 							break;
 						default:
 							result += *format;
@@ -35,28 +35,28 @@ namespace Rift
 						CString::FormatTo(result, TX("{}"), Math::Abs(GetDays()));
 						break;
 					case TX('D'):
-						CString::FormatTo(result, TX("{:08i}"), Math::Abs(GetDays()));
+						CString::FormatTo(result, TX("{:08d}"), Math::Abs(GetDays()));
 						break;
 					case TX('h'):
-						CString::FormatTo(result, TX("{:02i}"), Math::Abs(GetHours()));
+						CString::FormatTo(result, TX("{:02d}"), Math::Abs(GetHours()));
 						break;
 					case TX('m'):
-						CString::FormatTo(result, TX("{:02i}"), Math::Abs(GetMinutes()));
+						CString::FormatTo(result, TX("{:02d}"), Math::Abs(GetMinutes()));
 						break;
 					case TX('s'):
-						CString::FormatTo(result, TX("{:02i}"), Math::Abs(GetSeconds()));
+						CString::FormatTo(result, TX("{:02d}"), Math::Abs(GetSeconds()));
 						break;
 					case TX('f'):
-						CString::FormatTo(result, TX("{:03i}"), Math::Abs(GetFractionMilli()));
+						CString::FormatTo(result, TX("{:03d}"), Math::Abs(GetFractionMilli()));
 						break;
 					case TX('u'):
-						CString::FormatTo(result, TX("{:06i}"), Math::Abs(GetFractionMicro()));
+						CString::FormatTo(result, TX("{:06d}"), Math::Abs(GetFractionMicro()));
 						break;
 					case TX('t'):
-						CString::FormatTo(result, TX("{:07i}"), Math::Abs(GetFractionTicks()));
+						CString::FormatTo(result, TX("{:07d}"), Math::Abs(GetFractionTicks()));
 						break;
 					case TX('n'):
-						CString::FormatTo(result, TX("{:09i}"), Math::Abs(GetFractionNano()));
+						CString::FormatTo(result, TX("{:09d}"), Math::Abs(GetFractionNano()));
 						break;
 					default:
 						result += *format;
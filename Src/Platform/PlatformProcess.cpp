@@ -0,0 +1,190 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Platform/PlatformProcess.h"
+
+#include "Files/FileSystem.h"
+#include "Math/Math.h"
+#include "Strings/String.h"
+
+#include <charconv>
+#include <fstream>
+#include <thread>
+
+#if PLATFORM_WINDOWS
+#	include <Windows.h>
+#elif PLATFORM_LINUX
+#	include <pthread.h>
+#	include <sched.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#elif PLATFORM_MACOS
+#	include <sys/mman.h>
+#endif
+
+
+namespace Rift
+{
+#if PLATFORM_LINUX
+	// From linux/mempolicy.h
+	static constexpr i32 MPOL_PREFERRED = 1;
+
+	/** Parses lists of cpu or node ids like "0-3,8,10-11" */
+	static void ParseIdList(StringView list, TArray<u32>& ids)
+	{
+		const TCHAR* it        = list.data();
+		const TCHAR* const end = it + list.size();
+		while (it < end)
+		{
+			u32 first   = 0;
+			auto result = std::from_chars(it, end, first);
+			if (result.ec != std::errc())
+			{
+				break;
+			}
+			u32 last = first;
+			if (result.ptr < end && *result.ptr == '-')
+			{
+				result = std::from_chars(result.ptr + 1, end, last);
+			}
+			for (u32 id = first; id <= last; ++id)
+			{
+				ids.Add(id);
+			}
+			// Skip the comma
+			it = result.ptr + 1;
+		}
+	}
+
+	/** Reads the first line of a sysfs file. FileSystem rejects paths without an extension */
+	static String ReadSysLine(const Path& path)
+	{
+		String line;
+		std::ifstream file{path};
+		if (file)
+		{
+			std::getline(file, line);
+		}
+		return line;
+	}
+#endif
+
+	TArray<NumaNode> PlatformProcess::GetNumaNodes()
+	{
+		TArray<NumaNode> nodes;
+#if PLATFORM_WINDOWS
+		ULONG highestNode = 0;
+		if (GetNumaHighestNodeNumber(&highestNode))
+		{
+			for (USHORT node = 0; node <= highestNode; ++node)
+			{
+				GROUP_AFFINITY affinity{};
+				if (!GetNumaNodeProcessorMaskEx(node, &affinity) || affinity.Mask == 0)
+				{
+					continue;
+				}
+				NumaNode& numaNode = nodes[nodes.AddDefaulted()];
+				numaNode.id        = node;
+				for (u32 bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit)
+				{
+					if (affinity.Mask & (KAFFINITY(1) << bit))
+					{
+						numaNode.cpus.Add(affinity.Group * u32(sizeof(KAFFINITY) * 8) + bit);
+					}
+				}
+			}
+		}
+#elif PLATFORM_LINUX
+		// Node ids can have gaps, so they are read from the list of online nodes
+		TArray<u32> ids;
+		ParseIdList(ReadSysLine("/sys/devices/system/node/online"), ids);
+		for (u32 id : ids)
+		{
+			const Path path{CString::Format("/sys/devices/system/node/node{}/cpulist", id)};
+			NumaNode node;
+			node.id = id;
+			ParseIdList(ReadSysLine(path), node.cpus);
+			if (node.cpus.Size() > 0)
+			{
+				nodes.Add(Move(node));
+			}
+		}
+#endif
+		if (nodes.Size() == 0)
+		{
+			TArray<u32>& cpus = nodes[nodes.AddDefaulted()].cpus;
+			const u32 numCpus = Math::Max(1u, std::thread::hardware_concurrency());
+			for (u32 cpu = 0; cpu < numCpus; ++cpu)
+			{
+				cpus.Add(cpu);
+			}
+		}
+		return nodes;
+	}
+
+	bool PlatformProcess::SetThreadAffinity(const TArray<u32>& cpus)
+	{
+#if PLATFORM_WINDOWS
+		// Threads can only be bound to cpus of one processor group
+		GROUP_AFFINITY affinity{};
+		affinity.Group = WORD(cpus.First() / (sizeof(KAFFINITY) * 8));
+		for (u32 cpu : cpus)
+		{
+			if (cpu / (sizeof(KAFFINITY) * 8) == affinity.Group)
+			{
+				affinity.Mask |= KAFFINITY(1) << (cpu % (sizeof(KAFFINITY) * 8));
+			}
+		}
+		return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif PLATFORM_LINUX
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (u32 cpu : cpus)
+		{
+			CPU_SET(cpu, &set);
+		}
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		// macOS only exposes affinity hints, not binding
+		return false;
+#endif
+	}
+
+	void* PlatformProcess::AllocateOnNode(sizet size, u32 node)
+	{
+#if PLATFORM_WINDOWS
+		return VirtualAllocExNuma(
+		    GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+#else
+		void* const ptr =
+		    mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+		{
+			return nullptr;
+		}
+#	if PLATFORM_LINUX
+		// Pages are not placed until touched, so the policy applies to all of them
+		u64 nodeMask[16]{};
+		if (node < sizeof(nodeMask) * 8)
+		{
+			nodeMask[node / 64] = u64(1) << (node % 64);
+			syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, nodeMask, sizeof(nodeMask) * 8, 0);
+		}
+#	endif
+		return ptr;
+#endif
+	}
+
+	void PlatformProcess::FreeOnNode(void* ptr, sizet size)
+	{
+		if (!ptr)
+		{
+			return;
+		}
+#if PLATFORM_WINDOWS
+		VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+		munmap(ptr, size);
+#endif
+	}
+}    // namespace Rift
@@ -2,6 +2,7 @@
 
 #include "Strings/Name.h"
 
+#include "Log.h"
 #include "Serialization/Archive.h"
 
 
@@ -10,39 +11,102 @@ namespace Rift
 	const String Name::noneStr{"none"};
 	const Name::Id Name::noneId{0};
 
-	sizet NameTable::Register(StringView str)
+	NameTable::~NameTable()
+	{
+		for (std::atomic<Entry*>& page : pages)
+		{
+			delete[] page.load();
+		}
+	}
+
+	NameTable::Id NameTable::Register(StringView str)
+	{
+		return Register(str, HashString(str.data(), str.size()));
+	}
+
+	NameTable::Id NameTable::Register(StringView str, sizet hash)
 	{
 		if (str.empty())
 		{
 			return Name::noneId;
 		}
 
-		// Calculate hash once
-		NameKey key{str};
-		ConstIterator FoundIt = table.find(key);
-		if (FoundIt != table.end())
+		Shard& shard = GetShard(hash);
 		{
-			std::shared_lock lock{editTableMutex};
-			return FoundIt->GetHash();
+			std::shared_lock lock{shard.mutex};
+			if (const Id id = FindInShard(shard, str, hash))
+			{
+				return id;
+			}
 		}
-		else
+
+		std::unique_lock lock{shard.mutex};
+		// Another thread could have registered it while unlocked
+		if (const Id id = FindInShard(shard, str, hash))
+		{
+			return id;
+		}
+
+		// Ids stop increasing once full, so that they can't wrap around into used ones
+		Id id = nextId.load(std::memory_order_relaxed);
+		do
 		{
-			std::unique_lock lock{editTableMutex};
-			return table.insert(Move(key)).first->GetHash();
+			if (id >= PAGE_SIZE * MAX_PAGES)
+			{
+				// Logging could register names, so the shard is unlocked first
+				lock.unlock();
+				Log::Error("Too many names registered. '{}' will be None", str);
+				return Name::noneId;
+			}
+		} while (!nextId.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+		Entry& entry = NewEntry(id);
+		entry.str    = String{str};
+
+		Id& firstId        = shard.firstIds[hash];
+		entry.nextWithHash = firstId;
+		firstId            = id;
+		return id;
+	}
+
+	NameTable::Id NameTable::FindInShard(const Shard& shard, StringView str, sizet hash) const
+	{
+		const auto foundIt = shard.firstIds.find(hash);
+		if (foundIt == shard.firstIds.end())
+		{
+			return Name::noneId;
 		}
+
+		// Different strings can share a hash. Compare all of them
+		Id id = foundIt->second;
+		while (id != Name::noneId)
+		{
+			const Entry& entry = GetEntry(id);
+			if (entry.str == str)
+			{
+				return id;
+			}
+			id = entry.nextWithHash;
+		}
+		return Name::noneId;
 	}
 
-	const String& NameTable::Find(sizet hash) const
+	NameTable::Entry& NameTable::NewEntry(Id id)
 	{
-		// Ensure no other thread is editing the table
-		std::shared_lock lock{ editTableMutex };
-		ConstIterator foundIt = table.find({ hash });
-		if (foundIt != table.end())
+		std::atomic<Entry*>& page = pages[id / PAGE_SIZE];
+		Entry* pageData           = page.load(std::memory_order_acquire);
+		if (!pageData)
 		{
-			return foundIt->GetString();
+			// Shards allocate ids concurrently, so the first id of a page may not be the first to
+			// reach it
+			std::unique_lock lock{pagesMutex};
+			pageData = page.load(std::memory_order_relaxed);
+			if (!pageData)
+			{
+				pageData = new Entry[PAGE_SIZE];
+				page.store(pageData, std::memory_order_release);
+			}
 		}
-		// Should never reach
-		return Name::NoneStr();
+		return pageData[id % PAGE_SIZE];
 	}
 
 	bool Name::Serialize(Archive& ar, StringView name)
@@ -8,19 +8,84 @@
 
 namespace Rift
 {
+	struct ScratchBuffers
+	{
+		StringBuffer buffers[ScratchBuffer::maxDepth];
+		u32 depth = 0;
+	};
+	static thread_local ScratchBuffers scratchBuffers;
+
+
+	ScratchBuffer::ScratchBuffer()
+	{
+		if (scratchBuffers.depth < maxDepth)
+		{
+			buffer = &scratchBuffers.buffers[scratchBuffers.depth];
+			buffer->clear();
+		}
+		else
+		{
+			buffer = new StringBuffer{};
+			bOwned = true;
+		}
+		++scratchBuffers.depth;
+	}
+
+	ScratchBuffer::~ScratchBuffer()
+	{
+		--scratchBuffers.depth;
+		if (bOwned)
+		{
+			delete buffer;
+		}
+		else if (buffer->capacity() > maxKeptCapacity)
+		{
+			*buffer = StringBuffer{};
+		}
+	}
+
 	void CString::ToSentenceCase(const String& str, String& result)
 	{
-		if (!str.empty())
+		if (&str == &result)
 		{
-			// static const std::regex wordToCapital("\b[a-z]");
-			static const Regex spaceCamelCase(TX("([a-zA-Z])(?=[A-Z0-9])"));
+			const String copy{str};
+			ToSentenceCase(copy, result);
+			return;
+		}
 
-			result = String{std::regex_replace(str.c_str(), spaceCamelCase, TX("$& ")).c_str()};
-			result[0] = (char) ::toupper(result[0]);
+		// Ascii only. Same output as replacing "([a-zA-Z])(?=[A-Z0-9])" with "$& "
+		const auto isUpper = [](TCHAR c) {
+			return c >= 'A' && c <= 'Z';
+		};
+		const auto isLetter = [&isUpper](TCHAR c) {
+			return isUpper(c) || (c >= 'a' && c <= 'z');
+		};
+		const auto isUpperOrDigit = [&isUpper](TCHAR c) {
+			return isUpper(c) || (c >= '0' && c <= '9');
+		};
+
+		// Inserts a space after every letter followed by an uppercase letter or a digit
+		const sizet size = str.size();
+		sizet spaces     = 0;
+		for (sizet i = 1; i < size; ++i)
+		{
+			spaces += isLetter(str[i - 1]) && isUpperOrDigit(str[i]);
 		}
-		else
+
+		result.resize(size + spaces);
+		sizet j = 0;
+		for (sizet i = 0; i < size; ++i)
 		{
-			result = TX("");
+			result[j++] = str[i];
+			if (i + 1 < size && isLetter(str[i]) && isUpperOrDigit(str[i + 1]))
+			{
+				result[j++] = ' ';
+			}
+		}
+
+		if (!result.empty())
+		{
+			result[0] = (TCHAR) ::toupper(result[0]);
 		}
 	}
 
@@ -88,18 +153,6 @@ namespace Rift
 
 	sizet CString::GetStringHash(const TCHAR* str)
 	{
-		// FNV String hash
-		// Use offset and prime based on the architecture (64bit or 32bit)
-		// http://www.isthe.com/chongo/tech/comp/fnv/index.html
-		static constexpr bool bIs32Bit     = sizeof(sizet) < 64;
-		static constexpr sizet offsetBasis = bIs32Bit ? 2166136261U : 14695981039346656037U;
-		static constexpr sizet fnvPrime    = bIs32Bit ? 16777619 : 1099511628211;
-
-		sizet c, result = offsetBasis;
-		while ((c = *str++) != 0)
-		{
-			result = (result * fnvPrime) ^ c;
-		}
-		return result;
+		return HashString(str, std::char_traits<TCHAR>::length(str));
 	}
 }	 // namespace Rift
@@ -1,56 +1,766 @@
 // Copyright 2015-2021 Piperift - All rights reserved
 
+#include "Containers/PriorityQueue.h"
 #include "Context.h"
+#include "Files/FileSystem.h"
 #include "Math/Math.h"
+#include "Platform/PlatformProcess.h"
 #include "Profiler.h"
+#include "Serialization/Json.h"
 #include "Strings/String.h"
 #include "Tasks.h"
 
+#include <bit>
 #include <chrono>
 #include <common/TracySystem.hpp>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 
 
 namespace Rift
 {
-	TaskSystem::TaskSystem()
+	/** Times are in microseconds */
+	static Json StatsToJson(const TaskSystemStats& stats)
 	{
-		// Prefer 1, but don't exceed max threads
-		const u32 mainPoolSize = Math::Min(1u, std::thread::hardware_concurrency());
-		// Prefer max threads - main threads, but don't go under 1
-		const u32 workerPoolSize =
-		    Math::Max(1u, std::thread::hardware_concurrency() - mainPoolSize);
+		static constexpr const TCHAR* priorityNames[] = {"High", "Normal", "Low"};
 
-		mainPool   = std::make_shared<ThreadPool>(mainPoolSize);
-		workerPool = std::make_shared<ThreadPool>(workerPoolSize);
+		Json json;
+		json["uptime"] = stats.uptime.count();
 
-		// Name main thread
-		tracy::SetThreadName("Main");
+		Json& threads = json["threads"] = Json::array();
+		for (const TaskThreadStats& thread : stats.threads)
+		{
+			threads.push_back({{"name", thread.thread}, {"busy", thread.busy.count()},
+			    {"idle", thread.idle.count()}, {"tasks", thread.numTasks},
+			    {"steals", thread.numSteals}});
+		}
 
+		Json& lanes = json["lanes"];
+		for (i32 i = 0; i < TaskSystem::numPriorities; ++i)
+		{
+			const TaskLaneStats& lane = stats.lanes[i];
+			Json histogram            = Json::array();
+			for (u64 count : lane.waitHistogram)
+			{
+				histogram.push_back(count);
+			}
+			lanes[priorityNames[i]] = {{"queueDepth", lane.queueDepth}, {"run", lane.numRun},
+			    {"averageWait", lane.averageWait.count()}, {"p99Wait", lane.p99Wait.count()},
+			    {"maxWait", lane.maxWait.count()}, {"waitHistogram", Move(histogram)}};
+		}
 
-		// Go over all worker threads naming them and making sure no thread is repeated
-		TaskFlow flow;
+		Json& namedTasks = json["namedTasks"] = Json::object();
+		for (const auto& named : stats.namedTasks)
+		{
+			const TaskDurationStats& duration = named.second;
+			namedTasks[named.first] = {{"count", duration.count},
+			    {"total", duration.total.count()}, {"min", duration.min.count()},
+			    {"max", duration.max.count()},
+			    {"average", duration.total.count() / i64(duration.count)}};
+		}
+		return json;
+	}
+
+
+	struct TaskSystem::TimerQueue
+	{
+		struct Timer
+		{
+			Chrono::steady_clock::time_point time;
+			TaskLambda callback;
+
+			bool operator<(const Timer& other) const
+			{
+				return time < other.time;
+			}
+		};
+
+		std::mutex mutex;
+		std::condition_variable wake;
+		TPriorityQueue<Timer> timers;
+		std::thread thread;
+		bool bStop = false;
+
+		// Periodic stats file. Never saved if nextStatsSave is max
+		Path statsFile;
+		Chrono::steady_clock::duration statsInterval{};
+		Chrono::steady_clock::time_point nextStatsSave = Chrono::steady_clock::time_point::max();
+
+
+		~TimerQueue()
+		{
+			{
+				std::unique_lock<std::mutex> lock{mutex};
+				bStop = true;
+			}
+			wake.notify_one();
+			if (thread.joinable())
+			{
+				thread.join();
+			}
+		}
+
+		void Start(const TaskSystem& tasks)
+		{
+			if (!thread.joinable())
+			{
+				thread = std::thread{[this, &tasks]() {
+					Run(tasks);
+				}};
+			}
+		}
+
+		void Run(const TaskSystem& tasks)
+		{
+			tracy::SetThreadName("Timers");
+			std::unique_lock<std::mutex> lock{mutex};
+			while (!bStop)
+			{
+				const auto now = Chrono::steady_clock::now();
+				if (now >= nextStatsSave)
+				{
+					nextStatsSave = now + statsInterval;
+					lock.unlock();
+					SaveStats(tasks);
+					lock.lock();
+				}
+				else if (!timers.IsEmpty() && now >= timers.Top().time)
+				{
+					tasks.RunAsync(Move(timers.Pop().callback));
+				}
+				else
+				{
+					auto wakeTime = nextStatsSave;
+					if (!timers.IsEmpty() && timers.Top().time < wakeTime)
+					{
+						wakeTime = timers.Top().time;
+					}
+
+					if (wakeTime == Chrono::steady_clock::time_point::max())
+					{
+						wake.wait(lock);
+					}
+					else
+					{
+						wake.wait_until(lock, wakeTime);
+					}
+				}
+			}
+		}
+
+		/** Collects stats here but writes them from an IO thread, so that timers don't wait */
+		void SaveStats(const TaskSystem& tasks)
+		{
+			tasks.RunIO([path = statsFile, json = StatsToJson(tasks.GetStats())]() {
+				FileSystem::SaveJsonFile(path, json, 2);
+			});
+		}
+	};
+
+
+	struct TaskSystem::TaskLanes
+	{
+		static constexpr i32 numWaitBuckets = 32;
+
+		struct Entry
+		{
+			TaskLambda callback;
+			Chrono::steady_clock::time_point queued;
+			// Worker that queued the task, if any
+			Impl::ThreadState* queuedBy = nullptr;
+		};
+
+		struct Lane
+		{
+			std::deque<Entry> queue;
+			std::atomic<u32> depth{0};
+			std::atomic<u64> numRun{0};
+			// Wait times in microseconds
+			std::atomic<u64> totalWait{0};
+			std::atomic<u64> maxWait{0};
+			// Tasks by the bit width of their wait, so bucket i waited less than 2^i
+			std::atomic<u64> waits[numWaitBuckets]{};
+
+
+			void RecordWait(Chrono::steady_clock::duration wait)
+			{
+				const u64 micros = u64(Chrono::duration_cast<Chrono::microseconds>(wait).count());
+				numRun.fetch_add(1, std::memory_order_relaxed);
+				totalWait.fetch_add(micros, std::memory_order_relaxed);
+				u64 lastMax = maxWait.load(std::memory_order_relaxed);
+				while (micros > lastMax
+				       && !maxWait.compare_exchange_weak(
+				           lastMax, micros, std::memory_order_relaxed))
+				{}
+				const i32 bucket = Math::Min(i32(std::bit_width(micros)), numWaitBuckets - 1);
+				waits[bucket].fetch_add(1, std::memory_order_relaxed);
+			}
+		};
+
+		std::mutex mutex;
+		Lane lanes[numPriorities];
+		u32 runningLow    = 0;
+		u32 maxRunningLow = 1;
+
+
+		Lane& Get(TaskPriority priority)
+		{
+			return lanes[u8(priority)];
+		}
+
+		/** Takes the first task that can start. Must be called with mutex locked */
+		bool Pop(Entry& entry, TaskPriority& priority)
+		{
+			for (i32 i = 0; i < numPriorities; ++i)
+			{
+				Lane& lane = lanes[i];
+				if (lane.queue.empty())
+				{
+					continue;
+				}
+				if (TaskPriority(i) == TaskPriority::Low)
+				{
+					if (runningLow >= maxRunningLow)
+					{
+						return false;
+					}
+					++runningLow;
+				}
+				entry    = Move(lane.queue.front());
+				priority = TaskPriority(i);
+				lane.queue.pop_front();
+				lane.depth.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+			return false;
+		}
+	};
+
+
+	struct Impl::ThreadState
+	{
+		String thread;
+		Memory::LinearArena arena;
+		// Tasks running on this thread, more than one if they nest. Only the outermost rewinds
+		// and is measured
+		u32 depth = 0;
+		Chrono::steady_clock::time_point taskStart;
+		std::atomic<sizet> peakSize{0};
+		std::atomic<sizet> capacity{0};
+		// Time running tasks in nanoseconds
+		std::atomic<u64> busyTime{0};
+		std::atomic<u64> numTasks{0};
+		std::atomic<u64> numSteals{0};
+		// Only locked by this thread and while collecting stats
+		std::mutex namedTasksMutex;
+		TMap<String, TaskDurationStats> namedTasks;
+
+
+		ThreadState(String thread, sizet size) : thread{Move(thread)}, arena{size}
+		{
+			capacity = size;
+		}
+
+		void BeginTask()
+		{
+			if (depth++ == 0)
+			{
+				taskStart = Chrono::steady_clock::now();
+			}
+		}
+
+		void EndTask(StringView name = {})
+		{
+			if (--depth > 0)
+			{
+				return;
+			}
+			const auto duration = Chrono::steady_clock::now() - taskStart;
+			busyTime.fetch_add(u64(Chrono::duration_cast<Chrono::nanoseconds>(duration).count()),
+			    std::memory_order_relaxed);
+			numTasks.fetch_add(1, std::memory_order_relaxed);
+			if (!name.empty())
+			{
+				RecordNamedTask(name, Chrono::duration_cast<Chrono::microseconds>(duration));
+			}
+
+			const sizet used = arena.GetUsedSize();
+			if (used > peakSize.load(std::memory_order_relaxed))
+			{
+				peakSize.store(used, std::memory_order_relaxed);
+			}
+			arena.Rewind();
+			capacity.store(arena.GetBlockSize(), std::memory_order_relaxed);
+		}
+
+		void RecordNamedTask(StringView name, Chrono::microseconds duration)
+		{
+			std::unique_lock<std::mutex> lock{namedTasksMutex};
+			const String key{name};
+			TaskDurationStats* stats = namedTasks.Find(key);
+			if (!stats)
+			{
+				namedTasks.Insert(key, TaskDurationStats{1, duration, duration, duration});
+				return;
+			}
+			++stats->count;
+			stats->total += duration;
+			stats->min = Math::Min(stats->min, duration);
+			stats->max = Math::Max(stats->max, duration);
+		}
+	};
+
+
+	// Task system, pool and state of the current thread. Pool is -1 for IO threads
+	static thread_local const TaskSystem* currentTasks    = nullptr;
+	static thread_local i32 currentPool                   = -1;
+	static thread_local Impl::ThreadState* currentThread  = nullptr;
+
+
+	/**
+	 * Tracks the tasks run by each thread, so that stats don't need the profiler. Also rewinds
+	 * the scratch arena of a thread each time it finishes a task
+	 */
+	class ThreadObserver : public tf::ObserverInterface
+	{
+	public:
+		void set_up(size_t /*numWorkers*/) override {}
+
+		void on_entry(tf::WorkerView /*worker*/, tf::TaskView /*task*/) override
+		{
+			if (currentThread)
+			{
+				currentThread->BeginTask();
+			}
+		}
+
+		void on_exit(tf::WorkerView /*worker*/, tf::TaskView task) override
+		{
+			if (currentThread)
+			{
+				const auto& name = task.name();
+				currentThread->EndTask({name.data(), name.size()});
+			}
+		}
+	};
+
+
+	/**
+	 * Runs init once on each thread of a pool. Every thread waits until all of them started one,
+	 * so that no thread takes two
+	 */
+	static void InitThreads(TaskSystem::ThreadPool& pool, const std::function<void(i32)>& init)
+	{
+		const i32 numThreads = i32(pool.num_workers());
 		std::mutex mtx;
 		std::condition_variable cv;
-		i32 currentWorker = 0;
-		flow.for_each_index(0, i32(workerPool->num_workers()), 1,
-		    [&mtx, &cv, &currentWorker, workerPoolSize](i32 i) {
-			    std::unique_lock<std::mutex> lck(mtx);
-			    ++currentWorker;
-			    cv.notify_all();
-			    while (workerPoolSize != currentWorker)
-			    {
-				    cv.wait(lck);
-			    }
-			    {
-				    // Name each worker thread in the debugger
-				    tracy::SetThreadName(CString::Format("Worker {}", i + 1).c_str());
-			    }
-		    });
-		auto future = RunFlow(flow);
-		cv.notify_all();
-		future.wait();
+		i32 arrived = 0;
+
+		TaskFlow flow;
+		for (i32 i = 0; i < numThreads; ++i)
+		{
+			flow.emplace([&mtx, &cv, &arrived, &init, numThreads, i]() {
+				{
+					std::unique_lock<std::mutex> lck(mtx);
+					++arrived;
+					cv.notify_all();
+					cv.wait(lck, [&arrived, numThreads]() {
+						return arrived == numThreads;
+					});
+				}
+				init(i);
+			});
+		}
+		pool.run(flow).wait();
+	}
+
+
+	TaskSystem::TaskSystem(const TaskSystemConfig& config)
+	    : startTime{Chrono::steady_clock::now()}
+	{
+		// Prefer max threads - main thread, but don't go under 1
+		const u32 numWorkers =
+		    config.numWorkers > 0
+		        ? config.numWorkers
+		        : Math::Max(1u, std::thread::hardware_concurrency() - 1u);
+
+		threads.Add(std::make_unique<Impl::ThreadState>("Main", config.scratchSize));
+
+		lanes = std::make_unique<TaskLanes>();
+
+		TArray<NumaNode> nodes = PlatformProcess::GetNumaNodes();
+		if (!config.bNumaPools && nodes.Size() > 1)
+		{
+			// Treat all cpus as a single node
+			for (i32 i = 1; i < nodes.Size(); ++i)
+			{
+				nodes.First().cpus.Append(nodes[i].cpus);
+			}
+			nodes.Resize(1);
+		}
+
+		// Split workers between nodes by their number of cpus
+		i64 totalCpus = 0;
+		for (const NumaNode& node : nodes)
+		{
+			totalCpus += node.cpus.Size();
+		}
+		i64 previousCpus = 0;
+		u32 assigned     = 0;
+		for (const NumaNode& node : nodes)
+		{
+			const TArray<u32>& cpus = node.cpus;
+			previousCpus += cpus.Size();
+			const i64 target = (i64(numWorkers) * previousCpus + totalCpus / 2) / totalCpus;
+			u32 poolSize     = u32(Math::Max<i64>(0, target - i64(assigned)));
+			// Every node gets a worker while there are workers left. Nodes after that get none
+			poolSize = Math::Min(Math::Max(poolSize, 1u), numWorkers - assigned);
+			if (poolSize == 0)
+			{
+				continue;
+			}
+			assigned += poolSize;
+
+			const u32 poolIndex = u32(workerPools.Size());
+			WorkerPool& pool    = workerPools[workerPools.AddDefaulted()];
+			pool.executor       = std::make_shared<ThreadPool>(poolSize);
+			pool.node           = node.id;
+			pool.arena          = std::make_unique<Memory::NodeArena>(node.id);
+
+			const bool bBindToNode = nodes.Size() > 1;
+			const i32 firstThread  = threads.Size();
+			for (u32 i = 0; i < poolSize; ++i)
+			{
+				// Name each worker thread in the debugger
+				String name = bBindToNode ? CString::Format("Worker {}.{}", node.id, i + 1)
+				                          : CString::Format("Worker {}", i + 1);
+				threads.Add(
+				    std::make_unique<Impl::ThreadState>(Move(name), config.scratchSize));
+			}
+			InitThreads(*pool.executor,
+			    [this, &config, &cpus, poolIndex, bBindToNode, firstThread](i32 i) {
+				    currentTasks  = this;
+				    currentPool   = i32(poolIndex);
+				    currentThread = threads[firstThread + i].get();
+				    if (config.bPinWorkers)
+				    {
+					    // Leave the first cpu for the main thread
+					    const i32 offset = poolIndex == 0 ? 1 : 0;
+					    PlatformProcess::SetThreadAffinity({cpus[(i + offset) % cpus.Size()]});
+				    }
+				    else if (bBindToNode)
+				    {
+					    PlatformProcess::SetThreadAffinity(cpus);
+				    }
+				    tracy::SetThreadName(currentThread->thread.c_str());
+			    });
+			pool.executor->make_observer<ThreadObserver>();
+		}
+		// Reserved workers don't take Low priority tasks, but at least one worker does
+		lanes->maxRunningLow = assigned - Math::Min(assigned - 1, config.numReservedWorkers);
+
+		if (config.numIOWorkers > 0)
+		{
+			ioPool                = std::make_shared<ThreadPool>(config.numIOWorkers);
+			const i32 firstThread = threads.Size();
+			for (u32 i = 0; i < config.numIOWorkers; ++i)
+			{
+				threads.Add(std::make_unique<Impl::ThreadState>(
+				    CString::Format("IO Worker {}", i + 1), config.scratchSize));
+			}
+			InitThreads(*ioPool, [this, firstThread](i32 i) {
+				currentTasks  = this;
+				currentPool   = -1;
+				currentThread = threads[firstThread + i].get();
+				tracy::SetThreadName(currentThread->thread.c_str());
+			});
+			ioPool->make_observer<ThreadObserver>();
+		}
+
+		timers = std::make_unique<TimerQueue>();
+		if (!config.statsFile.empty())
+		{
+			std::unique_lock<std::mutex> lock{timers->mutex};
+			timers->statsFile     = config.statsFile;
+			timers->statsInterval = config.statsInterval;
+			timers->nextStatsSave = startTime + config.statsInterval;
+			timers->Start(*this);
+		}
+
+		// Name main thread
+		mainThreadId = std::this_thread::get_id();
+		tracy::SetThreadName("Main");
+	}
+
+	TaskSystem::~TaskSystem() = default;
+
+	void TaskSystem::RunAfter(Chrono::steady_clock::duration delay, TaskLambda callback) const
+	{
+		const auto time = Chrono::steady_clock::now() + delay;
+		{
+			std::unique_lock<std::mutex> lock{timers->mutex};
+			timers->Start(*this);
+			timers->timers.Push({time, Move(callback)});
+		}
+		timers->wake.notify_one();
+	}
+
+	u32 TaskSystem::GetNumWorkerThreads() const
+	{
+		u32 numWorkers = 0;
+		for (const WorkerPool& pool : workerPools)
+		{
+			numWorkers += u32(pool.executor->num_workers());
+		}
+		return numWorkers;
+	}
+
+	i32 TaskSystem::GetCurrentNode() const
+	{
+		return currentTasks == this ? currentPool : -1;
+	}
+
+	Memory::NodeArena& TaskSystem::GetNodeArena() const
+	{
+		const i32 node = GetCurrentNode();
+		return *workerPools[node >= 0 ? node : 0].arena;
+	}
+
+	void TaskSystem::RunAsync(TaskLambda callback, TaskPriority priority) const
+	{
+		TaskLanes::Lane& lane = lanes->Get(priority);
+		{
+			std::unique_lock<std::mutex> lock{lanes->mutex};
+			lane.queue.push_back({Move(callback), Chrono::steady_clock::now(),
+			    IsWorkerThread() ? currentThread : nullptr});
+			lane.depth.fetch_add(1, std::memory_order_relaxed);
+		}
+		GetPool().executor->silent_async([this]() {
+			RunLaneTask();
+		});
+	}
+
+	bool TaskSystem::ShouldYield(TaskPriority priority) const
+	{
+		for (i32 i = 0; i < u8(priority); ++i)
+		{
+			if (lanes->lanes[i].depth.load(std::memory_order_relaxed) > 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	TaskLaneStats TaskSystem::GetLaneStats(TaskPriority priority) const
+	{
+		const TaskLanes::Lane& lane = lanes->Get(priority);
+		TaskLaneStats stats;
+		stats.queueDepth = lane.depth.load(std::memory_order_relaxed);
+		stats.numRun     = lane.numRun.load(std::memory_order_relaxed);
+		if (stats.numRun == 0)
+		{
+			return stats;
+		}
+		stats.averageWait = Chrono::microseconds(
+		    lane.totalWait.load(std::memory_order_relaxed) / stats.numRun);
+		stats.maxWait = Chrono::microseconds(lane.maxWait.load(std::memory_order_relaxed));
+
+		// Leave out empty buckets after the longest wait
+		stats.waitHistogram.Reserve(TaskLanes::numWaitBuckets);
+		i32 usedBuckets = 0;
+		for (i32 i = 0; i < TaskLanes::numWaitBuckets; ++i)
+		{
+			stats.waitHistogram.Add(lane.waits[i].load(std::memory_order_relaxed));
+			if (stats.waitHistogram.Last() > 0)
+			{
+				usedBuckets = i + 1;
+			}
+		}
+		stats.waitHistogram.Resize(usedBuckets);
+
+		const u64 p99Count = stats.numRun - stats.numRun / 100;
+		u64 count          = 0;
+		for (i32 i = 0; i < usedBuckets; ++i)
+		{
+			count += stats.waitHistogram[i];
+			if (count >= p99Count)
+			{
+				stats.p99Wait = Chrono::microseconds(u64(1) << i);
+				break;
+			}
+		}
+		return stats;
+	}
+
+	void TaskSystem::RunLaneTask() const
+	{
+		TaskLanes::Entry entry;
+		TaskPriority priority;
+		{
+			std::unique_lock<std::mutex> lock{lanes->mutex};
+			if (!lanes->Pop(entry, priority))
+			{
+				// Only Low priority tasks are left and they are at their limit
+				return;
+			}
+		}
+
+		lanes->Get(priority).RecordWait(Chrono::steady_clock::now() - entry.queued);
+		if (entry.queuedBy && entry.queuedBy != currentThread)
+		{
+			// Taskflow doesn't expose its steals, so count tasks taken from other workers
+			currentThread->numSteals.fetch_add(1, std::memory_order_relaxed);
+		}
+		entry.callback();
+
+		if (priority == TaskPriority::Low)
+		{
+			bool bLowPending;
+			{
+				std::unique_lock<std::mutex> lock{lanes->mutex};
+				--lanes->runningLow;
+				bLowPending = !lanes->Get(TaskPriority::Low).queue.empty();
+			}
+			if (bLowPending)
+			{
+				// Replace the call of a Low task that couldn't start
+				GetPool().executor->silent_async([this]() {
+					RunLaneTask();
+				});
+			}
+		}
+	}
+
+	Memory::LinearArena& TaskSystem::GetScratchArena() const
+	{
+		if (IsMainThread())
+		{
+			return threads.First()->arena;
+		}
+		assert(currentTasks == this && currentThread
+		       && "Scratch arenas can only be used from the main thread or task system threads");
+		return currentThread->arena;
+	}
+
+	TArray<ScratchStats> TaskSystem::GetScratchStats() const
+	{
+		TArray<ScratchStats> stats;
+		stats.Reserve(threads.Size());
+		for (const auto& thread : threads)
+		{
+			stats.Add({thread->thread, thread->peakSize.load(std::memory_order_relaxed),
+			    thread->capacity.load(std::memory_order_relaxed)});
+		}
+		return stats;
+	}
+
+	TaskSystemStats TaskSystem::GetStats() const
+	{
+		TaskSystemStats stats;
+		stats.uptime = Chrono::duration_cast<Chrono::microseconds>(
+		    Chrono::steady_clock::now() - startTime);
+
+		stats.threads.Reserve(threads.Size());
+		for (const auto& state : threads)
+		{
+			const Chrono::nanoseconds busy{state->busyTime.load(std::memory_order_relaxed)};
+
+			TaskThreadStats& thread = stats.threads[stats.threads.AddDefaulted()];
+			thread.thread           = state->thread;
+			thread.busy             = Chrono::duration_cast<Chrono::microseconds>(busy);
+			thread.idle             = Math::Max(stats.uptime, thread.busy) - thread.busy;
+			thread.numTasks         = state->numTasks.load(std::memory_order_relaxed);
+			thread.numSteals        = state->numSteals.load(std::memory_order_relaxed);
+
+			std::unique_lock<std::mutex> lock{state->namedTasksMutex};
+			for (const auto& named : state->namedTasks)
+			{
+				TaskDurationStats* total = stats.namedTasks.Find(named.first);
+				if (!total)
+				{
+					stats.namedTasks.Insert(named.first, named.second);
+					continue;
+				}
+				total->count += named.second.count;
+				total->total += named.second.total;
+				total->min = Math::Min(total->min, named.second.min);
+				total->max = Math::Max(total->max, named.second.max);
+			}
+		}
+
+		for (i32 i = 0; i < numPriorities; ++i)
+		{
+			stats.lanes[i] = GetLaneStats(TaskPriority(i));
+		}
+		return stats;
+	}
+
+	bool TaskSystem::SaveStats(const Path& path) const
+	{
+		return FileSystem::SaveJsonFile(path, StatsToJson(GetStats()), 2);
+	}
+
+	const TaskSystem::WorkerPool& TaskSystem::GetPool() const
+	{
+		const i32 node = GetCurrentNode();
+		if (node >= 0)
+		{
+			return workerPools[node];
+		}
+		if (workerPools.Size() == 1)
+		{
+			return workerPools.First();
+		}
+		const u32 next = nextPool.fetch_add(1, std::memory_order_relaxed);
+		return workerPools[i32(next % u32(workerPools.Size()))];
+	}
+
+	u32 TaskSystem::PumpMain(Chrono::microseconds budget)
+	{
+		ZoneScopedN("TaskSystem::PumpMain");
+		assert(IsMainThread() && "Main tasks can only be pumped from the main thread");
+
+		for (i32 i = 0; i < numPriorities; ++i)
+		{
+			TArray<TaskLambda>& pending = pendingMain[i];
+			i32& next                   = nextPendingMain[i];
+			if (next > 0)
+			{
+				// Forget tasks already run by a previous call that ran out of budget
+				pending.RemoveAt(0, next, false);
+				next = 0;
+			}
+			mainQueues[i].PopAll(pending);
+		}
+
+		Impl::ThreadState& mainThread = *threads.First();
+
+		const auto start        = Chrono::steady_clock::now();
+		const bool bLimitBudget = budget != Chrono::microseconds::max();
+		u32 numRun              = 0;
+		for (i32 i = 0; i < numPriorities; ++i)
+		{
+			TArray<TaskLambda>& pending = pendingMain[i];
+			i32& next                   = nextPendingMain[i];
+			while (next < pending.Size())
+			{
+				if (numRun > 0 && bLimitBudget && Chrono::steady_clock::now() - start >= budget)
+				{
+					return numRun;
+				}
+				TaskLambda task = Move(pending[next]);
+				++next;
+				mainThread.BeginTask();
+				task();
+				mainThread.EndTask();
+				++numRun;
+			}
+			pending.Empty(false);
+			next = 0;
+		}
+		return numRun;
 	}
 
 	TaskSystem& TaskSystem::Get()
@@ -0,0 +1,40 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include "Tasks/Coroutines.h"
+
+
+namespace Rift::Impl
+{
+	void WaitSignal::Notify()
+	{
+		// Notify while locked. The waiter can return and destroy the signal once it sees bDone
+		std::unique_lock<std::mutex> lock{mutex};
+		bDone = true;
+		cv.notify_all();
+	}
+
+	void WaitSignal::Wait(TaskSystem& tasks)
+	{
+		if (!tasks.IsMainThread())
+		{
+			std::unique_lock<std::mutex> lock{mutex};
+			cv.wait(lock, [this]() {
+				return bDone;
+			});
+			return;
+		}
+
+		// Main tasks don't notify the signal, so check them periodically
+		static constexpr Chrono::microseconds pumpInterval{500};
+		std::unique_lock<std::mutex> lock{mutex};
+		while (!bDone)
+		{
+			lock.unlock();
+			tasks.PumpMain();
+			lock.lock();
+			cv.wait_for(lock, pumpInterval, [this]() {
+				return bDone;
+			});
+		}
+	}
+}    // namespace Rift::Impl
@@ -0,0 +1,79 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Assets/AssetData.h>
+#include <Context.h>
+#include <Files/TestFolder.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+static const Path testFolder = GetTestFolder("AssetData");
+
+
+class TestAsset : public AssetData
+{
+	CLASS(TestAsset, AssetData)
+
+public:
+	PROP(i32, value);
+	i32 value = 0;
+};
+
+
+go_bandit([]() {
+	describe("AssetData", []() {
+		UseTestFolder(testFolder);
+
+		before_each([]() {
+			Context::Initialize({.numWorkers = 2});
+		});
+		after_each([]() {
+			Context::Shutdown();
+		});
+
+		it("Saves in the background", [&]() {
+			const Path path = testFolder / "asset.meta";
+			auto asset      = Create<TestAsset>();
+			asset->OnCreate(AssetInfo{path});
+			asset->value = 5;
+			AssertThat(asset->SaveAsync().get(), Equals(true));
+
+			Json data;
+			AssertThat(FileSystem::LoadJsonFile(path, data), Equals(true));
+			auto loaded = Create<TestAsset>();
+			AssertThat(loaded->OnLoad(AssetInfo{path}, data), Equals(true));
+			AssertThat(loaded->value, Equals(5));
+		});
+
+		it("Saves over older queued saves", [&]() {
+			const Path path = testFolder / "asset.meta";
+			auto asset      = Create<TestAsset>();
+			asset->OnCreate(AssetInfo{path});
+			asset->value = 1;
+			std::shared_future<bool> older = asset->SaveAsync();
+			asset->value                   = 2;
+			AssertThat(asset->Save(), Equals(true));
+			AssertThat(older.get(), Equals(true));
+
+			Json data;
+			AssertThat(FileSystem::LoadJsonFile(path, data), Equals(true));
+			auto loaded = Create<TestAsset>();
+			loaded->OnLoad(AssetInfo{path}, data);
+			AssertThat(loaded->value, Equals(2));
+		});
+
+		it("Doesn't save into folders or missing folders", [&]() {
+			auto asset = Create<TestAsset>();
+			asset->OnCreate(AssetInfo{testFolder / "Folder"});
+			AssertThat(asset->SaveAsync().get(), Equals(false));
+			AssertThat(asset->Save(), Equals(false));
+
+			asset->OnCreate(AssetInfo{testFolder / "Missing" / "asset.meta"});
+			AssertThat(asset->SaveAsync().get(), Equals(false));
+		});
+	});
+});
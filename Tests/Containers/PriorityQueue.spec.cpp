@@ -0,0 +1,111 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Containers/PriorityQueue.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Containers", []() {
+		describe("Priority Queue", []() {
+			it("Pops in priority order", [&]() {
+				TPriorityQueue<i32> queue;
+				for (i32 value : {5, 3, 8, 1, 9, 2, 7})
+				{
+					queue.Push(value);
+				}
+				AssertThat(queue.Size(), Equals(7));
+				AssertThat(queue.Top(), Equals(1));
+
+				i32 last = queue.Pop();
+				while (!queue.IsEmpty())
+				{
+					const i32 current = queue.Pop();
+					AssertThat(current, Is().GreaterThanOrEqualTo(last));
+					last = current;
+				}
+				AssertThat(last, Equals(9));
+			});
+
+			it("Supports custom predicates and 4-ary layout", [&]() {
+				TPriorityQueue<i32, More, 4> queue;
+				for (i32 i = 0; i < 100; ++i)
+				{
+					queue.Push((i * 37) % 100);
+				}
+
+				for (i32 i = 99; i >= 0; --i)
+				{
+					AssertThat(queue.Pop(), Equals(i));
+				}
+				AssertThat(queue.IsEmpty(), Equals(true));
+			});
+
+			it("Can be built from an array", [&]() {
+				TPriorityQueue<i32> queue{TArray<i32>{4, 2, 6, 1, 3}};
+				AssertThat(queue.Size(), Equals(5));
+				AssertThat(queue.Pop(), Equals(1));
+				AssertThat(queue.Pop(), Equals(2));
+				AssertThat(queue.Pop(), Equals(3));
+			});
+		});
+
+		describe("Indexed Priority Queue", []() {
+			it("Can decrease keys by handle", [&]() {
+				TIndexedPriorityQueue<i32> queue;
+				const auto a = queue.Push(10);
+				const auto b = queue.Push(20);
+				const auto c = queue.Push(30);
+				AssertThat(queue.TopHandle(), Equals(a));
+
+				queue.DecreaseKey(c, 5);
+				AssertThat(queue.TopHandle(), Equals(c));
+				AssertThat(queue.Get(b), Equals(20));
+
+				queue.IncreaseKey(c, 40);
+				AssertThat(queue.Pop(), Equals(10));
+				AssertThat(queue.Pop(), Equals(20));
+				AssertThat(queue.Pop(), Equals(40));
+			});
+
+			it("Can remove by handle", [&]() {
+				TIndexedPriorityQueue<i32, Less, 4> queue;
+				TArray<i32> handles;
+				for (i32 i = 0; i < 50; ++i)
+				{
+					handles.Add(queue.Push(i));
+				}
+
+				AssertThat(queue.Remove(handles[0]), Equals(true));
+				AssertThat(queue.Remove(handles[0]), Equals(false));
+				AssertThat(queue.Contains(handles[0]), Equals(false));
+				AssertThat(queue.Remove(handles[25]), Equals(true));
+
+				AssertThat(queue.Size(), Equals(48));
+				AssertThat(queue.Pop(), Equals(1));
+
+				i32 last = 1;
+				while (!queue.IsEmpty())
+				{
+					const i32 current = queue.Pop();
+					AssertThat(current, Is().GreaterThan(last));
+					AssertThat(current, Is().Not().EqualTo(25));
+					last = current;
+				}
+			});
+
+			it("Reuses handles", [&]() {
+				TIndexedPriorityQueue<i32> queue;
+				const auto a = queue.Push(1);
+				queue.Pop();
+				const auto b = queue.Push(2);
+				AssertThat(b, Equals(a));
+				AssertThat(queue.Get(b), Equals(2));
+			});
+		});
+	});
+});
@@ -0,0 +1,65 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Containers/SlotMap.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Containers", []() {
+		describe("Slot Map", []() {
+			it("Finds values by key", [&]() {
+				TSlotMap<i32> map;
+				const auto a = map.Insert(10);
+				const auto b = map.Insert(20);
+				const auto c = map.Insert(30);
+				AssertThat(map.Size(), Equals(3));
+				AssertThat(*map.Find(b), Equals(20));
+
+				AssertThat(map.Remove(a), Equals(true));
+				AssertThat(map.Remove(a), Equals(false));
+				AssertThat(map.Find(a) == nullptr, Equals(true));
+				AssertThat(map[b], Equals(20));
+				AssertThat(map[c], Equals(30));
+				AssertThat(map.Size(), Equals(2));
+			});
+
+			it("Invalidates keys of reused slots", [&]() {
+				TSlotMap<i32> map;
+				const auto a = map.Insert(1);
+				map.Remove(a);
+				const auto b = map.Insert(2);
+				AssertThat(b.index, Equals(a.index));
+				AssertThat(map.Contains(a), Equals(false));
+				AssertThat(map.Contains(b), Equals(true));
+				AssertThat(map.Contains(SlotMapKey::FromU64(b.ToU64())), Equals(true));
+				AssertThat(map.Contains({}), Equals(false));
+			});
+
+			it("Keeps values packed", [&]() {
+				TSlotMap<i32> map;
+				for (i32 i = 0; i < 10; ++i)
+				{
+					map.Insert(i);
+				}
+				AssertThat(map.RemoveIf([](i32 value) {
+					return value % 2 == 0;
+				}),
+				    Equals(5));
+
+				i32 sum = 0;
+				for (i32 value : map)
+				{
+					sum += value;
+				}
+				AssertThat(sum, Equals(1 + 3 + 5 + 7 + 9));
+				AssertThat(map.GetValues().size(), Equals(5u));
+				AssertThat(map[map.GetKey(2)], Equals(map.GetValues()[2]));
+			});
+		});
+	});
+});
@@ -0,0 +1,93 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Containers/SoAArray.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+struct SoATestParticle
+{
+	float x    = 0.f;
+	float y    = 0.f;
+	i32 id     = 0;
+	bool alive = true;
+};
+
+using ParticleArray =
+    TSoAArray<SoATestParticle, &SoATestParticle::x, &SoATestParticle::y, &SoATestParticle::id>;
+
+
+go_bandit([]() {
+	describe("Containers", []() {
+		describe("SoA Array", []() {
+			it("Stores each member in its own column", [&]() {
+				ParticleArray particles;
+				particles.Add({1.f, 2.f, 10});
+				particles.Add({3.f, 4.f, 20});
+				particles.Add({5.f, 6.f, 30});
+				AssertThat(particles.Size(), Equals(3));
+
+				auto xs = particles.GetColumn<&SoATestParticle::x>();
+				AssertThat(xs.size(), Equals(3u));
+				AssertThat(xs[1], Equals(3.f));
+
+				auto ids = particles.GetColumn<&SoATestParticle::id>();
+				AssertThat(ids[2], Equals(30));
+				AssertThat(ParticleArray::GetColumnIndex<&SoATestParticle::alive>(),
+				    Equals(ParticleArray::numColumns));
+			});
+
+			it("Stores bool members as bytes", [&]() {
+				TSoAArray<SoATestParticle, &SoATestParticle::id, &SoATestParticle::alive> particles;
+				particles.Add({0.f, 0.f, 1, true});
+				particles.Add({0.f, 0.f, 2, false});
+
+				TSpan<u8> alive = particles.GetColumn<&SoATestParticle::alive>();
+				AssertThat(alive.size(), Equals(2u));
+				AssertThat(alive[0], Equals(u8(1)));
+				AssertThat(alive[1], Equals(u8(0)));
+
+				alive[1] = true;
+				AssertThat(particles.Get(1).alive, Equals(true));
+				particles[0].Store({0.f, 0.f, 1, false});
+				AssertThat(particles.Get(0).alive, Equals(false));
+			});
+
+			it("Can access rows", [&]() {
+				ParticleArray particles;
+				particles.Add({1.f, 2.f, 10});
+				particles.Add({3.f, 4.f, 20});
+
+				particles[1].Get<&SoATestParticle::y>() = 8.f;
+				const SoATestParticle loaded = particles[1].Load();
+				AssertThat(loaded.x, Equals(3.f));
+				AssertThat(loaded.y, Equals(8.f));
+				AssertThat(loaded.id, Equals(20));
+
+				particles[0].Store({7.f, 7.f, 7});
+				AssertThat(particles.Get(0).id, Equals(7));
+			});
+
+			it("Removes rows from all columns", [&]() {
+				ParticleArray particles;
+				for (i32 i = 0; i < 5; ++i)
+				{
+					particles.Add({float(i), float(i), i});
+				}
+
+				particles.RemoveAt(1);
+				AssertThat(particles.Size(), Equals(4));
+				AssertThat(particles.Get(1).id, Equals(2));
+
+				particles.RemoveAtSwap(0);
+				AssertThat(particles.Size(), Equals(3));
+				AssertThat(particles.Get(0).id, Equals(4));
+				AssertThat(particles.GetColumn<&SoATestParticle::x>()[0], Equals(4.f));
+			});
+		});
+	});
+});
@@ -0,0 +1,34 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Containers/SparseSet.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Containers", []() {
+		describe("Sparse Set", []() {
+			it("Can insert and remove ids", [&]() {
+				TSparseSet<u32> set;
+				AssertThat(set.Insert(3), Equals(true));
+				AssertThat(set.Insert(100), Equals(true));
+				AssertThat(set.Insert(7), Equals(true));
+				AssertThat(set.Insert(3), Equals(false));
+				AssertThat(set.Size(), Equals(3));
+
+				AssertThat(set.Remove(3), Equals(true));
+				AssertThat(set.Remove(3), Equals(false));
+				AssertThat(set.Contains(3), Equals(false));
+				AssertThat(set.Contains(100), Equals(true));
+				AssertThat(set.Contains(7), Equals(true));
+				AssertThat(set.Contains(2000), Equals(false));
+				AssertThat(set.IndexOf(7), Equals(0));
+				AssertThat(set.Size(), Equals(2));
+			});
+		});
+	});
+});
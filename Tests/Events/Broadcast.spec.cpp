@@ -0,0 +1,40 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Events/Broadcast.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Events", []() {
+		it("Can unbind broadcast listeners by handle", [&]() {
+			Broadcast<i32> broadcast;
+			i32 total = 0;
+
+			const auto first = broadcast.Bind([&total](i32 value) {
+				total += value;
+			});
+			const auto second = broadcast.Bind([&total](i32 value) {
+				total += value * 10;
+			});
+
+			broadcast.DoBroadcast(1);
+			AssertThat(total, Equals(11));
+
+			Broadcast<i32> other;
+			AssertThat(other.Unbind(first), Equals(false));
+			AssertThat(broadcast.Unbind(first), Equals(true));
+			AssertThat(broadcast.Unbind(first), Equals(false));
+			broadcast.DoBroadcast(1);
+			AssertThat(total, Equals(21));
+
+			AssertThat(broadcast.Unbind(second), Equals(true));
+			broadcast.DoBroadcast(1);
+			AssertThat(total, Equals(21));
+		});
+	});
+});
@@ -0,0 +1,117 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/AsyncIO.h>
+#include <Files/TestFolder.h>
+#include <Tasks.h>
+#include <bandit/bandit.h>
+
+#include <cstring>
+#include <future>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+static const Path testFolder = GetTestFolder("AsyncIO");
+
+
+static void ReadsAndWrites(AsyncIO& io)
+{
+	const Path file = testFolder / "data.bin";
+
+	TArray<u8> data(1000);
+	for (i32 i = 0; i < data.Size(); ++i)
+	{
+		data[i] = u8(i % 251);
+	}
+	{
+		IOFile output = IOFile::Open(file, true);
+		AssertThat(output.IsOpen(), Equals(true));
+		std::future<i64> first  = io.Write(output, {data.Data(), 500}, 0);
+		std::future<i64> second = io.Write(output, {data.Data() + 500, 500}, 500);
+		io.Submit();
+		AssertThat(first.get(), Equals(500));
+		AssertThat(second.get(), Equals(500));
+	}
+
+	IOFile input = IOFile::Open(file);
+	AssertThat(input.GetSize(), Equals(1000u));
+	TArray<u8> read(1000, 0);
+	std::promise<i64> readResult;
+	io.Read(input, {read.Data(), 1000}, 0, [&readResult](i64 result) {
+		readResult.set_value(result);
+	});
+	io.Submit();
+	AssertThat(readResult.get_future().get(), Equals(1000));
+	AssertThat(std::memcmp(read.Data(), data.Data(), 1000), Equals(0));
+
+	String content;
+	std::future<bool> loaded = io.LoadFile(file, content);
+	io.Submit();
+	AssertThat(loaded.get(), Equals(true));
+	AssertThat(content.size(), Equals(1000u));
+	AssertThat(std::memcmp(content.data(), data.Data(), 1000), Equals(0));
+
+	String missing;
+	AssertThat(io.LoadFile(testFolder / "missing.bin", missing).get(), Equals(false));
+}
+
+
+go_bandit([]() {
+	describe("AsyncIO", []() {
+		static TaskSystem tasks;
+		UseTestFolder(testFolder);
+
+		it("Reads and writes files", [&]() {
+			AsyncIO io{tasks};
+			ReadsAndWrites(io);
+		});
+
+		it("Reads and writes files on IO threads", [&]() {
+			AsyncIO io{tasks, {.bUseIOUring = false}};
+			AssertThat(io.IsUsingIOUring(), Equals(false));
+			ReadsAndWrites(io);
+		});
+
+		it("Submits full batches", [&]() {
+			const Path file = testFolder / "batch.bin";
+			FileSystem::SaveStringFile(file, "0123456789");
+
+			AsyncIO io{tasks, {.queueDepth = 4}};
+			IOFile input = IOFile::Open(file);
+			u8 bytes[10]{};
+			TArray<std::future<i64>> reads;
+			for (i32 i = 0; i < 10; ++i)
+			{
+				reads.Add(io.Read(input, {bytes + i, 1}, u64(i)));
+			}
+			// The first 8 reads were submitted when the queue filled up
+			for (i32 i = 0; i < 8; ++i)
+			{
+				AssertThat(reads[i].get(), Equals(1));
+			}
+			io.Flush();
+			const String text{reinterpret_cast<const char*>(bytes), 10};
+			AssertThat(text, Equals("0123456789"));
+		});
+
+		it("Reads into registered buffers", [&]() {
+			const Path file = testFolder / "registered.bin";
+			FileSystem::SaveStringFile(file, "registered");
+
+			AsyncIO io{tasks};
+			TArray<u8> buffer(64, 0);
+			io.RegisterBuffers({std::span<u8>{buffer.Data(), 64}});
+
+			IOFile input = IOFile::Open(file);
+			std::future<i64> read = io.Read(input, {buffer.Data() + 8, 10}, 0, 0);
+			io.Submit();
+			AssertThat(read.get(), Equals(10));
+			const String text{reinterpret_cast<const char*>(buffer.Data() + 8), 10};
+			AssertThat(text, Equals("registered"));
+			io.UnregisterBuffers();
+		});
+	});
+});
@@ -0,0 +1,138 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/DirectoryCrawler.h>
+#include <Files/TestFolder.h>
+#include <Tasks.h>
+#include <bandit/bandit.h>
+
+#include <algorithm>
+#include <future>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+static const Path testFolder = GetTestFolder("Crawler");
+
+static TArray<String> ToSortedNames(const TArray<Path>& paths)
+{
+	TArray<String> names;
+	for (const Path& path : paths)
+	{
+		names.Add(FileSystem::ToString(FileSystem::ToRelative(path, testFolder).generic_string()));
+	}
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+
+go_bandit([]() {
+	describe("DirectoryCrawler", []() {
+		UseTestFolder(testFolder);
+		before_each([]() {
+			FileSystem::CreateFolder(testFolder / "A" / "B", true);
+			FileSystem::CreateFolder(testFolder / "C", true);
+			FileSystem::SaveStringFile(testFolder / "root.rf", "");
+			FileSystem::SaveStringFile(testFolder / "other.txt", "");
+			FileSystem::SaveStringFile(testFolder / "A" / "a.rf", "");
+			FileSystem::SaveStringFile(testFolder / "A" / "B" / "b.rf", "");
+			FileSystem::SaveStringFile(testFolder / "C" / "c.txt", "");
+		});
+
+		it("Finds files in all folders", [&]() {
+			TaskSystem tasks;
+			DirectoryCrawler crawler;
+			CrawlSettings settings;
+			settings.extension = ".rf";
+			settings.tasks     = &tasks;
+
+			const TArray<String> names = ToSortedNames(crawler.Crawl(testFolder, settings));
+			AssertThat(names.Size(), Equals(3));
+			AssertThat(names[0], Equals("A/B/b.rf"));
+			AssertThat(names[1], Equals("A/a.rf"));
+			AssertThat(names[2], Equals("root.rf"));
+
+			settings.extension = {};
+			AssertThat(crawler.Crawl(testFolder, settings).Size(), Equals(5));
+		});
+
+		it("Follows links only to files", [&]() {
+			std::error_code error;
+			fs::create_directory_symlink(testFolder, testFolder / "A" / "Loop", error);
+			fs::create_symlink(testFolder / "root.rf", testFolder / "C" / "linked.rf", error);
+
+			TaskSystem tasks;
+			DirectoryCrawler crawler;
+			CrawlSettings settings;
+			settings.extension = ".rf";
+			settings.tasks     = &tasks;
+
+			const TArray<Path> files = crawler.Crawl(testFolder, settings);
+			AssertThat(files.Size(), Equals(4));
+			AssertThat(std::any_of(files.begin(), files.end(),
+			               [](const Path& file) {
+				               return file == testFolder / "C" / "linked.rf";
+			               }),
+			    Equals(true));
+		});
+
+		it("Can skip subfolders", [&]() {
+			TaskSystem tasks;
+			DirectoryCrawler crawler;
+			CrawlSettings settings;
+			settings.extension  = ".rf";
+			settings.bRecursive = false;
+			settings.tasks      = &tasks;
+
+			const TArray<String> names = ToSortedNames(crawler.Crawl(testFolder, settings));
+			AssertThat(names.Size(), Equals(1));
+			AssertThat(names[0], Equals("root.rf"));
+		});
+
+		it("Updates cached listings", [&]() {
+			TaskSystem tasks;
+			DirectoryCrawler crawler;
+			CrawlSettings settings;
+			settings.extension = ".rf";
+			settings.tasks     = &tasks;
+
+			AssertThat(crawler.Crawl(testFolder, settings).Size(), Equals(3));
+			AssertThat(crawler.Crawl(testFolder, settings).Size(), Equals(3));
+
+			FileSystem::SaveStringFile(testFolder / "A" / "B" / "new.rf", "");
+			FileSystem::Delete(testFolder / "root.rf");
+			const TArray<String> names = ToSortedNames(crawler.Crawl(testFolder, settings));
+			AssertThat(names.Size(), Equals(3));
+			AssertThat(names[0], Equals("A/B/b.rf"));
+			AssertThat(names[1], Equals("A/B/new.rf"));
+			AssertThat(names[2], Equals("A/a.rf"));
+		});
+
+		it("Doesn't wait for busy workers", [&]() {
+			TaskSystem tasks{{.numWorkers = 1}};
+			std::promise<void> release;
+			tasks.RunAsync([future = release.get_future().share()]() {
+				future.wait();
+			});
+
+			DirectoryCrawler crawler;
+			CrawlSettings settings;
+			settings.extension = ".rf";
+			settings.tasks     = &tasks;
+			AssertThat(crawler.Crawl(testFolder, settings).Size(), Equals(3));
+			release.set_value();
+		});
+
+		it("Lists a single folder", [&]() {
+			DirectoryCrawler::Listing listing;
+			AssertThat(DirectoryCrawler::List(testFolder, listing), Equals(true));
+			AssertThat(listing.files.Size(), Equals(2));
+			AssertThat(listing.folders.Size(), Equals(2));
+
+			DirectoryCrawler::Listing missing;
+			AssertThat(DirectoryCrawler::List(testFolder / "missing", missing), Equals(false));
+		});
+	});
+});
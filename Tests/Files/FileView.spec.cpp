@@ -0,0 +1,70 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/FileView.h>
+#include <Files/TestFolder.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+static const Path testFolder = GetTestFolder("FileView");
+
+
+go_bandit([]() {
+	describe("FileView", []() {
+		UseTestFolder(testFolder);
+
+		it("Maps files", [&]() {
+			const Path file = testFolder / "view.txt";
+			FileSystem::SaveStringFile(file, "Some file content");
+
+			FileView view{file};
+			AssertThat(view.IsOpen(), Equals(true));
+			AssertThat(view.IsMapped(), Equals(true));
+			AssertThat(view.GetSize(), Equals(17u));
+			AssertThat(String{view.GetString()}, Equals("Some file content"));
+
+			FileView moved{Move(view)};
+			AssertThat(view.IsOpen(), Equals(false));
+			AssertThat(String{moved.GetString()}, Equals("Some file content"));
+		});
+
+		it("Opens empty and missing files", [&]() {
+			const Path file = testFolder / "empty.txt";
+			FileSystem::SaveStringFile(file, "");
+
+			const FileView empty{file, FileAccess::Random};
+			AssertThat(empty.IsOpen(), Equals(true));
+			AssertThat(empty.GetSize(), Equals(0u));
+			AssertThat(empty.GetString().empty(), Equals(true));
+
+			const FileView missing{testFolder / "missing.txt"};
+			AssertThat(missing.IsOpen(), Equals(false));
+		});
+
+#if PLATFORM_LINUX
+		it("Reads files that can't be mapped", [&]() {
+			const FileView status{"/proc/self/status"};
+			AssertThat(status.IsOpen(), Equals(true));
+			AssertThat(status.IsMapped(), Equals(false));
+			AssertThat(status.GetString().starts_with("Name:"), Equals(true));
+		});
+#endif
+
+		it("Loads json files", [&]() {
+			const Path file = testFolder / "data.json";
+			FileSystem::SaveStringFile(file, R"({"value": 3, "list": [1, 2]})");
+
+			Json json;
+			AssertThat(FileSystem::LoadJsonFile(file, json), Equals(true));
+			AssertThat(json["value"].get<i32>(), Equals(3));
+			AssertThat(json["list"].size(), Equals(2u));
+
+			FileSystem::SaveStringFile(file, "{ not json");
+			AssertThat(FileSystem::LoadJsonFile(file, json), Equals(false));
+		});
+	});
+});
@@ -0,0 +1,195 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/FileWatcher.h>
+#include <Files/TestFolder.h>
+#include <Tasks.h>
+#include <bandit/bandit.h>
+
+#include <functional>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+static const Path testFolder = GetTestFolder("FileWatcher");
+
+/** Pumps main tasks until condition is met or a few seconds pass */
+static bool WaitFor(TaskSystem& tasks, const std::function<bool()>& condition)
+{
+	const auto end = Chrono::steady_clock::now() + Chrono::seconds{5};
+	while (!condition() && Chrono::steady_clock::now() < end)
+	{
+		tasks.PumpMain();
+		std::this_thread::sleep_for(Chrono::milliseconds{5});
+	}
+	return condition();
+}
+
+static const FileChange* FindChange(const TArray<FileChange>& changes, const Path& path)
+{
+	for (const FileChange& change : changes)
+	{
+		if (change.path == path)
+		{
+			return &change;
+		}
+	}
+	return nullptr;
+}
+
+
+go_bandit([]() {
+	describe("FileWatcher", []() {
+		UseTestFolder(testFolder);
+		before_each([]() {
+			FileSystem::CreateFolder(testFolder / "Sub", true);
+		});
+
+		it("Reports changes in subfolders", [&]() {
+			TaskSystem tasks;
+			FileWatcherConfig config;
+			config.debounce     = Chrono::milliseconds{20};
+			config.pollInterval = Chrono::milliseconds{20};
+			FileWatcher watcher{tasks, config};
+			TArray<FileChange> changes;
+			watcher.onChanged.Bind([&changes](const TArray<FileChange>& batch) {
+				changes.Append(batch);
+			});
+			AssertThat(watcher.Watch(testFolder), Equals(true));
+
+			const Path file = testFolder / "Sub" / "file.txt";
+			FileSystem::SaveStringFile(file, "content");
+			AssertThat(WaitFor(tasks,
+			               [&]() {
+				               return FindChange(changes, file) != nullptr;
+			               }),
+			    Equals(true));
+			AssertThat(FindChange(changes, file)->type, Equals(FileChangeType::Added));
+			AssertThat(FindChange(changes, file)->bFolder, Equals(false));
+
+			changes.Empty();
+			FileSystem::Delete(file);
+			AssertThat(WaitFor(tasks,
+			               [&]() {
+				               return FindChange(changes, file) != nullptr;
+			               }),
+			    Equals(true));
+			AssertThat(FindChange(changes, file)->type, Equals(FileChangeType::Removed));
+		});
+
+#if PLATFORM_LINUX
+		it("Watches new folders", [&]() {
+			TaskSystem tasks;
+			FileWatcherConfig config;
+			config.debounce = Chrono::milliseconds{20};
+			FileWatcher watcher{tasks, config};
+			AssertThat(watcher.IsUsingINotify(), Equals(true));
+			TArray<FileChange> changes;
+			watcher.onChanged.Bind([&changes](const TArray<FileChange>& batch) {
+				changes.Append(batch);
+			});
+			watcher.Watch(testFolder);
+
+			FileSystem::CreateFolder(testFolder / "New" / "Nested", true);
+			const Path file = testFolder / "New" / "Nested" / "file.txt";
+			FileSystem::SaveStringFile(file, "content");
+			AssertThat(WaitFor(tasks,
+			               [&]() {
+				               return FindChange(changes, file) != nullptr;
+			               }),
+			    Equals(true));
+			AssertThat(FindChange(changes, file)->type, Equals(FileChangeType::Added));
+			AssertThat(FindChange(changes, testFolder / "New")->bFolder, Equals(true));
+		});
+
+		it("Delivers batches of continuous changes", [&]() {
+			TaskSystem tasks;
+			FileWatcherConfig config;
+			config.debounce   = Chrono::seconds{10};
+			config.maxLatency = Chrono::milliseconds{50};
+			FileWatcher watcher{tasks, config};
+			TArray<FileChange> changes;
+			watcher.onChanged.Bind([&changes](const TArray<FileChange>& batch) {
+				changes.Append(batch);
+			});
+			watcher.Watch(testFolder);
+
+			// Files never stop changing, so the debounce alone would never deliver them
+			const Path file = testFolder / "file.txt";
+			const auto end  = Chrono::steady_clock::now() + Chrono::seconds{5};
+			while (changes.IsEmpty() && Chrono::steady_clock::now() < end)
+			{
+				FileSystem::SaveStringFile(file, "content");
+				tasks.PumpMain();
+				std::this_thread::sleep_for(Chrono::milliseconds{5});
+			}
+			AssertThat(FindChange(changes, file) != nullptr, Equals(true));
+		});
+
+		it("Pairs renames", [&]() {
+			TaskSystem tasks;
+			FileWatcherConfig config;
+			config.debounce = Chrono::milliseconds{20};
+			FileWatcher watcher{tasks, config};
+			TArray<FileChange> changes;
+			watcher.onChanged.Bind([&changes](const TArray<FileChange>& batch) {
+				changes.Append(batch);
+			});
+
+			const Path from = testFolder / "from.txt";
+			const Path to   = testFolder / "Sub" / "to.txt";
+			FileSystem::SaveStringFile(from, "content");
+			watcher.Watch(testFolder);
+			fs::rename(from, to);
+			AssertThat(WaitFor(tasks,
+			               [&]() {
+				               return FindChange(changes, to) != nullptr;
+			               }),
+			    Equals(true));
+			AssertThat(changes.Size(), Equals(1));
+			AssertThat(changes[0].type, Equals(FileChangeType::Renamed));
+			AssertThat(changes[0].oldPath, Equals(from));
+
+			// Paths of renamed folders are updated
+			changes.Empty();
+			fs::rename(testFolder / "Sub", testFolder / "Moved");
+			const Path file = testFolder / "Moved" / "file.txt";
+			FileSystem::SaveStringFile(file, "content");
+			AssertThat(WaitFor(tasks,
+			               [&]() {
+				               return FindChange(changes, file) != nullptr;
+			               }),
+			    Equals(true));
+		});
+#endif
+
+		it("Polls when inotify is not used", [&]() {
+			TaskSystem tasks;
+			FileWatcherConfig config;
+			config.bUseINotify  = false;
+			config.pollInterval = Chrono::milliseconds{20};
+			FileWatcher watcher{tasks, config};
+			AssertThat(watcher.IsUsingINotify(), Equals(false));
+			TArray<FileChange> changes;
+			watcher.onChanged.Bind([&changes](const TArray<FileChange>& batch) {
+				changes.Append(batch);
+			});
+			const Path file = testFolder / "Sub" / "file.txt";
+			FileSystem::SaveStringFile(file, "content");
+			watcher.Watch(testFolder);
+
+			// Existing files are not reported
+			const Path added = testFolder / "added.txt";
+			FileSystem::SaveStringFile(added, "content");
+			AssertThat(WaitFor(tasks,
+			               [&]() {
+				               return FindChange(changes, added) != nullptr;
+			               }),
+			    Equals(true));
+			AssertThat(changes.Size(), Equals(1));
+			AssertThat(changes[0].type, Equals(FileChangeType::Added));
+		});
+	});
+});
@@ -0,0 +1,93 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/SaveQueue.h>
+#include <Files/TestFolder.h>
+#include <Tasks.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+static const Path testFolder = GetTestFolder("SaveQueue");
+
+
+go_bandit([]() {
+	describe("SaveQueue", []() {
+		UseTestFolder(testFolder);
+
+		it("Writes files in the background", [&]() {
+			TaskSystem tasks;
+			SaveQueue queue{tasks};
+
+			TArray<std::shared_future<bool>> results;
+			for (i32 i = 0; i < 20; ++i)
+			{
+				Json data;
+				data["index"] = i;
+				const Path path = testFolder / CString::Format("file{}.json", i);
+				results.Add(queue.Save(path, Move(data)));
+			}
+			for (auto& result : results)
+			{
+				AssertThat(result.get(), Equals(true));
+			}
+
+			Json json;
+			AssertThat(FileSystem::LoadJsonFile(testFolder / "file7.json", json), Equals(true));
+			AssertThat(json["index"].get<i32>(), Equals(7));
+			// Temporary files were renamed or removed
+			i32 numFiles = 0;
+			for (const auto& entry : fs::directory_iterator(testFolder))
+			{
+				AssertThat(entry.path().extension() == ".json", Equals(true));
+				++numFiles;
+			}
+			AssertThat(numFiles, Equals(20));
+		});
+
+		it("Coalesces saves of the same file", [&]() {
+			TaskSystem tasks;
+			SaveQueueConfig config;
+			config.delay = Chrono::milliseconds{50};
+			SaveQueue queue{tasks, config};
+
+			const Path path = testFolder / "file.txt";
+			auto first      = queue.Save(path, String{"first"});
+			auto second     = queue.Save(path, String{"second"});
+			AssertThat(queue.GetNumPending(), Equals(1));
+
+			queue.Flush();
+			AssertThat(queue.GetNumPending(), Equals(0));
+			AssertThat(first.get(), Equals(true));
+			AssertThat(second.get(), Equals(true));
+
+			String content;
+			FileSystem::LoadStringFile(path, content);
+			AssertThat(content, Equals("second"));
+		});
+
+		it("Replaces existing files", [&]() {
+			const Path path = testFolder / "file.txt";
+			FileSystem::SaveStringFile(path, "A longer old content");
+
+			AssertThat(SaveQueue::WriteFile(path, "New content"), Equals(true));
+			String content;
+			FileSystem::LoadStringFile(path, content);
+			AssertThat(content, Equals("New content"));
+
+			const Path missing = testFolder / "Missing" / "file.txt";
+			AssertThat(SaveQueue::WriteFile(missing, "New content"), Equals(false));
+			AssertThat(FileSystem::Exists(testFolder / "Missing"), Equals(false));
+		});
+
+		it("Reports failed saves", [&]() {
+			TaskSystem tasks;
+			SaveQueue queue{tasks};
+			auto result = queue.Save(testFolder / "Missing" / "file.txt", String{"data"});
+			AssertThat(result.get(), Equals(false));
+		});
+	});
+});
@@ -0,0 +1,32 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+#pragma once
+
+#include <Files/FileSystem.h>
+#include <Misc/Guid.h>
+#include <bandit/bandit.h>
+
+
+namespace Rift
+{
+	/**
+	 * @return temporary folder for the tests of a suite. Its name is unique to each run, so that
+	 * runs in parallel don't share it
+	 */
+	inline Path GetTestFolder(StringView suite)
+	{
+		static const String runId = Guid::New().ToString();
+		return fs::temp_directory_path() / CString::Format("Rift{}Test-{}", suite, runId);
+	}
+
+	/** Makes folder empty before each test of the current describe, and removes it after */
+	inline void UseTestFolder(const Path& folder)
+	{
+		bandit::before_each([folder]() {
+			FileSystem::Delete(folder, true, false);
+			FileSystem::CreateFolder(folder, true);
+		});
+		bandit::after_each([folder]() {
+			FileSystem::Delete(folder, true, false);
+		});
+	}
+}    // namespace Rift
@@ -0,0 +1,97 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/FileWatcher.h>
+#include <Files/TestFolder.h>
+#include <Files/VirtualFileSystem.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+static const Path testFolder = GetTestFolder("VFS");
+
+
+go_bandit([]() {
+	describe("VirtualFileSystem", []() {
+		UseTestFolder(testFolder);
+		before_each([]() {
+			FileSystem::CreateFolder(testFolder / "Base" / "Textures", true);
+			FileSystem::CreateFolder(testFolder / "Patch", true);
+			FileSystem::SaveStringFile(testFolder / "Base" / "Textures" / "grass.rf", "base grass");
+			FileSystem::SaveStringFile(testFolder / "Base" / "rock.rf", "base rock");
+			FileSystem::SaveStringFile(testFolder / "Patch" / "rock.rf", "patched rock");
+		});
+
+		it("Normalizes keys", [&]() {
+			AssertThat(VirtualFileSystem::ToKey("Assets/a.rf"), Equals(Name{"Assets/a.rf"}));
+			AssertThat(VirtualFileSystem::ToKey("/Assets//./a.rf/"), Equals(Name{"Assets/a.rf"}));
+			const Name parent = VirtualFileSystem::ToKey("Assets\\B\\..\\a.rf");
+			AssertThat(parent, Equals(Name{"Assets/a.rf"}));
+		});
+
+		it("Resolves files of the last mount first", [&]() {
+			VirtualFileSystem vfs;
+			vfs.Mount<FolderMount>("Assets", testFolder / "Base");
+			vfs.Mount<FolderMount>("Assets", testFolder / "Patch");
+
+			AssertThat(vfs.IsFolder("Assets"), Equals(true));
+			AssertThat(vfs.IsFolder("Assets/Textures"), Equals(true));
+			AssertThat(vfs.IsFile("Assets/Textures/grass.rf"), Equals(true));
+			AssertThat(vfs.Exists("Assets/missing.rf"), Equals(false));
+			AssertThat(vfs.Exists("Other/rock.rf"), Equals(false));
+
+			AssertThat(String{vfs.Read("Assets/rock.rf").GetString()}, Equals("patched rock"));
+			AssertThat(String{vfs.Read("Assets/Textures/grass.rf").GetString()},
+			    Equals("base grass"));
+			AssertThat(vfs.Read("Assets/missing.rf").IsOpen(), Equals(false));
+		});
+
+		it("Caches resolved paths until invalidated", [&]() {
+			VirtualFileSystem vfs;
+			vfs.Mount<FolderMount>(Name::None(), testFolder / "Base");
+			AssertThat(vfs.IsFile("rock.rf"), Equals(true));
+			AssertThat(vfs.IsFile("new.rf"), Equals(false));
+
+			FileSystem::Delete(testFolder / "Base" / "rock.rf");
+			FileSystem::SaveStringFile(testFolder / "Base" / "new.rf", "new");
+			AssertThat(vfs.IsFile("rock.rf"), Equals(true));
+			AssertThat(vfs.IsFile("new.rf"), Equals(false));
+
+			vfs.Invalidate("rock.rf");
+			AssertThat(vfs.IsFile("rock.rf"), Equals(false));
+
+			TArray<FileChange> changes;
+			changes.Add({FileChangeType::Added, testFolder / "Base" / "new.rf"});
+			vfs.OnFilesChanged(changes);
+			AssertThat(vfs.IsFile("new.rf"), Equals(true));
+		});
+
+		it("Reads pack files", [&]() {
+			const Path packPath = testFolder / "base.pack";
+			AssertThat(PackMount::Write(packPath, testFolder / "Base"), Equals(true));
+
+			VirtualFileSystem vfs;
+			auto* pack = vfs.Mount<PackMount>("Assets", packPath);
+			AssertThat(pack->IsValid(), Equals(true));
+			vfs.Mount<FolderMount>("Assets", testFolder / "Patch");
+
+			AssertThat(vfs.IsFolder("Assets/Textures"), Equals(true));
+			const FileView grass = vfs.Read("Assets/Textures/grass.rf");
+			AssertThat(grass.IsMapped(), Equals(true));
+			AssertThat(String{grass.GetString()}, Equals("base grass"));
+			AssertThat(String{vfs.Read("Assets/rock.rf").GetString()}, Equals("patched rock"));
+
+			// Views keep the pack mapped
+			vfs.Unmount(pack);
+			AssertThat(String{grass.GetString()}, Equals("base grass"));
+			AssertThat(vfs.Exists("Assets/Textures/grass.rf"), Equals(false));
+
+			FileSystem::SaveStringFile(packPath, "not a pack");
+			const PackMount invalid{packPath};
+			AssertThat(invalid.IsValid(), Equals(false));
+		});
+	});
+});
@@ -0,0 +1,195 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/FileSystem.h>
+#include <Log.h>
+#include <Log/BinaryLog.h>
+#include <bandit/bandit.h>
+
+#include <atomic>
+#include <thread>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+struct CountedFormat
+{
+	static inline i32 formatted = 0;
+};
+
+template <>
+struct fmt::formatter<CountedFormat> : fmt::formatter<StringView>
+{
+	template <typename FormatContext>
+	auto format(const CountedFormat&, FormatContext& ctx)
+	{
+		++CountedFormat::formatted;
+		return fmt::formatter<StringView>::format("Counted", ctx);
+	}
+};
+
+
+go_bandit([]() {
+	describe("Log", []() {
+		it("Categories have their own level", [&]() {
+			Log::Category category{"LogTestCategory", Log::Level::Warning};
+			AssertThat(Log::IsEnabled<Log::Level::Info>(category), Equals(false));
+			AssertThat(Log::IsEnabled<Log::Level::Error>(category), Equals(true));
+
+			category.SetLevel(Log::Level::Verbose);
+			AssertThat(Log::IsEnabled<Log::Level::Verbose>(category),
+			    Equals(Log::compiledLevel <= Log::Level::Verbose));
+			AssertThat(Log::IsEnabled<Log::Level::Verbose>(), Equals(false));
+		});
+
+		it("Doesn't format disabled messages", [&]() {
+			Log::Category category{"LogTestCategory", Log::Level::None};
+			const CountedFormat value;
+			Log::Verbose(category, "{}", value);
+			Log::Info(category, "{}", value);
+			Log::Error(category, "{} {}", value, 3);
+			Log::Verbose("{}", value);
+			AssertThat(CountedFormat::formatted, Equals(0));
+		});
+
+		it("Writes async messages in order", [&]() {
+			const Path logFile = std::filesystem::temp_directory_path() / "RiftLogTest" / "log.txt";
+			FileSystem::Delete(logFile.parent_path(), true, false);
+			Log::Init({.logPath = logFile, .bAsync = true});
+			AssertThat(Log::IsAsync(), Equals(true));
+
+			static Log::Category category{"LogTest"};
+			std::thread other{[]() {
+				Log::Info(category, "Other thread {}", 1);
+			}};
+			other.join();
+			Log::Info(category, "Values {} {:.1f} {} {}", 3, 2.5f, String{"text"}, 'c');
+			Log::Warning(category, "Formatted by the caller: {}", CountedFormat{});
+			AssertThat(CountedFormat::formatted, Equals(1));
+			Log::Flush();
+
+			String content;
+			FileSystem::LoadStringFile(logFile, content);
+			const sizet first  = content.find("[LogTest] Other thread 1");
+			const sizet second = content.find("[LogTest] Values 3 2.5 text c");
+			const sizet third  = content.find("[LogTest] Formatted by the caller: Counted");
+			AssertThat(first != String::npos, Equals(true));
+			AssertThat(second != String::npos && second > first, Equals(true));
+			AssertThat(third != String::npos && third > second, Equals(true));
+
+			Log::Shutdown();
+			AssertThat(Log::IsAsync(), Equals(false));
+		});
+
+		it("Doesn't lose messages logged during shutdown", [&]() {
+			const Path logFile = std::filesystem::temp_directory_path() / "RiftLogTest" / "log.txt";
+			FileSystem::Delete(logFile.parent_path(), true, false);
+			Log::Init({.logPath = logFile, .bConsole = false, .bAsync = true});
+
+			static Log::Category category{"ShutdownTest"};
+			static constexpr i32 numMessages = 2000;
+			std::atomic<bool> bStarted{false};
+			std::thread other{[&bStarted]() {
+				for (i32 i = 0; i < numMessages; ++i)
+				{
+					Log::Info(category, "Message {}", i);
+					bStarted = true;
+				}
+			}};
+			while (!bStarted) {}
+			Log::Shutdown();
+			other.join();
+			Log::Flush();
+
+			String content;
+			FileSystem::LoadStringFile(logFile, content);
+			i32 found = 0;
+			for (sizet pos = content.find("[ShutdownTest] Message"); pos != String::npos;
+			     pos       = content.find("[ShutdownTest] Message", pos + 1))
+			{
+				++found;
+			}
+			AssertThat(found, Equals(numMessages));
+		});
+
+		it("Writes and reads binary logs", [&]() {
+			const Path logFile =
+			    std::filesystem::temp_directory_path() / "RiftLogTest" / "log.rlog";
+			// Arguments are only stored unformatted by the async backend
+			Log::Init({.logPath = logFile,
+			    .fileFormat = Log::FileFormat::Binary,
+			    .bConsole = false,
+			    .bAsync = true});
+
+			static Log::Category category{"BinaryTest"};
+			Log::Info(category, "Values {} {} {:.2f} {}", -4, 7u, 1.5, String{"text"});
+			Log::Error("Plain {}", true);
+			const char* missing = nullptr;
+			Log::Info(category, "Missing {}", missing);
+			Log::Warning(category, "Formatted by the caller: {}", CountedFormat{});
+			Log::Shutdown();
+
+			Log::BinaryLogReader reader;
+			AssertThat(reader.Open(logFile), Equals(true));
+			Log::BinaryLogMessage message;
+			AssertThat(reader.Next(message), Equals(true));
+			AssertThat(message.level, Equals(Log::Level::Info));
+			AssertThat(String{message.category}, Equals("BinaryTest"));
+			AssertThat(String{message.format}, Equals("Values {} {} {:.2f} {}"));
+			AssertThat(message.ToString(), Equals("Values -4 7 1.50 text"));
+
+			AssertThat(reader.Next(message), Equals(true));
+			AssertThat(message.level, Equals(Log::Level::Error));
+			AssertThat(message.category.empty(), Equals(true));
+			AssertThat(message.ToString(), Equals("Plain true"));
+
+			AssertThat(reader.Next(message), Equals(true));
+			AssertThat(message.ToString(), Equals("Missing (null)"));
+
+			AssertThat(reader.Next(message), Equals(true));
+			AssertThat(message.ToString(), Equals("Formatted by the caller: Counted"));
+			AssertThat(reader.Next(message), Equals(false));
+		});
+
+		it("Rotates binary logs", [&]() {
+			const Path logFile =
+			    std::filesystem::temp_directory_path() / "RiftLogTest" / "rotated.rlog";
+			FileSystem::CreateFolder(logFile.parent_path(), true);
+			for (u32 i = 0; i < 4; ++i)
+			{
+				FileSystem::Delete(Log::BinaryLogWriter::GetRotatedPath(logFile, i), true, false);
+			}
+
+			Log::BinaryLogWriter writer;
+			AssertThat(writer.Open(logFile, 64, 2), Equals(true));
+			writer.Write(Log::Level::Info, Log::general, "First", 0, 1);
+			writer.Close();
+
+			// Reopening keeps the previous file
+			AssertThat(writer.Open(logFile, 64, 2), Equals(true));
+			const Path previous = Log::BinaryLogWriter::GetRotatedPath(logFile, 1);
+			AssertThat(FileSystem::Exists(previous), Equals(true));
+			for (u32 i = 0; i < 10; ++i)
+			{
+				writer.Write(Log::Level::Info, Log::general, "Long enough message", 0, 1);
+			}
+			writer.Close();
+
+			const Path oldest = Log::BinaryLogWriter::GetRotatedPath(logFile, 2);
+			AssertThat(oldest.filename().string(), Equals("rotated.2.rlog"));
+			AssertThat(FileSystem::Exists(oldest), Equals(true));
+			AssertThat(FileSystem::Exists(Log::BinaryLogWriter::GetRotatedPath(logFile, 3)),
+			    Equals(false));
+			AssertThat(fs::file_size(logFile) < 128, Equals(true));
+
+			// Rotated files start with their own formats and categories
+			Log::BinaryLogReader reader;
+			AssertThat(reader.Open(oldest), Equals(true));
+			Log::BinaryLogMessage message;
+			AssertThat(reader.Next(message), Equals(true));
+			AssertThat(message.ToString(), Equals("Long enough message"));
+		});
+	});
+});
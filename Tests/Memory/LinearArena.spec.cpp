@@ -130,6 +130,20 @@ go_bandit([]() {
 				void* secondBlock = *arena.GetBlock();
 				AssertThat(firstBlock, Is().Not().EqualTo(secondBlock));
 			});
+
+			it("Rewinds into a single block", [&]() {
+				LinearArena arena{16};
+				arena.Allocate(12);
+				arena.Allocate(12);
+				AssertThat(arena.GetUsedSize(), Is().EqualTo(28));
+
+				arena.Rewind();
+				AssertThat(arena.GetUsedSize(), Is().EqualTo(0));
+				AssertThat(arena.GetDiscardedBlocks().Size(), Is().EqualTo(0));
+				AssertThat(arena.GetBlockSize(), Is().EqualTo(28));
+				arena.Allocate(24);
+				AssertThat(arena.GetDiscardedBlocks().Size(), Is().EqualTo(0));
+			});
 		});
 	});
 });
@@ -0,0 +1,38 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Memory/Alloc.h>
+#include <Memory/Arenas/NodeArena.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+using namespace Rift::Memory;
+
+
+go_bandit([]() {
+	describe("Memory", []() {
+		describe("Node Arena", []() {
+			it("Allocates aligned memory", [&]() {
+				NodeArena arena{0, 256};
+				void* a = arena.Allocate(3);
+				void* b = arena.Allocate(8, 64);
+				AssertThat(a, Is().Not().Null());
+				AssertThat(b, Is().Not().Null());
+				AssertThat(GetAlignmentPadding(b, 64), Equals(0));
+				AssertThat(static_cast<u8*>(b) >= static_cast<u8*>(a) + 3, Is().True());
+			});
+
+			it("Allocates more than a block", [&]() {
+				NodeArena arena{0, 256};
+				u8* big = static_cast<u8*>(arena.Allocate(1000));
+				AssertThat(big, Is().Not().Null());
+				big[999] = 1;
+
+				arena.Reset();
+				AssertThat(arena.Allocate(16), Is().Not().Null());
+			});
+		});
+	});
+});
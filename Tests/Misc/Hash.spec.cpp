@@ -0,0 +1,59 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Containers/Array.h>
+#include <Misc/Hash.h>
+#include <Strings/String.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Misc", []() {
+		describe("Hash", []() {
+			it("Gives the same result at compile time", [&]() {
+				static constexpr const TCHAR* text =
+				    TX("A string long enough to go over the 48 byte stripes of the hash");
+				constexpr sizet size         = 64;
+				constexpr sizet compiledHash = HashString(text, size);
+				AssertThat(HashBytes(text, size * sizeof(TCHAR)), Equals(compiledHash));
+				AssertThat(HashString(text, size - 1), Is().Not().EqualTo(compiledHash));
+			});
+
+			it("Hashes strings by size", [&]() {
+				const String str{"HashedString"};
+				const StringView view{"HashedStringWithSuffix", 12};
+				AssertThat(Hash<String>()(str), Equals(Hash<StringView>()(view)));
+
+				// Characters after a null are hashed too
+				const String withNull{"Hashed\0One", 10};
+				const String withNull2{"Hashed\0Two", 10};
+				AssertThat(Hash<String>()(withNull), Is().Not().EqualTo(Hash<String>()(withNull2)));
+			});
+
+			it("Can hash in pieces", [&]() {
+				TArray<u8> data;
+				for (i32 i = 0; i < 500; ++i)
+				{
+					data.Add(u8(i * 31 + 7));
+				}
+
+				for (sizet size : {0, 3, 16, 17, 48, 49, 96, 97, 200, 500})
+				{
+					for (sizet piece : {1, 5, 16, 48, 100})
+					{
+						StreamHasher hasher{5};
+						for (sizet offset = 0; offset < size; offset += piece)
+						{
+							hasher.Update(data.Data() + offset, Math::Min(piece, size - offset));
+						}
+						AssertThat(hasher.Finish(), Equals(HashBytes64(data.Data(), size, 5)));
+					}
+				}
+			});
+		});
+	});
+});
@@ -0,0 +1,139 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Parallel.h>
+#include <bandit/bandit.h>
+
+#include <atomic>
+#include <future>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Parallel", []() {
+		static TaskSystem tasks;
+
+		it("Runs every index once", [&]() {
+			TArray<i32> visits(u32(10000), 0);
+			ParallelFor(
+			    visits.Size(),
+			    [&visits](i32 i) {
+				    ++visits[i];
+			    },
+			    {.grainSize = 64, .tasks = &tasks});
+
+			AssertThat(visits.Contains([](i32 count) {
+				return count != 1;
+			}),
+			    Equals(false));
+		});
+
+		it("Runs small inputs inline", [&]() {
+			std::atomic<i32> ranges = 0;
+			ParallelForRange(
+			    100,
+			    [&ranges](i32 begin, i32 end) {
+				    ++ranges;
+			    },
+			    {.tasks = &tasks});
+			AssertThat(ranges.load(), Equals(1));
+		});
+
+		it("Runs chunks in background lanes", [&]() {
+			TArray<i32> visits(u32(2000), 0);
+			ParallelFor(
+			    visits.Size(),
+			    [&visits](i32 i) {
+				    ++visits[i];
+			    },
+			    {.grainSize = 100, .tasks = &tasks, .priority = TaskPriority::Low});
+
+			AssertThat(visits.Contains([](i32 count) {
+				return count != 1;
+			}),
+			    Equals(false));
+		});
+
+		it("Doesn't wait for a saturated lane", [&]() {
+			// A single worker can run Low priority tasks, and it is kept busy
+			TaskSystem busy{{.numWorkers = 2}};
+			std::promise<void> release;
+			busy.RunAsync(
+			    [future = release.get_future().share()]() {
+				    future.wait();
+			    },
+			    TaskPriority::Low);
+
+			std::atomic<i32> visits{0};
+			ParallelFor(
+			    2000,
+			    [&visits](i32) {
+				    ++visits;
+			    },
+			    {.grainSize = 100, .tasks = &busy, .priority = TaskPriority::Low});
+			AssertThat(visits.load(), Equals(2000));
+			release.set_value();
+		});
+
+		it("Can reduce, transform and scan", [&]() {
+			TArray<i32> items;
+			for (i32 i = 1; i <= 5000; ++i)
+			{
+				items.Add(i);
+			}
+			const ParallelSettings settings{.grainSize = 100, .tasks = &tasks};
+
+			const i32 sum = ParallelReduce(
+			    items, 0,
+			    [](i32 a, i32 b) {
+				    return a + b;
+			    },
+			    settings);
+			AssertThat(sum, Equals(5000 * 5001 / 2));
+
+			TArray<i64> squares;
+			ParallelTransform(
+			    items, squares,
+			    [](i32 item) {
+				    return i64(item) * item;
+			    },
+			    settings);
+			AssertThat(squares.Size(), Equals(5000));
+			AssertThat(squares[99], Equals(i64(10000)));
+
+			TArray<i32> prefix;
+			ParallelScan(
+			    items, prefix, 0,
+			    [](i32 a, i32 b) {
+				    return a + b;
+			    },
+			    settings);
+			AssertThat(prefix[0], Equals(1));
+			AssertThat(prefix[150], Equals(151 * 152 / 2));
+			AssertThat(prefix.Last(), Equals(sum));
+		});
+
+		it("Filters keeping order", [&]() {
+			TArray<i32> items;
+			for (i32 i = 0; i < 3000; ++i)
+			{
+				items.Add(i);
+			}
+
+			const TArray<i32> even = ParallelFilter(
+			    items,
+			    [](i32 item) {
+				    return item % 2 == 0;
+			    },
+			    {.grainSize = 128, .tasks = &tasks});
+			AssertThat(even.Size(), Equals(1500));
+			for (i32 i = 0; i < even.Size(); ++i)
+			{
+				AssertThat(even[i], Equals(i * 2));
+			}
+		});
+	});
+});
@@ -0,0 +1,86 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Containers/Array.h>
+#include <Strings/Name.h>
+#include <bandit/bandit.h>
+
+#include <thread>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Strings", []() {
+		describe("Name", []() {
+			it("Gets the same id for the same string", [&]() {
+				const Name a{"NameTestA"};
+				const Name b{String{"NameTestA"}};
+				const Name c{"NameTestB"};
+				AssertThat(a == b, Equals(true));
+				AssertThat(a == c, Equals(false));
+				AssertThat(a.ToString(), Equals("NameTestA"));
+				AssertThat(c.ToString(), Equals("NameTestB"));
+			});
+
+			it("Empty strings are none", [&]() {
+				const Name empty{""};
+				AssertThat(empty.IsNone(), Equals(true));
+				AssertThat(empty == Name::None(), Equals(true));
+				AssertThat(empty.ToString(), Equals(Name::NoneStr()));
+			});
+
+			it("Only compares the string of a view", [&]() {
+				const String str{"NameTestViewSuffix"};
+				const Name view{StringView{str}.substr(0, 12)};
+				AssertThat(view.ToString(), Equals("NameTestView"));
+				AssertThat(view == Name{"NameTestView"}, Equals(true));
+			});
+
+			it("Can be created from literals", [&]() {
+				static_assert(
+				    TStaticName{"NameTestLiteral"}.hash == HashString("NameTestLiteral", 15));
+
+				const Name& literal = "NameTestLiteral"_name;
+				AssertThat(literal == Name{"NameTestLiteral"}, Equals(true));
+				AssertThat(literal.ToString(), Equals("NameTestLiteral"));
+				AssertThat(&literal == &StaticName<"NameTestLiteral">(), Equals(true));
+				AssertThat("NameTestLiteral"_name == "NameTestOther"_name, Equals(false));
+			});
+
+			it("Can register from multiple threads", [&]() {
+				static constexpr i32 numThreads = 4;
+				static constexpr i32 numNames   = 2000;
+
+				TArray<TArray<Name>> results;
+				results.Resize(numThreads);
+				TArray<std::thread> threads;
+				for (i32 t = 0; t < numThreads; ++t)
+				{
+					threads.Add(std::thread{[&results, t]() {
+						for (i32 i = 0; i < numNames; ++i)
+						{
+							results[t].Add(Name{CString::Format("ThreadName{}", i)});
+						}
+					}});
+				}
+				for (std::thread& thread : threads)
+				{
+					thread.join();
+				}
+
+				for (i32 i = 0; i < numNames; ++i)
+				{
+					const Name& name = results[0][i];
+					AssertThat(name.ToString(), Equals(CString::Format("ThreadName{}", i)));
+					for (i32 t = 1; t < numThreads; ++t)
+					{
+						AssertThat(results[t][i] == name, Equals(true));
+					}
+				}
+			});
+		});
+	});
+});
@@ -0,0 +1,65 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Strings/String.h>
+#include <bandit/bandit.h>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Strings", []() {
+		describe("String", []() {
+			it("Can format into buffers", [&]() {
+				AssertThat(CString::Format("{}-{:03d}", "a", 7), Equals("a-007"));
+
+				StringBuffer buffer;
+				CString::FormatTo(buffer, "{} {}", 1, 2);
+				CString::FormatTo(buffer, "{}", 3);
+				AssertThat(StringView(buffer.data(), buffer.size()), Equals("1 23"));
+			});
+
+			it("Scratch buffers can be nested", [&]() {
+				ScratchBuffer outer;
+				CString::FormatTo(outer.Get(), "outer");
+				{
+					ScratchBuffer inner;
+					AssertThat(inner.ToView().size(), Equals(0u));
+					CString::FormatTo(inner.Get(), "{}", CString::Format("inner {}", 1));
+					AssertThat(inner.ToView(), Equals("inner 1"));
+				}
+				AssertThat(outer.ToView(), Equals("outer"));
+			});
+
+			it("Can convert to sentence case", [&]() {
+				String result;
+				CString::ToSentenceCase("myPropertyName", result);
+				AssertThat(result, Equals("My Property Name"));
+				CString::ToSentenceCase("value2D", result);
+				AssertThat(result, Equals("Value 2D"));
+				CString::ToSentenceCase("", result);
+				AssertThat(result, Equals(""));
+
+				result = "alreadyInResult";
+				CString::ToSentenceCase(result, result);
+				AssertThat(result, Equals("Already In Result"));
+			});
+
+			it("Sentence case matches the regex version", [&]() {
+				const Regex spaceCamelCase(TX("([a-zA-Z])(?=[A-Z0-9])"));
+				for (const TCHAR* str : {"a", "A", "ab", "aB", "AB", "ABC", "a1", "1a", "12AB",
+				         "HTTPServer", "bIsEnabled", "snake_case_Name", "x9y8Z7", "under_9"})
+				{
+					String expected = std::regex_replace(str, spaceCamelCase, TX("$& ")).c_str();
+					expected[0]     = (TCHAR) ::toupper(expected[0]);
+
+					String result;
+					CString::ToSentenceCase(str, result);
+					AssertThat(result, Equals(expected));
+				}
+			});
+		});
+	});
+});
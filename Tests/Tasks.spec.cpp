@@ -0,0 +1,301 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Files/FileSystem.h>
+#include <Tasks.h>
+#include <bandit/bandit.h>
+
+#include <future>
+#include <latch>
+#include <mutex>
+#include <thread>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Tasks", []() {
+		static TaskSystem tasks;
+
+		it("Runs main tasks posted from other threads", [&]() {
+			AssertThat(tasks.IsMainThread(), Equals(true));
+
+			bool bRanOnMain = false;
+			std::thread other{[&bRanOnMain]() {
+				AssertThat(tasks.IsMainThread(), Equals(false));
+				tasks.PostMain([&bRanOnMain]() {
+					bRanOnMain = tasks.IsMainThread();
+				});
+			}};
+			other.join();
+
+			AssertThat(tasks.PumpMain(), Equals(1u));
+			AssertThat(bRanOnMain, Equals(true));
+			AssertThat(tasks.PumpMain(), Equals(0u));
+		});
+
+		it("Runs main tasks by priority", [&]() {
+			TArray<i32> order;
+			tasks.PostMain(
+			    [&order]() {
+				    order.Add(3);
+			    },
+			    TaskPriority::Low);
+			tasks.PostMain([&order]() {
+				order.Add(1);
+			});
+			tasks.PostMain(
+			    [&order]() {
+				    order.Add(0);
+			    },
+			    TaskPriority::High);
+			tasks.PostMain([&order]() {
+				order.Add(2);
+			});
+
+			AssertThat(tasks.PumpMain(), Equals(4u));
+			AssertThat(order.Size(), Equals(4));
+			for (i32 i = 0; i < order.Size(); ++i)
+			{
+				AssertThat(order[i], Equals(i));
+			}
+		});
+
+		it("Keeps main tasks over budget for the next pump", [&]() {
+			i32 runs = 0;
+			for (i32 i = 0; i < 3; ++i)
+			{
+				tasks.PostMain([&runs]() {
+					++runs;
+					std::this_thread::sleep_for(Chrono::milliseconds(2));
+				});
+			}
+
+			AssertThat(tasks.PumpMain(Chrono::microseconds(1)), Equals(1u));
+			AssertThat(runs, Equals(1));
+
+			// Posted while pumping, runs after the ones left over
+			tasks.PostMain([&runs]() {
+				runs *= 10;
+			});
+			AssertThat(tasks.PumpMain(), Equals(3u));
+			AssertThat(runs, Equals(30));
+		});
+
+		it("Can be configured", [&]() {
+			TaskSystem configured{{.numWorkers = 2, .numIOWorkers = 1}};
+			AssertThat(configured.GetNumWorkerThreads(), Equals(2u));
+			AssertThat(configured.GetNumIOThreads(), Equals(1u));
+			AssertThat(configured.GetNumNodes() > 0, Equals(true));
+			AssertThat(configured.IsWorkerThread(), Equals(false));
+
+			std::promise<i32> node;
+			configured.RunIO([&configured, &node]() {
+				node.set_value(configured.GetCurrentNode());
+			});
+			AssertThat(node.get_future().get(), Equals(-1));
+
+			TaskFlow flow;
+			bool bOnWorker = false;
+			flow.emplace([&configured, &bOnWorker]() {
+				bOnWorker = configured.IsWorkerThread() && !tasks.IsWorkerThread();
+			});
+			configured.RunFlow(flow).wait();
+			AssertThat(bOnWorker, Equals(true));
+		});
+
+		it("Rewinds scratch arenas after each task", [&]() {
+			TaskSystem scratchTasks{{.numWorkers = 1, .numIOWorkers = 0, .scratchSize = 1024}};
+
+			scratchTasks.PostMain([&scratchTasks]() {
+				AssertThat(scratchTasks.GetScratchArena().Allocate(100), Is().Not().Null());
+			});
+			scratchTasks.PumpMain();
+			AssertThat(scratchTasks.GetScratchArena().GetUsedSize(), Equals(0));
+
+			TaskFlow flow;
+			flow.emplace([&scratchTasks]() {
+				Memory::LinearArena& scratch = scratchTasks.GetScratchArena();
+				AssertThat(scratch.Allocate(600), Is().Not().Null());
+				AssertThat(scratch.Allocate(600), Is().Not().Null());
+			});
+			scratchTasks.RunFlow(flow).wait();
+
+			const TArray<ScratchStats> stats = scratchTasks.GetScratchStats();
+			AssertThat(stats.Size(), Equals(2));
+			AssertThat(stats[0].thread, Equals("Main"));
+			AssertThat(stats[0].peakSize, Equals(100));
+			AssertThat(stats[1].thread, Equals("Worker 1"));
+			AssertThat(stats[1].peakSize >= 1200, Equals(true));
+			// Grown blocks are merged into one
+			AssertThat(stats[1].capacity, Equals(stats[1].peakSize));
+		});
+
+		it("Starts queued worker tasks by priority", [&]() {
+			TaskSystem laneTasks{{.numWorkers = 1, .numIOWorkers = 0}};
+
+			// Keep the only worker busy while tasks are queued
+			std::promise<void> release;
+			std::shared_future<void> released = release.get_future().share();
+			laneTasks.RunAsync([released]() {
+				released.wait();
+			});
+			while (laneTasks.GetLaneStats(TaskPriority::Normal).numRun == 0)
+			{
+				std::this_thread::yield();
+			}
+
+			std::mutex orderMutex;
+			TArray<i32> order;
+			std::latch finished{3};
+			const auto record = [&order, &orderMutex, &finished](i32 value) {
+				return [&order, &orderMutex, &finished, value]() {
+					{
+						std::unique_lock<std::mutex> lock{orderMutex};
+						order.Add(value);
+					}
+					finished.count_down();
+				};
+			};
+			laneTasks.RunAsync(record(2), TaskPriority::Low);
+			laneTasks.RunAsync(record(1), TaskPriority::Normal);
+			laneTasks.RunAsync(record(0), TaskPriority::High);
+			AssertThat(laneTasks.GetLaneStats(TaskPriority::Low).queueDepth, Equals(1u));
+			AssertThat(laneTasks.ShouldYield(TaskPriority::Normal), Equals(true));
+			AssertThat(laneTasks.ShouldYield(TaskPriority::High), Equals(false));
+
+			release.set_value();
+			finished.wait();
+			AssertThat(order.Size(), Equals(3));
+			for (i32 i = 0; i < order.Size(); ++i)
+			{
+				AssertThat(order[i], Equals(i));
+			}
+
+			const TaskLaneStats high = laneTasks.GetLaneStats(TaskPriority::High);
+			AssertThat(high.numRun, Equals(1u));
+			AssertThat(high.queueDepth, Equals(0u));
+			AssertThat(high.p99Wait >= high.averageWait, Equals(true));
+			AssertThat(high.maxWait >= high.averageWait, Equals(true));
+		});
+
+		it("Collects task stats", [&]() {
+			TaskSystem statsTasks{{.numWorkers = 2, .numIOWorkers = 0}};
+
+			TaskFlow flow;
+			Task sleep = flow.emplace([]() {
+				std::this_thread::sleep_for(Chrono::milliseconds(2));
+			});
+			sleep.name("Sleep");
+			flow.emplace([]() {});
+			statsTasks.RunFlow(flow).wait();
+			statsTasks.RunFlow(flow).wait();
+
+			std::promise<void> ran;
+			statsTasks.RunAsync([&ran]() {
+				ran.set_value();
+			});
+			ran.get_future().wait();
+
+			statsTasks.PostMain([]() {});
+			statsTasks.PumpMain();
+
+			const TaskSystemStats stats = statsTasks.GetStats();
+			AssertThat(stats.threads.Size(), Equals(3));
+			AssertThat(stats.threads[0].thread, Equals("Main"));
+			AssertThat(stats.threads[0].numTasks, Equals(1u));
+			u64 workerTasks = 0;
+			Chrono::microseconds workerBusy{0};
+			for (i32 i = 1; i < stats.threads.Size(); ++i)
+			{
+				workerTasks += stats.threads[i].numTasks;
+				workerBusy += stats.threads[i].busy;
+				AssertThat(stats.threads[i].busy + stats.threads[i].idle <= stats.uptime,
+				    Equals(true));
+			}
+			AssertThat(workerTasks >= 4u, Equals(true));
+			AssertThat(workerBusy >= Chrono::milliseconds(4), Equals(true));
+
+			const TaskDurationStats* sleepStats = stats.namedTasks.Find("Sleep");
+			AssertThat(sleepStats != nullptr, Equals(true));
+			AssertThat(sleepStats->count, Equals(2u));
+			AssertThat(sleepStats->min >= Chrono::milliseconds(2), Equals(true));
+			AssertThat(sleepStats->total >= sleepStats->min + sleepStats->max, Equals(true));
+
+			const TaskLaneStats& normal = stats.lanes[u8(TaskPriority::Normal)];
+			AssertThat(normal.numRun, Equals(1u));
+			AssertThat(normal.waitHistogram.IsEmpty(), Equals(false));
+
+			const Path statsFile =
+			    std::filesystem::temp_directory_path() / "RiftTasksTest" / "stats.json";
+			FileSystem::CreateFolder(statsFile.parent_path(), true);
+			AssertThat(statsTasks.SaveStats(statsFile), Equals(true));
+			Json json;
+			AssertThat(FileSystem::LoadJsonFile(statsFile, json), Equals(true));
+			AssertThat(json["namedTasks"]["Sleep"]["count"].get<u64>(), Equals(2u));
+			AssertThat(json["threads"].size(), Equals(3u));
+		});
+
+		it("Dispatches closures", [&]() {
+			std::atomic<i32> sum{0};
+			TArray<i32> runs(100, 0);
+			tasks.Dispatch(runs.Size(), [&sum, &runs](i32 i) {
+				++runs[i];
+				sum += i;
+			});
+			AssertThat(sum.load(), Equals(4950));
+			for (i32 i = 0; i < runs.Size(); ++i)
+			{
+				AssertThat(runs[i], Equals(1));
+			}
+
+			i32 calls = 0;
+			tasks.Dispatch(0, [&calls](i32) {
+				++calls;
+			});
+			AssertThat(calls, Equals(0));
+		});
+
+		it("Reuses cached graphs", [&]() {
+			struct Params
+			{
+				i32 value             = 0;
+				std::atomic<i32>* sum = nullptr;
+			};
+			i32 builds = 0;
+			const auto build = [&builds](TaskFlow& flow, const Params& params) {
+				++builds;
+				for (i32 i = 0; i < 4; ++i)
+				{
+					flow.emplace([&params]() {
+						*params.sum += params.value;
+					});
+				}
+			};
+
+			std::atomic<i32> sum{0};
+			TTaskGraph<Params>& graph = tasks.GetGraph<Params>("TestGraph"_name, build);
+			graph.Run({1, &sum});
+			graph.Run({2, &sum}).wait();
+			AssertThat(sum.load(), Equals(12));
+
+			TTaskGraph<Params>& cached = tasks.GetGraph<Params>("TestGraph"_name, build);
+			AssertThat(&cached, Equals(&graph));
+			cached.Run({3, &sum}).wait();
+			AssertThat(sum.load(), Equals(24));
+			AssertThat(builds, Equals(1));
+
+			// Other Params get their own graph under the same id
+			struct OtherParams
+			{
+				i32 value = 0;
+			};
+			TTaskGraph<OtherParams>& other = tasks.GetGraph<OtherParams>(
+			    "TestGraph"_name, [](TaskFlow&, const OtherParams&) {});
+			AssertThat(static_cast<void*>(&other) != static_cast<void*>(&graph), Equals(true));
+			other.Run({}).wait();
+		});
+	});
+});
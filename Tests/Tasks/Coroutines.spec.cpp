@@ -0,0 +1,115 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Tasks/Coroutines.h>
+#include <bandit/bandit.h>
+
+#include <thread>
+
+
+using namespace snowhouse;
+using namespace bandit;
+using namespace Rift;
+
+
+go_bandit([]() {
+	describe("Tasks.Coroutines", []() {
+		static TaskSystem tasks;
+
+		it("Switches between workers and main", [&]() {
+			auto pipeline = []() -> TTask<i32> {
+				co_await ResumeOnWorkers(tasks);
+				const bool bOnWorker = tasks.IsWorkerThread();
+				const i32 parsed     = 20;
+
+				co_await ResumeOnMain(TaskPriority::High, tasks);
+				const bool bOnMain = tasks.IsMainThread();
+				co_return bOnWorker && bOnMain ? parsed + 1 : -1;
+			};
+			AssertThat(SyncWait(pipeline(), tasks), Equals(21));
+		});
+
+		it("Awaits nested tasks", [&]() {
+			auto inner = [](i32 value) -> TTask<i32> {
+				co_return value * 2;
+			};
+			auto outer = [&inner]() -> TTask<i32> {
+				const i32 a = co_await inner(2);
+				const i32 b = co_await inner(3);
+				co_return a + b;
+			};
+			AssertThat(SyncWait(outer(), tasks), Equals(10));
+		});
+
+		it("Waits for all tasks", [&]() {
+			auto square = [](i32 value) -> TTask<i32> {
+				co_await ResumeOnWorkers(tasks);
+				co_return value * value;
+			};
+			TArray<TTask<i32>> squares;
+			for (i32 i = 0; i < 8; ++i)
+			{
+				squares.Add(square(i));
+			}
+
+			const TArray<i32> results = SyncWait(WhenAll(Move(squares)), tasks);
+			AssertThat(results.Size(), Equals(8));
+			for (i32 i = 0; i < results.Size(); ++i)
+			{
+				AssertThat(results[i], Equals(i * i));
+			}
+		});
+
+		it("Waits for any task", [&]() {
+			auto wait = [](Chrono::milliseconds delay) -> TTask<i32> {
+				co_await Delay(delay, tasks);
+				co_return i32(delay.count());
+			};
+			TArray<TTask<i32>> waits;
+			waits.Add(wait(Chrono::milliseconds(200)));
+			waits.Add(wait(Chrono::milliseconds(1)));
+
+			const TAnyResult<i32> first = SyncWait(WhenAny(Move(waits)), tasks);
+			AssertThat(first.index, Equals(1));
+			AssertThat(first.value, Equals(1));
+		});
+
+		it("Delays without blocking the main thread", [&]() {
+			bool bPumped = false;
+			tasks.PostMain([&bPumped]() {
+				bPumped = true;
+			});
+
+			auto delayed = []() -> TTask<bool> {
+				const auto start = Chrono::steady_clock::now();
+				co_await Delay(Chrono::milliseconds(5), tasks);
+				co_return tasks.IsMainThread()
+				    && Chrono::steady_clock::now() - start >= Chrono::milliseconds(5);
+			};
+			AssertThat(SyncWait(delayed(), tasks), Equals(true));
+			AssertThat(bPumped, Equals(true));
+		});
+
+		it("Awaits futures and flows", [&]() {
+			auto run = []() -> TTask<i32> {
+				std::promise<i32> promise;
+				std::thread other{[&promise]() {
+					std::this_thread::sleep_for(Chrono::milliseconds(2));
+					promise.set_value(5);
+				}};
+				const i32 value = co_await AwaitFuture(promise.get_future(), tasks);
+				other.join();
+
+				i32 flowValue = 0;
+				TaskFlow flow;
+				flow.emplace([&flowValue]() {
+					flowValue += 3;
+				});
+				// Runs again once the first run is done
+				co_await AwaitFlow(flow, tasks);
+				co_await AwaitFlow(flow, tasks);
+				co_return value + flowValue;
+			};
+			AssertThat(SyncWait(run(), tasks), Equals(11));
+		});
+	});
+});
@@ -0,0 +1,110 @@
+// Copyright 2015-2021 Piperift - All rights reserved
+
+#include <Log/BinaryLog.h>
+#include <Serialization/Json.h>
+
+#include <chrono>
+#include <cstdio>
+
+
+using namespace Rift;
+
+
+// Prints binary log files as text, or as one JSON object per line:
+//   RiftLogDecoder <file> [--json]
+
+
+// Formats one message. Arguments that don't match their format, like a string formatted as a
+// pointer, print the error instead of stopping the decoder
+static String FormatMessage(const Log::BinaryLogMessage& message)
+{
+	try
+	{
+		return message.ToString();
+	}
+	catch (const fmt::format_error& error)
+	{
+		return CString::Format("<format error: {}> {}", error.what(), message.format);
+	}
+}
+
+static String ToText(const Log::BinaryLogMessage& message)
+{
+	using namespace std::chrono;
+	const sys_time<microseconds> time{duration_cast<microseconds>(nanoseconds{message.time})};
+	const i64 micros = time.time_since_epoch().count() % 1000000;
+
+	String text = CString::Format("[{:%Y-%m-%d %H:%M:%S}.{:06d}][{}][{}] ",
+	    floor<seconds>(time), micros, message.threadId, Log::GetLevelName(message.level));
+	if (!message.category.empty())
+	{
+		CString::FormatTo(text, "[{}] ", message.category);
+	}
+	text += FormatMessage(message);
+	return text;
+}
+
+static String ToJson(const Log::BinaryLogMessage& message)
+{
+	Json args = Json::array();
+	const u8* in = message.args;
+	for (u8 i = 0; i < message.numArgs; ++i)
+	{
+		in = Log::LogArgs::Decode(in, [&args](auto value) {
+			using Type = decltype(value);
+			if constexpr (std::is_same_v<Type, StringView>)
+			{
+				args.push_back(String{value});
+			}
+			else if constexpr (std::is_same_v<Type, TCHAR>)
+			{
+				args.push_back(String(1, value));
+			}
+			else if constexpr (std::is_same_v<Type, const void*>)
+			{
+				args.push_back(u64(reinterpret_cast<uintptr_t>(value)));
+			}
+			else
+			{
+				args.push_back(value);
+			}
+		});
+	}
+
+	Json json;
+	json["time"]     = message.time;
+	json["thread"]   = message.threadId;
+	json["level"]    = String{GetLevelName(message.level)};
+	json["category"] = String{message.category};
+	json["format"]   = String{message.format};
+	json["args"]     = Move(args);
+	json["message"]  = FormatMessage(message);
+	return json.dump();
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::fprintf(stderr, "Usage: RiftLogDecoder <file> [--json]\n");
+		return 1;
+	}
+
+	Log::BinaryLogReader reader;
+	if (!reader.Open(argv[1]))
+	{
+		std::fprintf(stderr, "'%s' is not a binary log file\n", argv[1]);
+		return 1;
+	}
+
+	const bool bJson = argc > 2 && StringView{argv[2]} == "--json";
+	Log::BinaryLogMessage message;
+	while (reader.Next(message))
+	{
+		const String line = bJson ? ToJson(message) : ToText(message);
+		std::fwrite(line.data(), 1, line.size(), stdout);
+		std::fputc('\n', stdout);
+	}
+	return 0;
+}